@@ -0,0 +1,380 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <4ds/parser_4ds.hpp>
+#include <4ds/parser_baked4ds.hpp>
+#include <4ds/morph.hpp>
+#include <4ds/skin.hpp>
+#include <utils/logger.hpp>
+#include <vfs/vfs.hpp>
+#include <utils/openmf.hpp>
+#include <cxxopts.hpp>
+
+#define MODEL_4DS_MODULE_STR "4ds"
+
+void dump(MFFormat::DataFormat4DS &model)
+{
+    const auto &m = model.getModel();
+
+    std::cout << "version: " << m.mFormatVersion << std::endl;
+    std::cout << "materials: " << m.mMaterialCount << std::endl;
+    std::cout << "meshes: " << m.mMeshCount << std::endl;
+
+    for (auto& mesh : m.mMeshes)
+    {
+        size_t vertices = 0, faces = 0;
+
+        const MFFormat::DataFormat4DS::Standard *standard = m.getStandard(mesh);
+
+        if (standard && standard->mLODs.size() > 0)
+        {
+            vertices = standard->mLODs[0].mVertexCount;
+
+            for (auto& faceGroup : standard->mLODs[0].mFaceGroups)
+                faces += faceGroup.mFaceCount;
+        }
+
+        std::cout << "  " << m.getString(mesh.mMeshName) << ": type " << (int) mesh.mMeshType << ", visual type " << (int) mesh.mVisualMeshType <<
+            ", parent " << mesh.mParentID << ", " << vertices << " vertices, " << faces << " faces" << std::endl;
+    }
+}
+
+/**
+  Parses all 4ds files found in given directory (recursively) given number of times and reports
+  the throughput. The files are read into memory beforehand, so only the parsing is measured. The
+  same is then done with the files baked.
+*/
+
+int benchmark(std::string directory, unsigned int rounds)
+{
+    std::vector<std::vector<char>> files;
+    std::vector<std::string> names;
+    size_t totalSize = 0;
+    std::error_code error;
+
+    for (auto& entry : std::filesystem::recursive_directory_iterator(directory,error))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(),extension.end(),extension.begin(),::tolower);
+
+        if (!entry.is_regular_file(error) || extension != ".4ds")
+            continue;
+
+        std::ifstream f(entry.path(),std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(f)),std::istreambuf_iterator<char>());
+        totalSize += data.size();
+        files.push_back(std::move(data));
+        names.push_back(entry.path().string());
+    }
+
+    if (files.size() == 0)
+    {
+        MFLogger::Logger::fatal("No 4ds files found in " + directory + ".",MODEL_4DS_MODULE_STR);
+        return 1;
+    }
+
+    unsigned int failed = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            MFFormat::DataFormat4DS model;
+
+            if (!model.load(files[i].data(),files[i].size()) && r == 0)
+            {
+                MFLogger::Logger::warn("Could not parse " + names[i] + ": " + model.getErrorStr() + ".",MODEL_4DS_MODULE_STR);
+                failed++;
+            }
+        }
+
+    double parseSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    double megabytes = totalSize * rounds / (1024.0 * 1024.0);
+
+    std::cout << "parsed " << files.size() << " files (" << MFUtil::doubleToStr(totalSize / (1024.0 * 1024.0)) << " MB) " << rounds <<
+        " times in " << MFUtil::doubleToStr(parseSeconds) << " s: " << MFUtil::doubleToStr(megabytes / parseSeconds) << " MB/s, " <<
+        failed << " failed" << std::endl;
+
+    std::vector<std::vector<char>> bakes;
+    size_t totalBakedSize = 0;
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        MFFormat::DataFormat4DS model;
+        MFFormat::DataFormatBaked4DS baked;
+        MFFormat::DataFormatBaked4DS::Source source = {};
+
+        model.load(files[i].data(),files[i].size());
+        baked.bake(model.getModel(),source);
+
+        bakes.push_back(std::vector<char>(baked.getData(),baked.getData() + baked.getSize()));
+        totalBakedSize += baked.getSize();
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < bakes.size(); ++i)
+        {
+            MFFormat::DataFormatBaked4DS baked;
+
+            if (!baked.load(bakes[i].data(),bakes[i].size()) && r == 0)
+            {
+                MFLogger::Logger::warn("Could not load bake of " + names[i] + ": " + baked.getErrorStr() + ".",MODEL_4DS_MODULE_STR);
+                failed++;
+            }
+        }
+
+    double bakeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "loaded the bakes (" << MFUtil::doubleToStr(totalBakedSize / (1024.0 * 1024.0)) << " MB) " << rounds <<
+        " times in " << MFUtil::doubleToStr(bakeSeconds) << " s: " << MFUtil::doubleToStr(files.size() * rounds / bakeSeconds) <<
+        " models/s, parsing: " << MFUtil::doubleToStr(files.size() * rounds / parseSeconds) << " models/s" << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+  Plays all morphs of a model on given number of copies of the model (each has its own vertex
+  arrays) for a number of frames and reports the time needed to deform them.
+*/
+
+int benchmarkMorphs(const MFFormat::DataFormat4DS &model, unsigned int copies, unsigned int frames)
+{
+    MFFormat::DataFormatBaked4DS baked;
+    MFFormat::DataFormatBaked4DS::Source source = {};
+    baked.bake(model.getModel(),source);
+
+    const MFFormat::DataFormatBaked4DS::Morph *morphs = baked.getMorphs();
+    const uint32_t morphCount = baked.getHeader().mSections[MFFormat::DataFormatBaked4DS::SECTION_MORPHS].mCount;
+
+    if (morphCount == 0)
+    {
+        MFLogger::Logger::fatal("The model has no morphs.",MODEL_4DS_MODULE_STR);
+        return 1;
+    }
+
+    std::vector<std::vector<MFMath::Vec3>> positions, normals;
+    MFFormat::MorphBatch batch;
+    size_t morphedVertices = 0;
+
+    positions.reserve(copies * morphCount);
+    normals.reserve(copies * morphCount);
+
+    for (unsigned int c = 0; c < copies; ++c)
+        for (uint32_t i = 0; i < morphCount; ++i)
+        {
+            const MFFormat::DataFormatBaked4DS::Lod &lod = baked.getLods()[morphs[i].mLod];
+
+            positions.push_back(std::vector<MFMath::Vec3>(baked.getPositions() + lod.mFirstVertex,baked.getPositions() + lod.mFirstVertex + lod.mVertexCount));
+            normals.push_back(std::vector<MFMath::Vec3>(baked.getNormals() + lod.mFirstVertex,baked.getNormals() + lod.mFirstVertex + lod.mVertexCount));
+
+            MFFormat::MorphBatch::Target target;
+            target.mFrameCount = morphs[i].mFrameCount;
+            target.mVertexCount = morphs[i].mVertexCount;
+            target.mPositions = &baked.getMorphPositions()[morphs[i].mFirstTarget].x;
+            target.mNormals = &baked.getMorphNormals()[morphs[i].mFirstTarget].x;
+            target.mLinks = baked.getMorphLinks() + morphs[i].mFirstLink;
+
+            batch.play(target,&positions.back()[0].x,&normals.back()[0].x,1.0f + c * 0.01f);
+            morphedVertices += morphs[i].mVertexCount;
+        }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int f = 0; f < frames; ++f)
+    {
+        batch.advance(1.0f / 60.0f);
+
+        for (size_t i = 0; i < batch.getNumInstances(); ++i)
+            batch.apply(i);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "deformed " << batch.getNumInstances() << " morphed meshes (" << morphedVertices << " vertices) " << frames <<
+        " times in " << MFUtil::doubleToStr(seconds) << " s: " << MFUtil::doubleToStr(seconds * 1000.0 / frames) << " ms per frame, " <<
+        MFUtil::doubleToStr(morphedVertices * frames / seconds / 1000000.0) << " M vertices/s" << std::endl;
+
+    return 0;
+}
+
+/**
+  Skins all single meshes of a model on given number of copies of the model with a changing palette
+  for a number of frames, using given number of threads, and reports the time needed.
+*/
+
+int benchmarkSkinning(const MFFormat::DataFormat4DS &model, unsigned int copies, unsigned int frames, unsigned int threads)
+{
+    MFFormat::DataFormatBaked4DS baked;
+    MFFormat::DataFormatBaked4DS::Source source = {};
+    baked.bake(model.getModel(),source);
+
+    const MFFormat::DataFormatBaked4DS::Skin *skins = baked.getSkins();
+    const uint32_t skinCount = baked.getHeader().mSections[MFFormat::DataFormatBaked4DS::SECTION_SKINS].mCount;
+
+    if (skinCount == 0)
+    {
+        MFLogger::Logger::fatal("The model has no single meshes.",MODEL_4DS_MODULE_STR);
+        return 1;
+    }
+
+    std::vector<std::vector<MFMath::Vec3>> positions, normals;
+    std::vector<std::vector<MFFormat::SkinBatch::Influence>> influences(skinCount);
+    std::vector<uint32_t> indices;
+    MFFormat::SkinBatch batch;
+    batch.setNumThreads(threads);
+    size_t skinnedVertices = 0;
+
+    for (uint32_t i = 0; i < skinCount; ++i)
+    {
+        const MFFormat::DataFormatBaked4DS::Lod &lod = baked.getLods()[skins[i].mLod];
+
+        for (uint32_t j = 0; j < lod.mVertexCount - skins[i].mFirstSkinnedVertex; ++j)
+        {
+            const MFFormat::DataFormatBaked4DS::SkinInfluence &influence = baked.getSkinInfluences()[skins[i].mFirstInfluence + j];
+            influences[i].push_back(MFFormat::SkinBatch::Influence {{influence.mJoints[0],influence.mJoints[1]},influence.mWeight});
+        }
+    }
+
+    positions.reserve(copies * skinCount);
+    normals.reserve(copies * skinCount);
+
+    for (unsigned int c = 0; c < copies; ++c)
+        for (uint32_t i = 0; i < skinCount; ++i)
+        {
+            const MFFormat::DataFormatBaked4DS::Lod &lod = baked.getLods()[skins[i].mLod];
+            const uint32_t first = lod.mFirstVertex + skins[i].mFirstSkinnedVertex;
+
+            positions.push_back(std::vector<MFMath::Vec3>(lod.mVertexCount - skins[i].mFirstSkinnedVertex));
+            normals.push_back(std::vector<MFMath::Vec3>(positions.back().size()));
+
+            MFFormat::SkinBatch::Skin skin;
+            skin.mVertexCount = influences[i].size();
+            skin.mJointCount = skins[i].mJointCount;
+            skin.mPositions = &baked.getPositions()[first].x;
+            skin.mNormals = &baked.getNormals()[first].x;
+            skin.mInfluences = influences[i].data();
+
+            indices.push_back(batch.getNumInstances());
+            batch.add(skin,&positions.back()[0].x,&normals.back()[0].x);
+            skinnedVertices += skin.mVertexCount;
+        }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int f = 0; f < frames; ++f)
+    {
+        for (size_t i = 0; i < batch.getNumInstances(); ++i)   // some rotation around Z and a translation
+        {
+            float *palette = batch.getPalette(i);
+            float angle = f * 0.01f + i * 0.1f;
+
+            for (uint32_t j = 0; j < skins[i % skinCount].mJointCount; ++j)
+            {
+                float *m = palette + j * 16;
+                m[0] = std::cos(angle + j); m[1] = std::sin(angle + j);
+                m[4] = -m[1]; m[5] = m[0];
+                m[12] = j * 0.1f;
+            }
+        }
+
+        batch.skin(indices);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "skinned " << batch.getNumInstances() << " meshes (" << skinnedVertices << " vertices) " << frames <<
+        " times in " << MFUtil::doubleToStr(seconds) << " s using " << threads << " threads: " << MFUtil::doubleToStr(seconds * 1000.0 / frames) <<
+        " ms per frame, " << MFUtil::doubleToStr(skinnedVertices * frames / seconds / 1000000.0) << " M vertices/s" << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("4ds","CLI utility for Mafia 4ds format.");
+
+    options.add_options()
+        ("h,help","Display help and exit.")
+        ("b,benchmark","Parse all 4ds files in given directory and report the speed.",cxxopts::value<std::string>())
+        ("r,rounds","Number of rounds for -b, frames for -m and -s.",cxxopts::value<unsigned int>())
+        ("k,bake","Bake the input file into given file.",cxxopts::value<std::string>())
+        ("m,morph","Deform the morphs of the input file on given number of model copies and report the speed.",cxxopts::value<unsigned int>())
+        ("s,skin","Skin the single meshes of the input file on given number of model copies and report the speed.",cxxopts::value<unsigned int>())
+        ("t,threads","Number of threads for -s.",cxxopts::value<unsigned int>())
+        ("i,input","Specify input file name.",cxxopts::value<std::string>());
+
+    options.parse_positional({"i"});
+    options.positional_help("file");
+    auto arguments = options.parse(argc,argv);
+
+    if (arguments.count("h") > 0)
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    if (arguments.count("b") > 0)
+        return benchmark(arguments["b"].as<std::string>(),arguments.count("r") > 0 ? arguments["r"].as<unsigned int>() : 10);
+
+    if (arguments.count("i") < 1)
+    {
+        MFLogger::Logger::fatal("Expected file.",MODEL_4DS_MODULE_STR);
+        std::cout << options.help() << std::endl;
+        return 1;
+    }
+
+    std::string inputFile = arguments["i"].as<std::string>();
+
+    auto fs = MFFile::FileSystem::getInstance();
+    std::vector<char> storage;
+    const char *data;
+    size_t size;
+
+    if (!fs->read(inputFile,data,size,storage))
+    {
+        MFLogger::Logger::fatal("Could not open file " + inputFile + ".",MODEL_4DS_MODULE_STR);
+        return 1;
+    }
+
+    MFFormat::DataFormat4DS model;
+
+    if (!model.load(data,size))
+    {
+        MFLogger::Logger::fatal("Could not parse file " + inputFile + ": " + model.getErrorStr() + ".",MODEL_4DS_MODULE_STR);
+        return 1;
+    }
+
+    if (arguments.count("m") > 0)
+        return benchmarkMorphs(model,arguments["m"].as<unsigned int>(),arguments.count("r") > 0 ? arguments["r"].as<unsigned int>() : 1000);
+
+    if (arguments.count("s") > 0)
+        return benchmarkSkinning(model,arguments["s"].as<unsigned int>(),arguments.count("r") > 0 ? arguments["r"].as<unsigned int>() : 1000,
+            arguments.count("t") > 0 ? arguments["t"].as<unsigned int>() : 1);
+
+    if (arguments.count("k") > 0)
+    {
+        std::string outputFile = arguments["k"].as<std::string>();
+        MFFormat::DataFormatBaked4DS baked;
+        MFFormat::DataFormatBaked4DS::Source source;
+
+        source.mTimeStamp = fs->getTimeStamp(inputFile);
+        source.mSize = size;
+        source.mHash = MFFormat::DataFormatBaked4DS::hash(data,size);
+
+        if (!baked.bake(model.getModel(),source) || !baked.save(outputFile))
+        {
+            MFLogger::Logger::fatal("Could not bake file " + inputFile + " into " + outputFile + ".",MODEL_4DS_MODULE_STR);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    dump(model);
+    return 0;
+}
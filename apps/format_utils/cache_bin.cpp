@@ -14,7 +14,7 @@ void dump(MFFormat::DataFormatCacheBIN cacheBin)
     std::cout << "{\n";
     dumpValue("numberOfObjects", std::to_string(cacheBin.getNumObjects()), 1);
     std::cout << "    \"objects\": [" << std::endl;
-    for (auto object : cacheBin.getObjects())
+    for (const auto &object : cacheBin.getObjects())
     {
         std::cout << "        {\n";
         dumpValue("objectName", object.mObjectName, 3);
@@ -22,7 +22,7 @@ void dump(MFFormat::DataFormatCacheBIN cacheBin)
         dumpValue("numberOfInstances", std::to_string(object.mInstances.size()), 3, false);
         std::cout << "            \"instances\": [" << std::endl;
 
-        for (auto instance : object.mInstances)
+        for (const auto &instance : object.mInstances)
         {
             std::cout << "                {\n";
             dumpValue("modelName", instance.mModelName, 5);
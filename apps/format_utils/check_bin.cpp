@@ -45,12 +45,12 @@ void dump(MFFormat::DataFormatCheckBIN checkBin)
     uint32_t linkIter = 0;
     for (std::size_t i = 0; i != checkBin.getNumPoints(); ++i)
     {
-        auto point = checkBin.getPoints()[i];
+        const auto &point = checkBin.getPoints()[i];
         MFLogger::Logger::raw("[P" + std::to_string(i) + "][" + getStringPointType(point.mType) + "] " + std::to_string(point.mPos.x) + " " + std::to_string(point.mPos.y) + " " + std::to_string(point.mPos.z), "dump");
         for (uint32_t j = 0; j < point.mEnterLinks; j++)
         {
-            auto link = checkBin.getLinks()[linkIter+j];
-            auto targetPoint = checkBin.getPoints()[link.mTargetPoint];
+            const auto &link = checkBin.getLinks()[linkIter+j];
+            const auto &targetPoint = checkBin.getPoints()[link.mTargetPoint];
             MFLogger::Logger::raw("[P" + std::to_string(i) + "] Link to [P" + std::to_string(link.mTargetPoint) + "][" + getStringPointType(targetPoint.mType) + "] " + std::to_string(targetPoint.mPos.x) + " " + std::to_string(targetPoint.mPos.y) + " " + std::to_string(point.mPos.z), "dump");
         }
         linkIter += point.mEnterLinks;
@@ -6,6 +6,10 @@
 #include <utils/logger.hpp>
 #include <cxxopts.hpp>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
 #include <utils/os_defines.hpp>
 #include <vfs/vfs.hpp>
 
@@ -23,8 +27,8 @@ void dump(MFFormat::DataFormatDTA &dta, bool displaySize, bool verbose)
     std::cout << "number of files: " << dta.getNumFiles() << std::endl;
     std::cout << "file list:" << std::endl;
 
-    std::vector<MFFormat::DataFormatDTA::FileTableRecord> ftr = dta.getFileTableRecords();
-    std::vector<MFFormat::DataFormatDTA::DataFileHeader> dfh = dta.getDataFileHeaders();
+    const std::vector<MFFormat::DataFormatDTA::FileTableRecord> &ftr = dta.getFileTableRecords();
+    const std::vector<MFFormat::DataFormatDTA::DataFileHeader> &dfh = dta.getDataFileHeaders();
 
     for (int i = 0; i < (int) dta.getNumFiles(); ++i)
     {
@@ -44,48 +48,252 @@ void dump(MFFormat::DataFormatDTA &dta, bool displaySize, bool verbose)
     }
 }
 
-bool extract(MFFormat::DataFormatDTA &dta, std::ifstream &DTAStream, std::string DTAFile, std::string outFile, std::string pathPrefix)
+/// Messages of one extracted file, kept so that extractAll(...) can print them once its threads are done.
+typedef struct
 {
+    std::string mInfo;
+    std::string mError;                    // empty if the file has been extracted
+} ExtractLog;
+
+void printLog(const ExtractLog &log)
+{
+    MFLogger::Logger::info(log.mInfo, DTA_MODULE_STR);
+
+    if (log.mError.length() > 0)
+        MFLogger::Logger::fatal(log.mError, DTA_MODULE_STR);
+}
+
+bool extract(const MFFormat::DataFormatDTA &dta, const MFUtil::MappedFile &archive, int fileIndex, std::string outFile, std::string pathPrefix, ExtractLog &log)
+{
+    std::string DTAFile = dta.getFileName(fileIndex);
+
     if (pathPrefix.length() > 0 && pathPrefix.end()[0] != ZPL_PATH_SEPARATOR)
         pathPrefix += ZPL_PATH_SEPARATOR;
 
-    outFile = pathPrefix + outFile;
+    std::replace(outFile.begin(), outFile.end(), '\\', '/');
+    std::filesystem::path outPath = std::filesystem::path(pathPrefix + outFile).lexically_normal();
 
-    // TODO: Improve this
-    #ifdef OMF_SYSTEM_WINDOWS
-        char const *baseName = zpl_path_base_name(outFile.c_str());
-        system(std::string("mkdir \"" + std::string(baseName) + "\" && copy /y nul \"" + outFile + "\"").c_str());
-    #else
-        outFile = "./" + outFile;
-        std::replace(outFile.begin(), outFile.end(), '\\', '/');
-        system(std::string("mkdir -p \"$(dirname \"" + outFile + "\")\" && touch \"" + outFile + "\"").c_str());
-    #endif
+    std::error_code error;
 
-    MFLogger::Logger::info("Extracting " + DTAFile + " to " + outFile + ".", DTA_MODULE_STR);
+    if (outPath.has_parent_path())
+        std::filesystem::create_directories(outPath.parent_path(),error);   // fails harmlessly if another thread has created it
 
-    int fileIndex = dta.getFileIndex(DTAFile);
+    log.mInfo = "Extracting " + DTAFile + " to " + outPath.string() + ".";
 
-    if (fileIndex < 0)
+    std::ofstream f;
+    f.open(outPath, std::ios::binary);
+
+    if (!f.is_open())
     {
-        MFLogger::Logger::fatal("File " + DTAFile + " not found.", DTA_MODULE_STR);
+        log.mError = "Could not open file " + outPath.string() + ".";
         return false;
     }
 
-    std::ofstream f;
-    f.open(outFile, std::ios::binary);
+    unsigned int size = dta.getFileSize(fileIndex);
+    const char *view = dta.getFileView(archive,fileIndex);
 
-    if (!f.is_open())
+    if (view)
     {
-        MFLogger::Logger::fatal("Could not open file " + outFile + ".", DTA_MODULE_STR);
-        return false;
+        f.write(view,size);
     }
+    else
+    {
+        std::vector<char> buffer(size);
 
+        if (!dta.getFile(archive,fileIndex,buffer.data()))
+        {
+            log.mError = "Corrupt data in " + DTAFile + ".";
+            return false;
+        }
 
-    auto buffer = dta.getFile(DTAStream,fileIndex);
+        f.write(buffer.data(),size);
+    }
 
-    f.write(buffer,buffer.size());
     f.close();
-    return true;
+
+    if (!f.good())
+        log.mError = "Could not write file " + outPath.string() + ".";
+
+    return f.good();
+}
+
+bool extractAll(const MFFormat::DataFormatDTA &dta, const MFUtil::MappedFile &archive, std::string pathPrefix, unsigned int jobs)
+{
+    std::atomic<unsigned int> nextFile(0);
+    std::atomic<unsigned int> failed(0);
+    std::atomic<uint64_t> totalSize(0);
+
+    unsigned int numFiles = dta.getNumFiles();
+    std::vector<ExtractLog> logs(numFiles);    // the logger isn't thread safe, the workers don't print
+
+    auto worker = [&]()
+    {
+        for (unsigned int i = nextFile++; i < numFiles; i = nextFile++)
+        {
+            if (extract(dta,archive,i,MFUtil::strToLower(dta.getFileName(i)),pathPrefix,logs[i]))
+                totalSize += dta.getFileSize(i);
+            else
+                failed++;
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < jobs; ++i)
+        threads.push_back(std::thread(worker));
+
+    for (auto& thread : threads)
+        thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    double megabytes = totalSize / (1024.0 * 1024.0);
+
+    for (const auto& log : logs)
+        printLog(log);
+
+    std::cout << "extracted " << (numFiles - failed) << " files (" << MFUtil::doubleToStr(megabytes) << " MB) in " <<
+        MFUtil::doubleToStr(seconds,3) << " s using " << jobs << " threads: " <<
+        MFUtil::doubleToStr((numFiles - failed) / seconds) << " files/s, " << MFUtil::doubleToStr(megabytes / seconds) << " MB/s" << std::endl;
+
+    if (failed > 0)
+        MFLogger::Logger::fatal("Failed to extract " + std::to_string(failed) + " files.", DTA_MODULE_STR);
+
+    return failed == 0;
+}
+
+void benchmarkLZSS(MFFormat::DataFormatDTA &dta, std::ifstream &DTAStream, unsigned int rounds)
+{
+    const std::vector<MFFormat::DataFormatDTA::FileTableRecord> &ftr = dta.getFileTableRecords();
+    const std::vector<MFFormat::DataFormatDTA::DataFileHeader> &dfh = dta.getDataFileHeaders();
+    std::vector<std::vector<unsigned char>> blocks;
+
+    for (int i = 0; i < (int) dta.getNumFiles(); ++i)     // collect all decrypted LZSS blocks
+    {
+        DTAStream.clear();
+        DTAStream.seekg(ftr[i].mDataOffset);
+
+        for (uint32_t j = 0; j < dfh[i].mCompressedBlockCount; ++j)
+        {
+            uint32_t blockSize;
+            DTAStream.read((char *) &blockSize,sizeof(blockSize));
+            blockSize = blockSize & 0xffff;
+
+            std::vector<unsigned char> block(blockSize);
+            DTAStream.read((char *) block.data(),blockSize);
+
+            if (dfh[i].mFlags[0] & 0x80)
+                dta.decrypt((char *) block.data(),blockSize);
+
+            if (blockSize > 1 && block[0] == MFFormat::DataFormatDTA::BLOCK_LZSS_RLE)
+                blocks.push_back(std::vector<unsigned char>(block.begin() + 1,block.end()));
+        }
+    }
+
+    std::vector<std::vector<unsigned char>> reference;
+    size_t totalSize = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int r = 0; r < rounds; ++r)
+    {
+        reference.clear();
+
+        for (auto& block : blocks)
+            reference.push_back(dta.decompressLZSS(block.data(),block.size()));
+    }
+
+    double referenceTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    for (auto& decompressed : reference)
+        totalSize += decompressed.size();
+
+    std::vector<unsigned char> output(totalSize);
+    bool match = true;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int r = 0; r < rounds; ++r)
+    {
+        size_t position = 0;
+
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            int written = MFFormat::DataFormatDTA::decompressLZSS(blocks[i].data(),blocks[i].size(),output.data() + position,reference[i].size());
+            match = match && written == (int) reference[i].size();
+            position += reference[i].size();
+        }
+    }
+
+    double kernelTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    size_t position = 0;
+
+    for (auto& decompressed : reference)
+    {
+        match = match && std::equal(decompressed.begin(),decompressed.end(),output.begin() + position);
+        position += decompressed.size();
+    }
+
+    double megabytes = totalSize * rounds / (1024.0 * 1024.0);
+
+    std::cout << "LZSS blocks: " << blocks.size() << ", decompressed size: " << totalSize << " B, rounds: " << rounds << std::endl;
+    std::cout << std::setw(ALIGN) << std::left << "vector (reference):" << MFUtil::doubleToStr(megabytes / referenceTime) << " MB/s" << std::endl;
+    std::cout << std::setw(ALIGN) << std::left << "preallocated buffer:" << MFUtil::doubleToStr(megabytes / kernelTime) << " MB/s" << std::endl;
+    std::cout << "outputs " << (match ? "match" : "DIFFER") << std::endl;
+}
+
+void benchmarkThreads(const MFFormat::DataFormatDTA &dta, const MFUtil::MappedFile &archive, unsigned int maxThreads)
+{
+    unsigned int numFiles = dta.getNumFiles();
+    unsigned int rounds = maxThreads;             // the same amount of work for every thread count
+    unsigned int maxFileSize = 0;
+    uint64_t totalSize = 0;
+
+    for (unsigned int i = 0; i < numFiles; ++i)
+    {
+        maxFileSize = std::max(maxFileSize,dta.getFileSize(i));
+        totalSize += dta.getFileSize(i);
+    }
+
+    double megabytes = totalSize * rounds / (1024.0 * 1024.0);
+    double singleThreadTime = 0;
+
+    std::cout << "decoding all " << numFiles << " files " << rounds << " times from one shared archive object" << std::endl;
+
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount = threadCount < maxThreads ? std::min(threadCount * 2,maxThreads) : maxThreads + 1)
+    {
+        std::atomic<unsigned int> nextItem(0);
+        std::atomic<bool> success(true);
+
+        auto worker = [&]()
+        {
+            std::vector<char> buffer(maxFileSize);
+
+            for (unsigned int item = nextItem++; item < numFiles * rounds; item = nextItem++)
+                if (!dta.getFile(archive,item % numFiles,buffer.data()))
+                    success = false;
+        };
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<std::thread> threads;
+
+        for (unsigned int i = 0; i < threadCount; ++i)
+            threads.push_back(std::thread(worker));
+
+        for (auto& thread : threads)
+            thread.join();
+
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        if (threadCount == 1)
+            singleThreadTime = seconds;
+
+        std::cout << std::setw(3) << std::right << threadCount << " threads: " << std::setw(10) << MFUtil::doubleToStr(megabytes / seconds) <<
+            " MB/s, speedup " << MFUtil::doubleToStr(singleThreadTime / seconds) << (success ? "" : " (CORRUPT DATA)") << std::endl;
+    }
 }
 
 int main(int argc, char** argv)
@@ -101,9 +309,12 @@ int main(int argc, char** argv)
         ("h,help","Display help and exit.")
         ("d,decrypt","Decrypt whole input file with corresponding keys, mostly for debugging. See also -S.")
         ("S,shift-keys","Shift decrypting keys by given number of bytes. Has only effect with -d.",cxxopts::value<int>())
-        ("e,extract","Extract given file.",cxxopts::value<std::string>())
+        ("e,extract","Extract given file, can be repeated.",cxxopts::value<std::vector<std::string>>())
         ("E,extract-all","Extract all files from specified DTA file.")
-        ("o,output","Specify output file (for -e) or directory (for -E).",cxxopts::value<std::string>())
+        ("b,benchmark","Benchmark LZSS decompression on all blocks of the file, optionally give number of rounds.",cxxopts::value<unsigned int>()->implicit_value("10"))
+        ("j,jobs","Number of threads for -E and -T, all CPU cores by default.",cxxopts::value<unsigned int>())
+        ("T,thread-scaling","Measure how decoding of all files scales with the number of threads.")
+        ("o,output","Specify output file (for single -e) or directory (for -E or multiple -e).",cxxopts::value<std::string>())
         ("i,input","Specify input file name.",cxxopts::value<std::string>());
 
     options.parse_positional({"i"});
@@ -181,6 +392,14 @@ int main(int argc, char** argv)
     std::vector<std::string> filePath = MFUtil::strSplit(inputFile, ZPL_PATH_SEPARATOR);
     std::string fileName = MFUtil::strToLower(filePath.back());
 
+    if (!dtaKeyExtractor.load(gameExe))
+    {
+        MFLogger::Logger::fatal("Could not extract keys from " + executableFile + ".", DTA_MODULE_STR);
+        return 1;
+    }
+
+    gameExe.close();
+
     for(auto dtaFile : dtaKeyExtractor.getFiles())
     {
         if(fileName.compare(dtaFile.mFileName) == 0) 
@@ -234,23 +453,76 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    MFUtil::MappedFile archive;
+
+    bool threadScalingMode = arguments.count("T") > 0;
+
+    unsigned int jobs = std::max(std::thread::hardware_concurrency(),1u);
+
+    if (arguments.count("j") > 0)
+        jobs = std::max(arguments["j"].as<unsigned int>(),1u);
+
+    if ((extractMode || extractAllMode || threadScalingMode) && !archive.open(fs->getFileLocation(inputFile)) && !archive.open(inputFile))
+    {
+        MFLogger::Logger::fatal("Could not map file " + inputFile + ".", DTA_MODULE_STR);
+        f.close();
+        return 1;
+    }
+
     if (extractMode)
     {
-        std::string extractFile = arguments["e"].as<std::string>();
-        std::string outputFile = output.length() > 0 ? output : MFUtil::strToLower(extractFile);
+        std::vector<std::string> extractFiles = arguments["e"].as<std::vector<std::string>>();
+        std::vector<int> fileIndices = dta.getFileIndices(extractFiles);
 
-        if (!extract(dta,f,extractFile,outputFile,""))
+        for (size_t i = 0; i < extractFiles.size(); ++i)
         {
-            f.close();
-            return 1;
+            if (fileIndices[i] < 0)
+            {
+                MFLogger::Logger::fatal("File " + extractFiles[i] + " not found.", DTA_MODULE_STR);
+                f.close();
+                return 1;
+            }
+        }
+
+        for (size_t i = 0; i < extractFiles.size(); ++i)
+        {
+            std::string outputFile = MFUtil::strToLower(dta.getFileName(fileIndices[i]));
+            std::string pathPrefix = output;
+
+            if (extractFiles.size() == 1 && output.length() > 0)
+            {
+                outputFile = output;
+                pathPrefix = "";
+            }
+
+            ExtractLog log;
+            bool extracted = extract(dta,archive,fileIndices[i],outputFile,pathPrefix,log);
+            printLog(log);
+
+            if (!extracted)
+            {
+                f.close();
+                return 1;
+            }
         }
     }
+    else if (arguments.count("b") > 0)
+    {
+        benchmarkLZSS(dta,f,arguments["b"].as<unsigned int>());
+    }
+    else if (threadScalingMode)
+    {
+        benchmarkThreads(dta,archive,jobs);
+    }
     else if (extractAllMode)
     {
         MFLogger::Logger::info("Extracting file " + inputFile + ".", DTA_MODULE_STR);
 
-        for (int i = 0; i < (int) dta.getNumFiles(); ++i)
-            extract(dta,f,dta.getFileName(i),MFUtil::strToLower(dta.getFileName(i)),output);
+        if (!extractAll(dta,archive,output,jobs))
+        {
+            f.close();
+            return 1;
+        }
     }
     else
     {
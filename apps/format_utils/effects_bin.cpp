@@ -11,7 +11,7 @@ void dump(MFFormat::DataFormatEffectsBIN effectsBin)
     std::cout << "{\n";
     dumpValue("numberOfEffects", std::to_string(effectsBin.getNumEffects()), 1);
     std::cout << "    \"effects\": [\n";
-    for (auto effect : effectsBin.getEffects())
+    for (const auto &effect : effectsBin.getEffects())
     {
         std::cout << "        {\n";
         dumpValue("id", std::to_string(effect.mEffectId), 3, false);
@@ -8,7 +8,7 @@
 void dump(MFFormat::DataFormatLoadDEF loadDef)
 {
     MFLogger::Logger::raw("number of loading screens: " + std::to_string(loadDef.getNumLoadingScreens()), "dump");
-    for (auto loadingScreen : loadDef.getLoadingScreens())
+    for (const auto &loadingScreen : loadDef.getLoadingScreens())
     {
         MFLogger::Logger::raw("\t" + std::string(loadingScreen.mMissionName) + "\t" + std::string(loadingScreen.mFileName) + "\t" + std::to_string(loadingScreen.mTextId), "dump");
     }
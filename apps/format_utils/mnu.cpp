@@ -8,7 +8,7 @@
 void dump(MFFormat::DataFormatMenuDEF menuDef)
 {
     MFLogger::Logger::raw("Controls: " + std::to_string(menuDef.getNumControls()));
-    for (auto control : menuDef.getControls())
+    for (const auto &control : menuDef.getControls())
     {
         MFLogger::Logger::raw("type: " + MFUtil::strReverse(std::string(control.mType)));
         MFLogger::Logger::raw("\tpos: " + std::to_string(control.mPos.x) + " " + std::to_string(control.mPos.y));
@@ -23,7 +23,7 @@ void dump(MFFormat::DataFormatMenuDEF menuDef)
 void dump(MFFormat::DataFormatMNU mnu)
 {
     MFLogger::Logger::raw("Controls: " + std::to_string(mnu.getNumControls()));
-    for (auto control : mnu.getControls())
+    for (const auto &control : mnu.getControls())
     {
         MFLogger::Logger::raw("type: " + MFUtil::strReverse(std::string(control.mType)));
         MFLogger::Logger::raw("\tpos: " + std::to_string(control.mPos.x) + " " + std::to_string(control.mPos.y));
@@ -8,14 +8,14 @@
 void dump(MFFormat::DataFormatRoadBIN roadBin)
 {
     MFLogger::Logger::raw("number of crossroads: " + std::to_string(roadBin.getNumCrossroads()), "dump");
-    for (auto crossroad : roadBin.getCrossroads())
+    for (const auto &crossroad : roadBin.getCrossroads())
     {
         MFLogger::Logger::raw("\tcrossroad position: " + std::to_string(crossroad.mPos.x) + " " + std::to_string(crossroad.mPos.y) + " " + std::to_string(crossroad.mPos.z), "dump");
         MFLogger::Logger::raw("\tcrossroad speed (km/h): " + std::to_string(crossroad.mSpeed * 3), "dump");
     }
 
     MFLogger::Logger::raw("number of waypoints: " + std::to_string(roadBin.getNumWaypoints()), "dump");
-    for (auto waypoint : roadBin.getWaypoints())
+    for (const auto &waypoint : roadBin.getWaypoints())
     {
         MFLogger::Logger::raw("\twaypoint position: " + std::to_string(waypoint.mPos.x) + " " + std::to_string(waypoint.mPos.y) + " " + std::to_string(waypoint.mPos.z), "dump");
         MFLogger::Logger::raw("\twaypoint speed (km/h): " + std::to_string(waypoint.mSpeed * 3), "dump");
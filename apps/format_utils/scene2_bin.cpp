@@ -50,7 +50,7 @@ char const *getTypeName(size_t count, TypeName const *typeNames, uint32_t objTyp
 
 // draft
 
-void dump(MFFormat::DataFormatScene2BIN scene2Bin, uint32_t objType, uint32_t specialObjType)
+void dump(const MFFormat::DataFormatScene2BIN &scene2Bin, uint32_t objType, uint32_t specialObjType)
 {
     using namespace MFUtil;
     std::cout << "{" << std::endl;
@@ -60,15 +60,14 @@ void dump(MFFormat::DataFormatScene2BIN scene2Bin, uint32_t objType, uint32_t sp
     dumpValue("numberOfObjects", std::to_string(scene2Bin.getNumObjects()), 1, false);
     std::cout << "    \"objects\": ["<< std::endl;
 
-    for (auto pair : scene2Bin.getObjects())
+    for (const auto &object : scene2Bin.getObjects())
     {
-        auto object = pair.second;
         if (object.mType != objType && objType != 0) continue;
         if (object.mSpecialType != specialObjType && specialObjType != 0) continue;
 
         std::cout << "        {\n";
 
-        dumpValue("objectName", object.mName, 3);
+        dumpValue("objectName", scene2Bin.getString(object.mName), 3);
         dumpValue("type", std::string(getTypeName(sizeof(gObjectTypeNames) / sizeof(gObjectTypeNames[0]), gObjectTypeNames, object.mType)), 3);
         dumpValue("typeRaw", std::to_string(object.mType), 3, false);
         dumpValue("specialType", std::string(getTypeName(sizeof(gSpecialObjectTypeNames) / sizeof(gSpecialObjectTypeNames[0]), gSpecialObjectTypeNames, object.mSpecialType)), 3);
@@ -77,10 +76,10 @@ void dump(MFFormat::DataFormatScene2BIN scene2Bin, uint32_t objType, uint32_t sp
         dumpValue("position2", object.mPos2.str(), 3, false);
         dumpValue("rotation", object.mRot.str(), 3, false);
         dumpValue("scale", object.mScale.str(), 3, false);
-        dumpValue("parentName", object.mParentName, 3, true);
+        dumpValue("parentName", scene2Bin.getString(object.mParentName), 3, true);
 
         if (object.mType == MFFormat::DataFormatScene2BIN::OBJECT_TYPE_MODEL)
-            dumpValue("modelName", object.mModelName, 3, true);
+            dumpValue("modelName", scene2Bin.getString(object.mModelName), 3, true);
 
         if (object.mSpecialType == MFFormat::DataFormatScene2BIN::SPECIAL_OBJECT_TYPE_PHYSICAL) {
             auto props = object.mSpecialProps;
@@ -8,7 +8,7 @@
 void dump(MFFormat::DataFormatTextdbDEF textDb)
 {
     MFLogger::Logger::raw("number of text entries: " + std::to_string(textDb.getNumTextEntries()), "dump");
-    for (auto textEntry : textDb.getTextEntries())
+    for (const auto &textEntry : textDb.getTextEntries())
     {
         MFLogger::Logger::raw("[" + std::to_string(textEntry.first) + "] " + textEntry.second, "dump");
     }
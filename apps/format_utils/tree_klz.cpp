@@ -9,7 +9,7 @@
 
 void dump(MFFormat::DataFormatTreeKLZ &klz)
 {
-    std::vector<MFFormat::DataFormatTreeKLZ::Link> links = klz.getLinks();
+    const std::vector<MFFormat::DataFormatTreeKLZ::Link> &links = klz.getLinks();
 
     std::cout << "LINKS (" << links.size() << "):" << std::endl;
 
@@ -36,10 +36,10 @@ void dump(MFFormat::DataFormatTreeKLZ &klz)
 
     #define dumpItems(getFunc,printCmd) \
     {\
-        auto items = getFunc;\
+        const auto &items = getFunc;\
         for (int i = 0; i < (int) items.size(); ++i)\
         {\
-            auto item = items[i];\
+            const auto &item = items[i];\
             printCmd;\
         }\
     }
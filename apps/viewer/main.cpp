@@ -169,6 +169,13 @@ int main(int argc, char** argv)
         ("no-scene2bin","Do not load scene2.bin for the mission.")
         ("no-cachebin","Do not load cache.bin for the mission.")
         ("no-treeklz","Do not load tree.klz (collisions) for the mission.")
+        ("no-dta","Do not mount DTA archives, only use extracted files.")
+        ("disk-cache","Keep files decoded from the DTA archives in ~/.openmf/cache for faster loading next time.")
+        ("bake-models","Keep converted models in ~/.openmf/baked for faster loading next time.")
+        ("bake-textures","Keep compressed textures in ~/.openmf/textures for faster loading next time.")
+        ("watch-files","Pick up files added to or removed from the search paths while running (Linux only).")
+        ("skinning-threads","Number of threads to skin the characters by (default 1).",cxxopts::value<unsigned int>())
+        ("texture-threads","Number of threads to decode the textures by while loading, 0 = the loading thread (default 4).",cxxopts::value<unsigned int>())
         ("m,mask","Set rendering mask.",cxxopts::value<unsigned int>());
 
     options.parse_positional({"i"});
@@ -183,6 +190,9 @@ int main(int argc, char** argv)
     if (arguments.count("b") > 0)
         MFFile::FileSystem::getInstance()->prependPath(arguments["b"].as<std::string>());
 
+    if (arguments.count("watch-files") > 0)
+        MFFile::FileSystem::getInstance()->setWatchChanges(true);
+
     MFGame::Engine::EngineSettings settings;
 
     settings.mSimulatePhysics = arguments.count("P") > 0;
@@ -190,8 +200,18 @@ int main(int argc, char** argv)
     settings.mLoadScene2Bin   = arguments.count("no-scene2bin") < 1;
     settings.mLoadCacheBin    = arguments.count("no-cachebin") < 1;
     settings.mLoadTreeKlz     = arguments.count("no-treeklz") < 1;
+    settings.mMountArchives   = arguments.count("no-dta") < 1;
+    settings.mDiskCache       = arguments.count("disk-cache") > 0;
+    settings.mBakeModels      = arguments.count("bake-models") > 0;
+    settings.mBakeTextures    = arguments.count("bake-textures") > 0;
     settings.mVsync           = arguments.count("vsync") > 0;
 
+    if (arguments.count("skinning-threads") > 0)
+        settings.mSkinningThreads = arguments["skinning-threads"].as<unsigned int>();
+
+    if (arguments.count("texture-threads") > 0)
+        settings.mTextureThreads = arguments["texture-threads"].as<unsigned int>();
+
     std::string cameraString = "";
 
     if (arguments.count("p") > 0)
@@ -0,0 +1,145 @@
+#include <4ds/morph.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace MFFormat
+{
+
+MorphBatch::InstanceId MorphBatch::play(const Target &target, float *positions, float *normals, float speed)
+{
+    Instance instance;
+    instance.mId = mNextId++;
+    instance.mTarget = target;
+    instance.mPositions = positions;
+    instance.mNormals = normals;
+    instance.mTime = 0;
+    instance.mSpeed = speed;
+    instance.mAppliedFrame = -1;
+
+    if (mNextId == NO_INSTANCE)
+        mNextId++;
+
+    mInstances.push_back(instance);
+    return instance.mId;
+}
+
+void MorphBatch::stop(InstanceId id)
+{
+    int index = getIndex(id);
+
+    if (index >= 0)
+        mInstances.erase(mInstances.begin() + index);
+}
+
+void MorphBatch::setTime(InstanceId id, float time)
+{
+    int index = getIndex(id);
+
+    if (index >= 0)
+        mInstances[index].mTime = time;
+}
+
+int MorphBatch::getIndex(InstanceId id) const
+{
+    for (size_t i = 0; i < mInstances.size(); ++i)
+        if (mInstances[i].mId == id)
+            return i;
+
+    return -1;
+}
+
+void MorphBatch::advance(float dt)
+{
+    for (auto& instance : mInstances)
+    {
+        float duration = instance.mTarget.mFrameCount / (float) FRAMES_PER_SECOND;
+
+        if (duration <= 0)
+            continue;
+
+        instance.mTime = std::fmod(instance.mTime + dt * instance.mSpeed,duration);   // loops, keeps the precision
+
+        if (instance.mTime < 0)
+            instance.mTime += duration;
+    }
+}
+
+bool MorphBatch::apply(size_t index)
+{
+    Instance &instance = mInstances[index];
+    const Target &target = instance.mTarget;
+
+    if (target.mFrameCount == 0 || target.mVertexCount == 0)
+        return false;
+
+    float frame = std::fmod(instance.mTime * FRAMES_PER_SECOND,(float) target.mFrameCount);
+
+    if (frame < 0)
+        frame += target.mFrameCount;
+
+    if (frame == instance.mAppliedFrame)
+        return false;
+
+    instance.mAppliedFrame = frame;
+
+    // the last frame blends back to the first one
+
+    uint32_t frameA = std::min((uint32_t) frame,target.mFrameCount - 1);
+    uint32_t frameB = (frameA + 1) % target.mFrameCount;
+    float t = frame - frameA;
+
+    const size_t count = target.mVertexCount * 3;
+    mBlended.resize(count);
+    float *blended = mBlended.data();
+
+    blend(target.mPositions + frameA * count,target.mPositions + frameB * count,t,blended,count);
+
+    for (uint32_t i = 0; i < target.mVertexCount; ++i)
+    {
+        float *o = instance.mPositions + target.mLinks[i] * 3;
+        o[0] = blended[i * 3];
+        o[1] = blended[i * 3 + 1];
+        o[2] = blended[i * 3 + 2];
+    }
+
+    blend(target.mNormals + frameA * count,target.mNormals + frameB * count,t,blended,count);
+
+    for (uint32_t i = 0; i < target.mVertexCount; ++i)
+    {
+        const float *n = blended + i * 3;
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float scale = length > 0 ? 1.0f / length : 0.0f;
+
+        float *o = instance.mNormals + target.mLinks[i] * 3;
+        o[0] = n[0] * scale;
+        o[1] = n[1] * scale;
+        o[2] = n[2] * scale;
+    }
+
+    return true;
+}
+
+void MorphBatch::blend(const float *a, const float *b, float t, float *result, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 vt = _mm_set1_ps(t);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(result + i,_mm_add_ps(va,_mm_mul_ps(_mm_sub_ps(vb,va),vt)));
+    }
+#endif
+
+    for (; i < count; ++i)
+        result[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef MORPH_4DS_H
+#define MORPH_4DS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace MFFormat
+{
+
+/**
+  Plays morph animations of 4DS meshes (curtains, flags, faces, ...). A morph LOD has a number of
+  frames, each with positions and normals of the morphed vertices, and links telling which vertices
+  of the LOD's geometry they replace. apply(...) blends the two frames around the current time with
+  one (SIMD) loop over the flat frame arrays and then writes only the linked vertices of the output
+  arrays, the rest of the geometry is never touched.
+*/
+
+class MorphBatch
+{
+public:
+    typedef uint32_t InstanceId;
+    static const InstanceId NO_INSTANCE = 0;
+    static const unsigned int FRAMES_PER_SECOND = 25;
+
+    typedef struct
+    {
+        uint32_t mFrameCount;
+        uint32_t mVertexCount;             // morphed vertices per frame
+        const float *mPositions;           // 3 floats per vertex, frame after frame
+        const float *mNormals;
+        const uint16_t *mLinks;            // output vertex of each morphed vertex
+    } Target;
+
+    /**
+      Starts morphing given output arrays (3 floats per vertex) in a loop. The target data and the
+      outputs have to outlive the instance.
+    */
+    InstanceId play(const Target &target, float *positions, float *normals, float speed = 1.0);
+    void stop(InstanceId id);
+    bool isPlaying(InstanceId id) const                         { return getIndex(id) >= 0; }
+    void setTime(InstanceId id, float time);
+
+    /// Moves the time of all instances, nothing is deformed yet.
+    void advance(float dt);
+
+    /// Deforms the outputs of an instance for its current time, false if they already are.
+    bool apply(size_t index);
+
+    /// Instances keep the order in which they were started, -1 if the instance isn't playing.
+    int getIndex(InstanceId id) const;
+    size_t getNumInstances() const                              { return mInstances.size(); }
+
+    /// result[i] = a[i] + (b[i] - a[i]) * t
+    static void blend(const float *a, const float *b, float t, float *result, size_t count);
+
+protected:
+    typedef struct
+    {
+        InstanceId mId;
+        Target mTarget;
+        float *mPositions;
+        float *mNormals;
+        float mTime;
+        float mSpeed;
+        float mAppliedFrame;               // frame (with the blend fraction) the outputs have, -1 = none yet
+    } Instance;
+
+    std::vector<Instance> mInstances;
+    InstanceId mNextId = 1;
+    std::vector<float> mBlended;
+};
+
+}
+
+#endif
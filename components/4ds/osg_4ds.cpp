@@ -96,95 +96,52 @@ osg::ref_ptr<osg::Texture2D> OSGModelLoader::loadTexture(std::string fileName, s
     tex->setWrap(osg::Texture::WRAP_S,osg::Texture::REPEAT);
     tex->setWrap(osg::Texture::WRAP_T,osg::Texture::REPEAT);
 
-    std::string filePath = MFFile::convertPathToCanonical(getTextureDir() + fileName);
-    std::string fileLocation = mFileSystem->getFileLocation(filePath);
-
+    std::string filePath;
     std::string filePathAlpha;
-    std::string fileLocationAlpha;
-
-    if (alphaTexture)
-    {
-        filePathAlpha = MFFile::convertPathToCanonical(getTextureDir() + fileNameAlpha);
-        fileLocationAlpha = mFileSystem->getFileLocation(filePathAlpha);
-    } 
-
-    osg::ref_ptr<osg::Image> img;
 
     if (diffuseTexture)
-    {
-        if (fileLocation.length() == 0)
-        {
-            MFLogger::Logger::warn("Could not load texture: " + fileName, OSG4DS_MODULE_STR);
-        }
-        else
-        {
-            img = osgDB::readImageFile(fileLocation);
+        filePath = MFFile::convertPathToCanonical(getTextureDir() + fileName);
 
-            if (colorKey)
-            {
-                MFFormat::BMPInfo bmp;
-
-                std::ifstream bmpFile;
-                bmpFile.open(fileLocation, std::ios::binary);
-                bmp.load(bmpFile);
-                bmpFile.close();
+    if (alphaTexture)
+        filePathAlpha = MFFile::convertPathToCanonical(getTextureDir() + fileNameAlpha);
 
-                osg::Vec3f transparentColor = osg::Vec3f(     
-                    bmp.mTransparentColor.r / 255.0,
-                    bmp.mTransparentColor.g / 255.0,
-                    bmp.mTransparentColor.b / 255.0);
+    OSGTextureJobs::getInstance()->add(tex.get(),filePath,filePathAlpha,colorKey);   // the image gets attached at the end of load(...)
+    tex->setMaxAnisotropy(16.0f);
 
-                img = MFUtil::applyColorKey(img.get(), transparentColor, 0.04f );
-            }
-        }
-    }
+    storeToCache(textureIdentifier,tex);
 
-    if (alphaTexture)
-    {
-        if (fileLocationAlpha.length() == 0)
-        {
-            MFLogger::Logger::warn("Could not load alpha texture: " + fileNameAlpha, OSG4DS_MODULE_STR);
-        }
-        else
-        {
-            osg::ref_ptr<osg::Image> imgAlpha = osgDB::readImageFile(fileLocationAlpha);
+    return tex;
+}
 
-            if (!diffuseTexture)
-            {
-                img->allocateImage(imgAlpha->s(),imgAlpha->t(),1,imgAlpha->getPixelFormat(),imgAlpha->getDataType());
-            }
+template <typename T>
+static osg::ref_ptr<osg::DrawElements> makeDrawElements(const uint32_t *indices, const std::vector<const MFFormat::DataFormatBaked4DS::FaceGroup *> &faceGroups)
+{
+    size_t count = 0;
 
-            img = MFUtil::addAlphaFromImage(img.get(),imgAlpha.get());
-        }
-    }
+    for (auto faceGroup : faceGroups)
+        count += faceGroup->mIndexCount;
 
-    tex->setImage(img);
-    tex->setMaxAnisotropy(16.0f);
+    osg::ref_ptr<T> elements = new T(GL_TRIANGLES);
+    elements->reserve(count);
 
-    storeToCache(textureIdentifier,tex);
+    for (auto faceGroup : faceGroups)
+        for (uint32_t i = 0; i < faceGroup->mIndexCount; ++i)
+            elements->push_back(static_cast<typename T::value_type>(indices[faceGroup->mFirstIndex + i]));
 
-    return tex;
+    return elements;
 }
 
-osg::ref_ptr<osg::Node> OSGModelLoader::make4dsFaceGroup(
+osg::ref_ptr<osg::Geometry> OSGModelLoader::make4dsFaceGroups(
         osg::Vec3Array *vertices,
         osg::Vec3Array *normals,
         osg::Vec2Array *uvs,
-        MFFormat::DataFormat4DS::FaceGroup *faceGroup,
-        bool isBillboard,
-        osg::Vec3f billboardAxis)
+        const uint32_t *indices,
+        const std::vector<const MFFormat::DataFormatBaked4DS::FaceGroup *> &faceGroups,
+        OSGMorphData *morph,
+        OSGSkinData *skin)
 {
-    MFLogger::Logger::info("      loading facegroup, material: " + std::to_string(faceGroup->mMaterialID) + ".", OSG4DS_MODULE_STR);
-
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_TRIANGLES);
-
-    for (size_t i = 0; i < faceGroup->mFaceCount; ++i)
-    {
-        auto face = faceGroup->mFaces[i];
-        indices->push_back(face.mA);
-        indices->push_back(face.mB);
-        indices->push_back(face.mC);
-    }
+    MFLogger::Logger::info("      loading facegroups, material: " + std::to_string(faceGroups[0]->mMaterialID) +
+        ", count: " + std::to_string(faceGroups.size()) + ".", OSG4DS_MODULE_STR);
 
     osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
     geom->setName("facegroup");
@@ -194,76 +151,69 @@ osg::ref_ptr<osg::Node> OSGModelLoader::make4dsFaceGroup(
 
     geom->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
 
-    geom->addPrimitiveSet(indices.get());
+    // the face groups are drawn as one primitive set, a 4DS LOD has at most UINT16_MAX vertices (checked
+    // by DataFormatBaked4DS), so 16 bit indices always do and never hit the 0xFFFF restart index
 
-    if (isBillboard)
+    geom->addPrimitiveSet(makeDrawElements<osg::DrawElementsUShort>(indices,faceGroups));
+
+    if (morph || skin)
     {
-        osg::ref_ptr<osg::Billboard> billboard = new osg::Billboard;
-        billboard->addDrawable(geom);
-        billboard->setAxis(billboardAxis);
-        billboard->setNodeMask(MFRender::MASK_GAME);
-        return billboard;
-    }
+        // the vertices are deformed by OSGMorphPlayer and OSGSkinPlayer, the bound covers all the
+        // morph frames, skinned meshes get some room for the limbs to move
 
-    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
-    geode->addDrawable(geom.get());
-    geode->setNodeMask(MFRender::MASK_GAME);
-    return geode;
-}
+        geom->setDataVariance(osg::Object::DYNAMIC);
+        geom->setUseDisplayList(false);
+        geom->setUseVertexBufferObjects(true);
 
-osg::ref_ptr<osg::Node> OSGModelLoader::make4dsMesh(DataFormat4DS::Mesh *mesh, MaterialList &materials)
-{
-    if (mesh->mMeshType != MFFormat::DataFormat4DS::MESHTYPE_STANDARD)
-    {
-        osg::ref_ptr<osg::Node> emptyNode;
-        return emptyNode;
-    }
+        if (skin)
+        {
+            geom->setUserData(skin);
+            geom->setCullCallback(new SkinCullCallback(skin));
+        }
+        else
+        {
+            geom->setUserData(morph);
+            geom->setCullCallback(new MorphCullCallback(morph));
+        }
 
-    MFFormat::DataFormat4DS::Standard standard;
+        osg::BoundingBox bound;
 
-    bool isBillboard = false;
-    bool unknown = false;
+        for (const auto& v : *vertices)
+            bound.expandBy(v);
 
-    switch (mesh->mVisualMeshType)
-    {
-        case MFFormat::DataFormat4DS::VISUALMESHTYPE_STANDARD:
-            standard = mesh->mStandard;
-            break;
-
-        case MFFormat::DataFormat4DS::VISUALMESHTYPE_BILLBOARD:
-            isBillboard = true;
-            standard = mesh->mBillboard.mStandard;
-            break;
-
-        case MFFormat::DataFormat4DS::VISUALMESHTYPE_SINGLEMESH:
-            standard = mesh->mSingleMesh.mStandard;
-            break;
-
-        case MFFormat::DataFormat4DS::VISUALMESHTYPE_SINGLEMORPH:
-            standard = mesh->mSingleMorph.mSingleMesh.mStandard;
-            break;
-
-        case MFFormat::DataFormat4DS::VISUALMESHTYPE_MORPH:
-            standard = mesh->mMorph.mStandard;
-            break;
-
-        default:
-            unknown = true;
-            break;
+        if (morph)
+            for (const auto& v : morph->mPositions)
+                bound.expandBy(osg::Vec3f(v.x,v.y,v.z));
+
+        if (skin)
+        {
+            osg::Vec3f extent = (bound._max - bound._min) * 0.5;
+            bound.expandBy(bound._max + extent);
+            bound.expandBy(bound._min - extent);
+        }
+
+        geom->setInitialBound(bound);
     }
 
-    if (unknown)
+    return geom;
+}
+
+osg::ref_ptr<osg::Node> OSGModelLoader::make4dsMesh(const DataFormatBaked4DS &model, const DataFormatBaked4DS::Mesh *mesh, MaterialList &materials, SkinList &skins)
+{
+    if (mesh->mLodCount == 0)     // not a visual mesh or a type that has no standard geometry (mirror, glow)
     {
         osg::ref_ptr<osg::Node> emptyNode;
         return emptyNode;
     }
 
-    std::string meshName = std::string(mesh->mMeshName,0,mesh->mMeshNameLength);
+    bool isBillboard = mesh->mVisualMeshType == MFFormat::DataFormat4DS::VISUALMESHTYPE_BILLBOARD;
 
-    MFLogger::Logger::info("  loading mesh (" + std::string(meshName) + "), LOD level: " + std::to_string((int) standard.mLODLevel) +
+    std::string meshName = model.getString(mesh->mName);
+
+    MFLogger::Logger::info("  loading mesh (" + std::string(meshName) + "), LOD level: " + std::to_string((int) mesh->mLODLevel) +
         ", type: " + std::to_string((int) mesh->mMeshType) +
         ", parent: " + std::to_string((int) mesh->mParentID) +
-        ", instanced: " + std::to_string(standard.mInstanced), 
+        ", instanced: " + std::to_string(mesh->mInstanced), 
         OSG4DS_MODULE_STR);
 
     const float maxDistance = 10000000.0;
@@ -274,11 +224,29 @@ osg::ref_ptr<osg::Node> OSGModelLoader::make4dsMesh(DataFormat4DS::Mesh *mesh, M
 
     float previousDist = 0.0;
 
-    for (int i = 0; i < standard.mLODLevel; ++i)
+    for (int i = 0; i < (int) mesh->mLodCount; ++i)
     {
-        float distLOD = standard.mLODLevel == 1 ? maxDistance : standard.mLODs[i].mRelativeDistance;
+        const DataFormatBaked4DS::Lod *lod = model.getLods() + mesh->mFirstLod + i;
+        float distLOD = mesh->mLODLevel == 1 ? maxDistance : lod->mRelativeDistance;
+
+        const DataFormatBaked4DS::Morph *morph = nullptr;
+
+        for (uint32_t j = mesh->mFirstMorph; j < mesh->mFirstMorph + mesh->mMorphCount; ++j)
+            if (model.getMorphs()[j].mLod == mesh->mFirstLod + i)
+                morph = model.getMorphs() + j;
 
-        nodeLOD->addChild(make4dsMeshLOD(&(standard.mLODs[i]),materials,isBillboard));  // TODO: add rotation axis
+        SkinBinding skin = {};
+
+        for (uint32_t j = mesh->mFirstSkin; j < mesh->mFirstSkin + mesh->mSkinCount; ++j)
+            if (model.getSkins()[j].mLod == mesh->mFirstLod + i)
+            {
+                skin.mMesh = mesh - model.getMeshes();
+                skin.mSkin = model.getSkins() + j;
+                skin.mData = new OSGSkinData;
+                skins.push_back(skin);
+            }
+
+        nodeLOD->addChild(make4dsMeshLOD(model,lod,materials,isBillboard,osg::Vec3f(0,0,1),morph,skin.mSkin,skin.mData.get()));  // TODO: add rotation axis
         nodeLOD->setRange(i,previousDist,distLOD);
         previousDist = distLOD;
     }
@@ -287,64 +255,215 @@ osg::ref_ptr<osg::Node> OSGModelLoader::make4dsMesh(DataFormat4DS::Mesh *mesh, M
 }
 
 osg::ref_ptr<osg::Node> OSGModelLoader::make4dsMeshLOD(
-    DataFormat4DS::Lod *meshLOD,
+    const DataFormatBaked4DS &model,
+    const DataFormatBaked4DS::Lod *meshLOD,
     MaterialList &materials,
     bool isBillboard,
-    osg::Vec3 billboardAxis)
+    osg::Vec3 billboardAxis,
+    const DataFormatBaked4DS::Morph *morph,
+    const DataFormatBaked4DS::Skin *skin,
+    OSGSkinData *skinData)
 {
     MFLogger::Logger::info("    loading LOD, vertices: " + std::to_string(meshLOD->mVertexCount) +
         ", face groups: " + std::to_string((int) meshLOD->mFaceGroupCount),
  
         OSG4DS_MODULE_STR);
 
-    osg::ref_ptr<osg::Group> group = new osg::Group();
-    group->setName("LOD level");
+    static_assert(sizeof(osg::Vec3f) == sizeof(MFMath::Vec3) && sizeof(osg::Vec2f) == sizeof(MFMath::Vec2),
+        "baked vertex data are handed to OSG as they are");
+
+    // the bake is already in OSG space, so the arrays are just copied
+
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(meshLOD->mVertexCount,
+        reinterpret_cast<const osg::Vec3f *>(model.getPositions() + meshLOD->mFirstVertex));
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(meshLOD->mVertexCount,
+        reinterpret_cast<const osg::Vec3f *>(model.getNormals() + meshLOD->mFirstVertex));
+    osg::ref_ptr<osg::Vec2Array> uvs = new osg::Vec2Array(meshLOD->mVertexCount,
+        reinterpret_cast<const osg::Vec2f *>(model.getUVs() + meshLOD->mFirstVertex));
 
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec2Array> uvs = new osg::Vec2Array;
+    osg::ref_ptr<OSGMorphData> morphData;
 
-    for (size_t i = 0; i < meshLOD->mVertexCount; ++i)
+    if (morph)
     {
-        auto vertex = meshLOD->mVertices[i];
+        // copied, the bake doesn't outlive the loading
 
-        osg::Vec3 normal = toOSG( vertex.mNormal );
-        normal.normalize();
+        const size_t targetCount = morph->mFrameCount * morph->mVertexCount;
 
-        vertices->push_back( toOSG(vertex.mPos) );
-        normals->push_back(normal);
-        uvs->push_back(osg::Vec2f(vertex.mUV.x, 1.0 - vertex.mUV.y));
+        morphData = new OSGMorphData;
+        morphData->mFrameCount = morph->mFrameCount;
+        morphData->mPositions.assign(model.getMorphPositions() + morph->mFirstTarget,model.getMorphPositions() + morph->mFirstTarget + targetCount);
+        morphData->mNormals.assign(model.getMorphNormals() + morph->mFirstTarget,model.getMorphNormals() + morph->mFirstTarget + targetCount);
+        morphData->mLinks.assign(model.getMorphLinks() + morph->mFirstLink,model.getMorphLinks() + morph->mFirstLink + morph->mVertexCount);
+        morphData->mVertexArray = vertices;
+        morphData->mNormalArray = normals;
+
+        vertices->setDataVariance(osg::Object::DYNAMIC);
+        normals->setDataVariance(osg::Object::DYNAMIC);
     }
 
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_TRIANGLES);
+    if (skin && skinData)
+    {
+        // the bones are linked in load(...), a morph changes the bind pose, so all the vertices get skinned then
+
+        const DataFormatBaked4DS::SkinInfluence *influences = model.getSkinInfluences() + skin->mFirstInfluence;
+        const uint16_t jointCount = skin->mJointCount;
+
+        skinData->mFirstVertex = morphData ? 0 : skin->mFirstSkinnedVertex;
+        skinData->mBindVertexArray = new osg::Vec3Array(*vertices);
+        skinData->mBindNormalArray = new osg::Vec3Array(*normals);
+        skinData->mInfluences.assign(skin->mFirstSkinnedVertex - skinData->mFirstVertex,SkinBatch::Influence {{jointCount,jointCount},1.0f});
+
+        for (uint32_t i = skin->mFirstSkinnedVertex; i < meshLOD->mVertexCount; ++i)
+        {
+            const DataFormatBaked4DS::SkinInfluence &influence = influences[i - skin->mFirstSkinnedVertex];
+            skinData->mInfluences.push_back(SkinBatch::Influence {{influence.mJoints[0],influence.mJoints[1]},influence.mWeight});
+        }
+
+        skinData->mVertexArray = vertices;
+        skinData->mNormalArray = normals;
+
+        if (morphData)
+        {
+            morphData->mVertexArray = skinData->mBindVertexArray;
+            morphData->mNormalArray = skinData->mBindNormalArray;
+            skinData->mMorph = morphData;
+        }
+
+        vertices->setDataVariance(osg::Object::DYNAMIC);
+        normals->setDataVariance(osg::Object::DYNAMIC);
+    }
+
+    // one geometry per material, all of them sharing the LOD's arrays, under a single geode
+
+    std::vector<const DataFormatBaked4DS::FaceGroup *> faceGroups;
 
     for (size_t i = 0; i < meshLOD->mFaceGroupCount; ++i)
+        faceGroups.push_back(model.getFaceGroups() + meshLOD->mFirstFaceGroup + i);
+
+    auto materialIndex = [&materials](const DataFormatBaked4DS::FaceGroup *faceGroup)
+    {
+        return std::max(0,std::min(
+            static_cast<int>(materials.size() - 1),
+            static_cast<int>(faceGroup->mMaterialID) - 1));
+    };
+
+    std::stable_sort(faceGroups.begin(),faceGroups.end(),
+        [&materialIndex](const DataFormatBaked4DS::FaceGroup *a, const DataFormatBaked4DS::FaceGroup *b) { return materialIndex(a) < materialIndex(b); });
+
+    osg::ref_ptr<osg::Geode> geode;
+
+    if (isBillboard)
+    {
+        osg::ref_ptr<osg::Billboard> billboard = new osg::Billboard;
+        billboard->setAxis(billboardAxis);
+        geode = billboard;
+    }
+    else
+        geode = new osg::Geode;
+
+    geode->setName("LOD level");
+    geode->setNodeMask(MFRender::MASK_GAME);
+
+    for (size_t first = 0; first < faceGroups.size();)
     {
-        osg::ref_ptr<osg::Node> faceGroup = make4dsFaceGroup(
+        const int materialID = materialIndex(faceGroups[first]);
+        size_t last = first + 1;
+
+        while (last < faceGroups.size() && materialIndex(faceGroups[last]) == materialID)
+            last++;
+
+        osg::ref_ptr<osg::Geometry> geom = make4dsFaceGroups(
             vertices.get(),
             normals.get(),
             uvs.get(),
-            &(meshLOD->mFaceGroups[i]),
-            isBillboard,
-            billboardAxis);
-
-        const int materialID = std::max(0,std::min(
-            static_cast<int>(materials.size() - 1),
-            meshLOD->mFaceGroups[i].mMaterialID - 1));
+            model.getIndices(),
+            std::vector<const DataFormatBaked4DS::FaceGroup *>(faceGroups.begin() + first,faceGroups.begin() + last),
+            morphData.get(),
+            skin ? skinData : nullptr);
 
         // TODO: set default material when materialID = 0
         // or no materials are defined in .4ds file
         if (materials.size() > 0)
-            faceGroup->setStateSet(materials[materialID]);
+            geom->setStateSet(materials[materialID]);
 
-        group->addChild(faceGroup);
+        geode->addDrawable(geom);
+        first = last;
     }
 
-    return group;
+    return geode;
+}
+
+osg::ref_ptr<osg::StateAttribute> OSGModelLoader::shareAttribute(std::string identifier, osg::StateAttribute *attribute)
+{
+    identifier = "attribute;" + identifier;
+
+    osg::ref_ptr<osg::StateAttribute> cached = (osg::StateAttribute *) getFromCache(identifier).get();
+
+    if (cached)
+        return cached;
+
+    storeToCache(identifier,attribute);
+    return attribute;
+}
+
+std::string OSGModelLoader::makeMaterialIdentifier(const MFFormat::DataFormatBaked4DS &model, const MFFormat::DataFormatBaked4DS::Material *material)
+{
+    // only what make4dsMaterial(...) looks at, so that materials differing in unused values get shared too
+
+    const uint32_t usedFlags =
+        MFFormat::DataFormat4DS::MATERIALFLAG_COLORKEY |
+        MFFormat::DataFormat4DS::MATERIALFLAG_ENVIRONMENTMAP |
+        MFFormat::DataFormat4DS::MATERIALFLAG_TEXTUREDIFFUSE |
+        MFFormat::DataFormat4DS::MATERIALFLAG_ALPHATEXTURE |
+        MFFormat::DataFormat4DS::MATERIALFLAG_ADDITIVETEXTUREBLEND |
+        MFFormat::DataFormat4DS::MATERIALFLAG_MULTIPLYTEXTUREBLEND |
+        MFFormat::DataFormat4DS::MATERIALFLAG_COLORED |
+        MFFormat::DataFormat4DS::MATERIALFLAG_ADDITIVEMIXING |
+        MFFormat::DataFormat4DS::MATERIALFLAG_ANIMATEDTEXTUREDIFFUSE |
+        MFFormat::DataFormat4DS::MATERIALFLAG_DOUBLESIDEDMATERIAL;
+
+    const uint32_t flags = material->mFlags & usedFlags;
+
+    bool diffuseMap = flags & MFFormat::DataFormat4DS::MATERIALFLAG_TEXTUREDIFFUSE;
+    bool alphaMap = flags & MFFormat::DataFormat4DS::MATERIALFLAG_ALPHATEXTURE;
+    bool envMap = flags & MFFormat::DataFormat4DS::MATERIALFLAG_ENVIRONMENTMAP;
+    bool colored = flags & MFFormat::DataFormat4DS::MATERIALFLAG_COLORED;
+
+    auto vecToStr = [](MFMath::Vec3 v) { return std::to_string(v.x) + "," + std::to_string(v.y) + "," + std::to_string(v.z) + ";"; };
+
+    std::string identifier = "material;" + std::to_string(flags) + ";" + vecToStr(material->mEmission);
+
+    if (!diffuseMap || colored)
+        identifier += vecToStr(material->mDiffuse) + vecToStr(material->mAmbient);
+
+    if (!alphaMap)
+        identifier += std::to_string(material->mTransparency) + ";";
+
+    if (diffuseMap || (flags & MFFormat::DataFormat4DS::MATERIALFLAG_ANIMATEDTEXTUREDIFFUSE))
+        identifier += model.getString(material->mDiffuseMapName) + ";";
+
+    if (alphaMap)
+        identifier += model.getString(material->mAlphaMapName) + ";";
+
+    if (envMap)
+        identifier += model.getString(material->mEnvMapName) + ";";
+
+    if (flags & MFFormat::DataFormat4DS::MATERIALFLAG_ANIMATEDTEXTUREDIFFUSE)
+        identifier += std::to_string(material->mFramePeriod) + "," + std::to_string(material->mAnimSequenceLength) + ";";
+
+    return identifier;
 }
 
-osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat4DS::Material *material)
+osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(const MFFormat::DataFormatBaked4DS &model, const MFFormat::DataFormatBaked4DS::Material *material)
 {
+    // identical materials of all the models share one state set, so that OSG can sort by state and skip the changes
+
+    std::string identifier = makeMaterialIdentifier(model,material);
+    osg::ref_ptr<osg::StateSet> cached = (osg::StateSet *) getFromCache(identifier).get();
+
+    if (cached)
+        return cached;
+
     osg::ref_ptr<osg::StateSet> stateSet = new osg::StateSet;
 
     auto mat = new osg::Material();
@@ -388,7 +507,7 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
         mat->setDiffuse(osg::Material::FRONT_AND_BACK,osg::Vec4f(d.x(),d.y(),d.z(),material->mTransparency));
     }
 
-    std::string diffuseTextureName = std::string(material->mDiffuseMapName,0,material->mDiffuseMapNameLength);
+    std::string diffuseTextureName = model.getString(material->mDiffuseMapName);
     std::string alphaTextureName;
     std::string envTextureName; 
 
@@ -403,19 +522,19 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
 //      else if (mixNormal)
 //          texEnv->setMode(osg::TexEnv::BLEND);   // FIXME: this doesn't look good for some reason, maybe texture format, see TexEnv docs
             
-        stateSet->setTextureAttributeAndModes(diffuseUnit,texEnv);
+        stateSet->setTextureAttributeAndModes(diffuseUnit,shareAttribute("tex env " + std::to_string(texEnv->getMode()),texEnv));
 
-        envTextureName = std::string(material->mEnvMapName,0,material->mEnvMapNameLength);
+        envTextureName = model.getString(material->mEnvMapName);
 
         osg::ref_ptr<osg::TexGen> texGen = new osg::TexGen();
         texGen->setMode(osg::TexGen::SPHERE_MAP);
-        stateSet->setTextureAttributeAndModes(envUnit,texGen);
+        stateSet->setTextureAttributeAndModes(envUnit,shareAttribute("tex gen sphere",texGen));
     }
 
     if (alphaMap)
     {
         isTransparent = true;
-        alphaTextureName = std::string(material->mAlphaMapName,0,material->mAlphaMapNameLength);
+        alphaTextureName = model.getString(material->mAlphaMapName);
     }
     else
     {
@@ -426,7 +545,7 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
             osg::ref_ptr<osg::AlphaFunc> alphaFunc = new osg::AlphaFunc;
             alphaFunc->setFunction(osg::AlphaFunc::GREATER,0.5);
             stateSet->setMode(GL_ALPHA_TEST, osg::StateAttribute::ON);
-            stateSet->setAttributeAndModes(alphaFunc,osg::StateAttribute::ON);
+            stateSet->setAttributeAndModes(shareAttribute("alpha func greater 0.5",alphaFunc),osg::StateAttribute::ON);
         }
     }
 
@@ -457,13 +576,13 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
             osg::ref_ptr<osg::BlendEquation> blendEq = new osg::BlendEquation;
             blendEq->setEquation(osg::BlendEquation::RGBA_MAX);    // FIXME: should be FUNC_ADD, but doesn't work for some reason
 
-            stateSet->setAttributeAndModes(blendEq.get(),osg::StateAttribute::ON);
+            stateSet->setAttributeAndModes(shareAttribute("blend equation max",blendEq),osg::StateAttribute::ON);
         }
         else
             blendFunc->setFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         stateSet->setMode(GL_BLEND, osg::StateAttribute::ON);
-        stateSet->setAttributeAndModes(blendFunc.get(),osg::StateAttribute::ON);
+        stateSet->setAttributeAndModes(shareAttribute(additiveBlend ? "blend func additive" : "blend func alpha",blendFunc),osg::StateAttribute::ON);
     }
     else   // opaque
     {
@@ -482,7 +601,7 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
         stateSet->setTextureAttributeAndModes(envUnit,tex.get(), osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
     }
 
-    stateSet->setAttributeAndModes(new osg::FrontFace(osg::FrontFace::CLOCKWISE));
+    stateSet->setAttributeAndModes(shareAttribute("front face cw",new osg::FrontFace(osg::FrontFace::CLOCKWISE)));
 
     if (!(material->mFlags & MFFormat::DataFormat4DS::MATERIALFLAG_DOUBLESIDEDMATERIAL))
         stateSet->setMode(GL_CULL_FACE,osg::StateAttribute::ON);
@@ -492,11 +611,13 @@ osg::ref_ptr<osg::StateSet> OSGModelLoader::make4dsMaterial(MFFormat::DataFormat
         osg::ref_ptr<osg::CullFace> cullFace = new osg::CullFace;
         cullFace->setMode(osg::CullFace::FRONT_AND_BACK);
         stateSet->setMode(GL_CULL_FACE,osg::StateAttribute::ON);
-        stateSet->setAttributeAndModes(cullFace,osg::StateAttribute::ON);
+        stateSet->setAttributeAndModes(shareAttribute("cull face front and back",cullFace),osg::StateAttribute::ON);
     }
 
     stateSet->setAttribute(mat);
 
+    storeToCache(identifier,stateSet);
+
     return stateSet;
 }
 
@@ -510,32 +631,51 @@ osg::ref_ptr<osg::Node> OSGModelLoader::load(MFFormat::DataFormat4DS *format, st
             return cached;
     }
 
+    MFFormat::DataFormatBaked4DS baked;
+    MFFormat::DataFormatBaked4DS::Source source = {};
+    baked.bake(format->getModel(),source);
+
+    return load(&baked,fileName);
+}
+
+osg::ref_ptr<osg::Node> OSGModelLoader::load(const MFFormat::DataFormatBaked4DS *baked, std::string fileName)
+{
+    if (fileName.length() > 0)
+    {
+        osg::ref_ptr<osg::Node> cached = (osg::Node *) getFromCache(fileName).get();   
+
+        if (cached)
+            return cached;
+    }
+
     std::string logStr = "loading model";
 
     osg::ref_ptr<osg::MatrixTransform> group = new osg::MatrixTransform();
     group->setName("4DS model");
 
-    auto model = format->getModel();
+    const auto &model = *baked;
+    const DataFormatBaked4DS::Mesh *modelMeshes = model.getMeshes();
         
-    logStr += ", meshes: " + std::to_string(model.mMeshCount);
-    logStr += ", materials: " + std::to_string(model.mMaterialCount);
+    logStr += ", meshes: " + std::to_string(model.getNumMeshes());
+    logStr += ", materials: " + std::to_string(model.getNumMaterials());
 
     MFLogger::Logger::info(logStr,OSG4DS_MODULE_STR);
 
     MaterialList materials;
 
-    for (int i = 0; i < model.mMaterialCount; ++i)  // load materials
+    for (int i = 0; i < (int) model.getNumMaterials(); ++i)  // load materials
     {
         MFLogger::Logger::info("  Loading material " + std::to_string(i) + ".",OSG4DS_MODULE_STR);
-        materials.push_back(make4dsMaterial(&(model.mMaterials[i])));
+        materials.push_back(make4dsMaterial(model,model.getMaterials() + i));
     }
 
     std::vector<osg::ref_ptr<osg::MatrixTransform>> meshes;
+    SkinList skins;
 
-    for (int i = 0; i < model.mMeshCount; ++i)      // load meshes
+    for (int i = 0; i < (int) model.getNumMeshes(); ++i)      // load meshes
     {
         osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform();
-        std::string meshName = MFUtil::charArrayToStr(model.mMeshes[i].mMeshName,model.mMeshes[i].mMeshNameLength);
+        std::string meshName = model.getString(modelMeshes[i].mName);
         transform->setName(meshName);  // don't mess with this name, it's needed to link with collisions etc.
 
         transform->getOrCreateUserDataContainer()->addDescription("4ds mesh");    // mark the node as a 4DS mesh
@@ -545,12 +685,15 @@ osg::ref_ptr<osg::Node> OSGModelLoader::load(MFFormat::DataFormat4DS *format, st
         MFMath::Vec3 p, s;
         MFMath::Quat r;
 
-        p = model.mMeshes[i].mPos;
-        s = model.mMeshes[i].mScale;
-        r = model.mMeshes[i].mRot;
+        p = modelMeshes[i].mPos;
+        s = modelMeshes[i].mScale;
+        r = modelMeshes[i].mRot;
 
         transform->setMatrix(makeTransformMatrix(p,s,r));
-        transform->addChild(make4dsMesh(&(model.mMeshes[i]),materials));
+        transform->addChild(make4dsMesh(model,modelMeshes + i,materials,skins));
+
+        if (modelMeshes[i].mMorphCount > 0)
+            transform->setDataVariance(osg::Object::DYNAMIC);   // kept by the optimizer, the morph frames are in the mesh space
                 
         meshes.push_back(transform);
 
@@ -558,9 +701,9 @@ osg::ref_ptr<osg::Node> OSGModelLoader::load(MFFormat::DataFormat4DS *format, st
             mNodeMap->insert(mNodeMap->begin(),std::pair<std::string,osg::ref_ptr<osg::Group>>(meshName,transform));
     }
 
-    for (int i = 0; i < model.mMeshCount; ++i)     // parent meshes
+    for (int i = 0; i < (int) model.getNumMeshes(); ++i)     // parent meshes
     {
-        unsigned int parentID = model.mMeshes[i].mParentID;
+        unsigned int parentID = modelMeshes[i].mParentID;
 
         if (parentID == 0)
             group->addChild(meshes[i]);
@@ -568,6 +711,50 @@ osg::ref_ptr<osg::Node> OSGModelLoader::load(MFFormat::DataFormat4DS *format, st
             meshes[parentID - 1]->addChild(meshes[i]);
     }
 
+    if (skins.size() > 0)
+    {
+        // Link the skinned meshes to their bones. The transforms are in the rest pose now, in which the
+        // skinning does nothing (the palette matrices are identities).
+
+        std::vector<osg::Matrixd> restPose(meshes.size());
+
+        for (int i = 0; i < (int) meshes.size(); ++i)
+        {
+            restPose[i] = meshes[i]->getMatrix();
+            unsigned int parentID = modelMeshes[i].mParentID;
+
+            for (int depth = 0; parentID != 0 && depth < (int) meshes.size(); ++depth)   // model space, guards parent cycles
+            {
+                restPose[i] = restPose[i] * meshes[parentID - 1]->getMatrix();
+                parentID = modelMeshes[parentID - 1].mParentID;
+            }
+        }
+
+        for (auto& skin : skins)
+        {
+            skin.mData->mMesh = meshes[skin.mMesh];
+            meshes[skin.mMesh]->setDataVariance(osg::Object::DYNAMIC);   // kept by the optimizer
+
+            for (uint32_t j = skin.mSkin->mFirstJoint; j < skin.mSkin->mFirstJoint + skin.mSkin->mJointCount; ++j)
+            {
+                uint32_t bone = model.getSkinJoints()[j].mBone;
+
+                if (bone == DataFormatBaked4DS::NO_BONE)
+                {
+                    skin.mData->mJoints.push_back(osg::observer_ptr<osg::MatrixTransform>());
+                    skin.mData->mInverseBindMatrices.push_back(osg::Matrixd::identity());
+                    continue;
+                }
+
+                meshes[bone]->setDataVariance(osg::Object::DYNAMIC);
+                skin.mData->mJoints.push_back(meshes[bone].get());
+                skin.mData->mInverseBindMatrices.push_back(restPose[skin.mMesh] * osg::Matrixd::inverse(restPose[bone]));
+            }
+        }
+    }
+
+    OSGTextureJobs::getInstance()->flush();   // unless a batch of models is being loaded
+
     if (fileName.length() > 0)
         storeToCache(fileName,group);
 
@@ -11,6 +11,10 @@
 #include <fstream>
 #include <algorithm>
 #include <4ds/parser_4ds.hpp>
+#include <4ds/parser_baked4ds.hpp>
+#include <4ds/osg_morph.hpp>
+#include <4ds/osg_skin.hpp>
+#include <4ds/osg_texture_jobs.hpp>
 #include <utils/logger.hpp>
 #include <utils/openmf.hpp>
 #include <renderer/osg_masks.hpp>
@@ -36,25 +40,42 @@ namespace MFFormat
 class OSGModelLoader: public OSGLoader
 {
 public:
-    osg::ref_ptr<osg::Node> load(MFFormat::DataFormat4DS *format, std::string fileName="");
+    osg::ref_ptr<osg::Node> load(MFFormat::DataFormat4DS *format, std::string fileName="");   ///< Bakes the model in memory and loads the bake.
+    osg::ref_ptr<osg::Node> load(const MFFormat::DataFormatBaked4DS *baked, std::string fileName="");
 
 protected:
     typedef std::vector<osg::ref_ptr<osg::StateSet>> MaterialList;
 
-    osg::ref_ptr<osg::Node> make4dsMesh(MFFormat::DataFormat4DS::Mesh *mesh, MaterialList &materials);
-    osg::ref_ptr<osg::StateSet> make4dsMaterial(MFFormat::DataFormat4DS::Material *material);
+    typedef struct
+    {
+        uint32_t mMesh;
+        const MFFormat::DataFormatBaked4DS::Skin *mSkin;
+        osg::ref_ptr<OSGSkinData> mData;
+    } SkinBinding;
+
+    typedef std::vector<SkinBinding> SkinList;   ///< skinned LODs, linked to the bones when all meshes are loaded
+
+    osg::ref_ptr<osg::Node> make4dsMesh(const MFFormat::DataFormatBaked4DS &model, const MFFormat::DataFormatBaked4DS::Mesh *mesh, MaterialList &materials, SkinList &skins);
+    osg::ref_ptr<osg::StateSet> make4dsMaterial(const MFFormat::DataFormatBaked4DS &model, const MFFormat::DataFormatBaked4DS::Material *material);
+    std::string makeMaterialIdentifier(const MFFormat::DataFormatBaked4DS &model, const MFFormat::DataFormatBaked4DS::Material *material);
+    osg::ref_ptr<osg::StateAttribute> shareAttribute(std::string identifier, osg::StateAttribute *attribute);   ///< Returns a cached equal attribute if there is one.
     osg::ref_ptr<osg::Node> make4dsMeshLOD(
-        MFFormat::DataFormat4DS::Lod *meshLOD,
+        const MFFormat::DataFormatBaked4DS &model,
+        const MFFormat::DataFormatBaked4DS::Lod *meshLOD,
         MaterialList &materials,
         bool isBillboard=false,
-        osg::Vec3f billboardAxis=osg::Vec3f(0,0,1));
-    osg::ref_ptr<osg::Node> make4dsFaceGroup(
+        osg::Vec3f billboardAxis=osg::Vec3f(0,0,1),
+        const MFFormat::DataFormatBaked4DS::Morph *morph=nullptr,
+        const MFFormat::DataFormatBaked4DS::Skin *skin=nullptr,
+        OSGSkinData *skinData=nullptr);
+    osg::ref_ptr<osg::Geometry> make4dsFaceGroups(     ///< face groups of one material as a single primitive set
         osg::Vec3Array *vertices,
         osg::Vec3Array *normals,
         osg::Vec2Array *uvs,
-        MFFormat::DataFormat4DS::FaceGroup *faceGroup,
-        bool isBillboard=false,
-        osg::Vec3f billboardAxis=osg::Vec3f(0,0,1));
+        const uint32_t *indices,
+        const std::vector<const MFFormat::DataFormatBaked4DS::FaceGroup *> &faceGroups,
+        OSGMorphData *morph=nullptr,
+        OSGSkinData *skin=nullptr);
     osg::ref_ptr<osg::Texture2D> loadTexture(std::string fileName, std::string fileNameAlpha="", bool colorKey=false);
 
     std::vector<std::string> makeAnimationNames(std::string baseFileName, unsigned int frames);
@@ -0,0 +1,106 @@
+#include <4ds/osg_morph.hpp>
+#include <4ds/osg_skin.hpp>
+#include <osg/Geode>
+#include <utils/osg.hpp>
+#include <utils/logger.hpp>
+
+namespace MFFormat
+{
+
+class FindMorphsVisitor: public osg::NodeVisitor
+{
+public:
+    FindMorphsVisitor(): osg::NodeVisitor()
+    {
+    }
+
+    virtual void apply(osg::Node &n) override
+    {
+        osg::Geode *geode = n.asGeode();
+
+        if (geode)
+            for (unsigned int i = 0; i < geode->getNumDrawables(); ++i)
+            {
+                osg::Referenced *data = geode->getDrawable(i)->getUserData();
+                OSGMorphData *morph = dynamic_cast<OSGMorphData *>(data);
+                OSGSkinData *skin = dynamic_cast<OSGSkinData *>(data);
+
+                if (skin)
+                    morph = skin->mMorph.get();    // morphs the bind pose
+
+                if (morph)
+                    mMorphs.insert(morph);
+            }
+
+        MFUtil::traverse(this,n);
+    }
+
+    std::unordered_set<OSGMorphData *> mMorphs;
+};
+
+size_t OSGMorphPlayer::add(osg::Node *node, float speed)
+{
+    if (!node)
+        return 0;
+
+    FindMorphsVisitor v;
+    node->accept(v);
+
+    size_t added = 0;
+
+    for (auto morph : v.mMorphs)
+    {
+        if (morph->mFrameCount == 0 || morph->mLinks.empty() || morph->mVertexArray->empty())
+            continue;      // corrupt or empty morph, nothing to play
+
+        if (!mAdded.insert(morph).second)
+            continue;      // shared by several instances of a model
+
+        MorphBatch::Target target;
+        target.mFrameCount = morph->mFrameCount;
+        target.mVertexCount = morph->mLinks.size();
+        target.mPositions = reinterpret_cast<const float *>(morph->mPositions.data());
+        target.mNormals = reinterpret_cast<const float *>(morph->mNormals.data());
+        target.mLinks = morph->mLinks.data();
+
+        mBatch.play(target,&morph->mVertexArray->front().x(),&morph->mNormalArray->front().x(),speed);
+        mMorphs.push_back(morph);
+        added++;
+    }
+
+    MFLogger::Logger::info("Playing " + std::to_string(added) + " morphed meshes.",OSGMORPH_MODULE_STR);
+    return added;
+}
+
+void OSGMorphPlayer::clear()
+{
+    mBatch = MorphBatch();
+    mMorphs.clear();
+    mAdded.clear();
+}
+
+void OSGMorphPlayer::update(double dt)
+{
+    if (mMorphs.empty())
+        return;
+
+    mBatch.advance(dt);
+
+    for (size_t i = 0; i < mMorphs.size(); ++i)
+    {
+        OSGMorphData *morph = mMorphs[i].get();
+
+        if (!morph->mVisible)
+            continue;
+
+        morph->mVisible = false;
+
+        if (mBatch.apply(i))
+        {
+            morph->mVertexArray->dirty();
+            morph->mNormalArray->dirty();
+        }
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef OSG_MORPH_PLAYER_H
+#define OSG_MORPH_PLAYER_H
+
+#include <osg/Node>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <unordered_set>
+#include <4ds/morph.hpp>
+#include <utils/math.hpp>
+
+#define OSGMORPH_MODULE_STR "player morph"
+
+namespace MFFormat
+{
+
+/**
+  Morph frames of one LOD of a loaded model, attached as user data to the LOD's geometries (see
+  OSGModelLoader). The geometries share the deformed vertex and normal arrays. For skinned meshes
+  the data belong to OSGSkinData and the arrays are the bind pose.
+*/
+
+class OSGMorphData: public osg::Referenced
+{
+public:
+    uint32_t mFrameCount;
+    std::vector<MFMath::Vec3> mPositions;        ///< frame after frame
+    std::vector<MFMath::Vec3> mNormals;
+    std::vector<uint16_t> mLinks;
+
+    osg::ref_ptr<osg::Vec3Array> mVertexArray;
+    osg::ref_ptr<osg::Vec3Array> mNormalArray;
+
+    bool mVisible = false;                       ///< drawn since the last deformation, set by the cull callback
+};
+
+/// Marks the morph data of a geometry as visible when the geometry passes culling.
+class MorphCullCallback: public osg::Drawable::CullCallback
+{
+public:
+    MorphCullCallback(OSGMorphData *morph): mMorph(morph)
+    {
+    }
+
+    virtual bool cull(osg::NodeVisitor *nv, osg::Drawable *drawable, osg::RenderInfo *renderInfo) const override
+    {
+        mMorph->mVisible = true;
+        return false;
+    }
+
+protected:
+    OSGMorphData *mMorph;       // owned by the geometry's user data
+};
+
+/**
+  Plays morph animations (curtains, flags, ...) of loaded models in a loop. Only meshes that have
+  been drawn since the previous update are deformed, the others keep their last shape.
+*/
+
+class OSGMorphPlayer
+{
+public:
+    /// Finds all morphed meshes under given node and starts playing them, returns how many were found.
+    size_t add(osg::Node *node, float speed = 1.0);
+    void clear();
+    void update(double dt);
+
+    MorphBatch *getBatch()                                      { return &mBatch;           }
+    size_t getNumMorphs() const                                 { return mMorphs.size();    }
+
+protected:
+    MorphBatch mBatch;
+    std::vector<osg::ref_ptr<OSGMorphData>> mMorphs;             ///< per batch instance
+    std::unordered_set<OSGMorphData *> mAdded;
+};
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <4ds/osg_skin.hpp>
+#include <osg/Geode>
+#include <cstring>
+#include <utils/osg.hpp>
+#include <utils/logger.hpp>
+
+namespace MFFormat
+{
+
+class FindSkinsVisitor: public osg::NodeVisitor
+{
+public:
+    FindSkinsVisitor(): osg::NodeVisitor()
+    {
+    }
+
+    virtual void apply(osg::Node &n) override
+    {
+        osg::Geode *geode = n.asGeode();
+
+        if (geode)
+            for (unsigned int i = 0; i < geode->getNumDrawables(); ++i)
+            {
+                OSGSkinData *skin = dynamic_cast<OSGSkinData *>(geode->getDrawable(i)->getUserData());
+
+                if (skin)
+                    mSkins.insert(skin);
+            }
+
+        MFUtil::traverse(this,n);
+    }
+
+    std::unordered_set<OSGSkinData *> mSkins;
+};
+
+size_t OSGSkinPlayer::add(osg::Node *node)
+{
+    if (!node)
+        return 0;
+
+    FindSkinsVisitor v;
+    node->accept(v);
+
+    size_t added = 0;
+
+    for (auto skin : v.mSkins)
+    {
+        osg::ref_ptr<osg::MatrixTransform> mesh;
+
+        if (!skin->mMesh.lock(mesh) || mesh->getParentalNodePaths().empty() || !mAdded.insert(skin).second)
+            continue;
+
+        // a model shared by several scene nodes is skinned by its first instance
+
+        Binding binding;
+        binding.mData = skin;
+        binding.mMeshPath = mesh->getParentalNodePaths()[0];
+
+        for (auto& joint : skin->mJoints)
+        {
+            osg::ref_ptr<osg::MatrixTransform> bone;
+
+            if (joint.lock(bone) && !bone->getParentalNodePaths().empty())
+                binding.mJointPaths.push_back(bone->getParentalNodePaths()[0]);
+            else
+                binding.mJointPaths.push_back(osg::NodePath());
+        }
+
+        SkinBatch::Skin target;
+        target.mVertexCount = skin->mInfluences.size();
+        target.mJointCount = skin->mJoints.size();
+        target.mPositions = &(*skin->mBindVertexArray)[skin->mFirstVertex].x();
+        target.mNormals = &(*skin->mBindNormalArray)[skin->mFirstVertex].x();
+        target.mInfluences = skin->mInfluences.data();
+
+        mBatch.add(target,&(*skin->mVertexArray)[skin->mFirstVertex].x(),&(*skin->mNormalArray)[skin->mFirstVertex].x());
+        mSkins.push_back(binding);
+        added++;
+    }
+
+    MFLogger::Logger::info("Skinning " + std::to_string(added) + " meshes.",OSGSKIN_MODULE_STR);
+    return added;
+}
+
+void OSGSkinPlayer::clear()
+{
+    mBatch.clear();
+    mSkins.clear();
+    mAdded.clear();
+}
+
+void OSGSkinPlayer::update()
+{
+    mVisible.clear();
+
+    for (size_t i = 0; i < mSkins.size(); ++i)
+    {
+        Binding &binding = mSkins[i];
+        OSGSkinData *skin = binding.mData.get();
+
+        if (!skin->mVisible)
+            continue;
+
+        skin->mVisible = false;
+
+        // palette: rest pose bone to mesh, then the current bone to mesh
+
+        osg::Matrixd worldToMesh = osg::computeWorldToLocal(binding.mMeshPath);
+        float *palette = mBatch.getPalette(i);
+
+        for (size_t j = 0; j < binding.mJointPaths.size(); ++j)
+        {
+            if (binding.mJointPaths[j].empty())
+                continue;    // stays identity
+
+            osg::Matrixf m(skin->mInverseBindMatrices[j] * osg::computeLocalToWorld(binding.mJointPaths[j]) * worldToMesh);
+            memcpy(palette + j * 16,m.ptr(),16 * sizeof(float));
+        }
+
+        mVisible.push_back(i);
+    }
+
+    mBatch.skin(mVisible);
+
+    for (auto i : mVisible)
+    {
+        mSkins[i].mData->mVertexArray->dirty();
+        mSkins[i].mData->mNormalArray->dirty();
+    }
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef OSG_SKIN_PLAYER_H
+#define OSG_SKIN_PLAYER_H
+
+#include <osg/Node>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/observer_ptr>
+#include <unordered_set>
+#include <algorithm>
+#include <4ds/skin.hpp>
+#include <4ds/osg_morph.hpp>
+#include <utils/math.hpp>
+
+#define OSGSKIN_MODULE_STR "player skin"
+
+namespace MFFormat
+{
+
+/**
+  Skinning data of one LOD of a loaded single mesh, attached as user data to the LOD's geometries
+  (see OSGModelLoader). The geometries share the deformed vertex and normal arrays. Morph frames of a
+  single morph mesh are played on the bind pose, which is then skinned.
+*/
+
+class OSGSkinData: public osg::Referenced
+{
+public:
+    uint32_t mFirstVertex;                       ///< first skinned vertex of the arrays
+    osg::ref_ptr<osg::Vec3Array> mBindVertexArray;       ///< bind pose of all the vertices
+    osg::ref_ptr<osg::Vec3Array> mBindNormalArray;
+    std::vector<SkinBatch::Influence> mInfluences;      ///< from mFirstVertex on
+    osg::ref_ptr<OSGMorphData> mMorph;           ///< morphs the bind pose, null if the mesh has no morph frames
+
+    osg::observer_ptr<osg::MatrixTransform> mMesh;                      ///< transform of the skinned mesh
+    std::vector<osg::observer_ptr<osg::MatrixTransform>> mJoints;       ///< bone of each joint, null = the mesh itself
+    std::vector<osg::Matrixd> mInverseBindMatrices;                     ///< bone to mesh transforms of the rest pose, inverted
+
+    osg::ref_ptr<osg::Vec3Array> mVertexArray;
+    osg::ref_ptr<osg::Vec3Array> mNormalArray;
+
+    bool mVisible = false;                       ///< drawn since the last skinning, set by the cull callback
+};
+
+/// Marks the skinning data of a geometry as visible when the geometry passes culling.
+class SkinCullCallback: public osg::Drawable::CullCallback
+{
+public:
+    SkinCullCallback(OSGSkinData *skin): mSkin(skin)
+    {
+    }
+
+    virtual bool cull(osg::NodeVisitor *nv, osg::Drawable *drawable, osg::RenderInfo *renderInfo) const override
+    {
+        mSkin->mVisible = true;
+
+        if (mSkin->mMorph)
+            mSkin->mMorph->mVisible = true;
+
+        return false;
+    }
+
+protected:
+    OSGSkinData *mSkin;         // owned by the geometry's user data
+};
+
+/**
+  Skins the single meshes (characters) of loaded models by the current transforms of their bones,
+  e.g. as animated by OSGAnimationPlayer. Only meshes that have been drawn since the previous update
+  are skinned, they can be spread over several threads with setNumThreads(...).
+*/
+
+class OSGSkinPlayer
+{
+public:
+    /// Finds all skinned meshes under given node and starts skinning them, returns how many were found.
+    size_t add(osg::Node *node);
+    void clear();
+    void update();
+
+    void setNumThreads(unsigned int threads)                    { mBatch.setNumThreads(threads); }
+    SkinBatch *getBatch()                                       { return &mBatch;           }
+    size_t getNumSkins() const                                  { return mSkins.size();     }
+
+protected:
+    typedef struct
+    {
+        osg::ref_ptr<OSGSkinData> mData;
+        osg::NodePath mMeshPath;
+        std::vector<osg::NodePath> mJointPaths;  ///< empty for joints moved by the mesh itself
+    } Binding;
+
+    SkinBatch mBatch;
+    std::vector<Binding> mSkins;                 ///< per batch instance
+    std::unordered_set<OSGSkinData *> mAdded;
+    std::vector<uint32_t> mVisible;
+};
+
+}
+
+#endif
@@ -0,0 +1,350 @@
+#include <4ds/osg_texture_jobs.hpp>
+#include <vfs/vfs.hpp>
+#include <utils/osg.hpp>
+#include <utils/logger.hpp>
+#include <utils/bmp_analyser.hpp>
+#include <dds/parser_dds.hpp>
+#include <4ds/parser_baked4ds.hpp>
+#include <osg/Texture>
+#include <filesystem>
+#include <cstring>
+
+namespace MFFormat
+{
+
+OSGTextureJobs::OSGTextureJobs()
+{
+    mThreads = 0;
+    mRunning = 0;
+    mStop = false;
+    mBatches = 0;
+}
+
+OSGTextureJobs::~OSGTextureJobs()
+{
+    stopWorkers();
+}
+
+void OSGTextureJobs::setNumThreads(unsigned int threads)
+{
+    flush();
+    stopWorkers();
+
+    mThreads = threads;
+    mStop = false;
+
+    for (auto& job : mJobs)        // added without workers during a batch
+        if (!job->mDone && mThreads > 0)
+            mQueue.push_back(job.get());
+
+    for (unsigned int i = 0; i < mThreads; ++i)
+        mWorkers.push_back(std::thread(&OSGTextureJobs::work,this));
+}
+
+bool OSGTextureJobs::enableBaking(std::string directory)
+{
+    MFFile::FileSystem *fileSystem = MFFile::FileSystem::getInstance();
+
+    if (directory.length() == 0)
+        directory = fileSystem->getUserDir().length() > 0 ? fileSystem->getUserDir() + "/textures" : "textures";
+
+    std::error_code error;
+    std::filesystem::create_directories(directory,error);
+
+    if (!std::filesystem::is_directory(directory,error))
+    {
+        MFLogger::Logger::warn("Could not create directory for baked textures: " + directory + ".",OSGTEXTUREJOBS_MODULE_STR);
+        return false;
+    }
+
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mBatches > 0)       // the workers read the directory, flush() didn't wait for them
+        {
+            MFLogger::Logger::warn("Could not enable texture baking while a batch of textures is being loaded.",OSGTEXTUREJOBS_MODULE_STR);
+            return false;
+        }
+
+        mBakeDirectory = directory;
+    }
+
+    fileSystem->excludeFromIndex(directory);
+    return true;
+}
+
+void OSGTextureJobs::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mJobAdded.notify_all();
+
+    for (auto& worker : mWorkers)
+        worker.join();
+
+    mWorkers.clear();
+}
+
+void OSGTextureJobs::add(osg::Texture2D *texture, std::string filePath, std::string filePathAlpha, bool colorKey)
+{
+    std::unique_ptr<Job> job(new Job);
+    job->mTexture = texture;
+    job->mFilePath = filePath;
+    job->mFilePathAlpha = filePathAlpha;
+    job->mColorKey = colorKey;
+    job->mDone = false;
+    job->mFromBake = false;
+    job->mBakeFailed = false;
+
+    MFFile::FileSystem *fileSystem = MFFile::FileSystem::getInstance();   // either from disk or from a DTA archive
+
+    job->mRead = filePath.length() > 0 && fileSystem->read(filePath,job->mData);
+    job->mReadAlpha = filePathAlpha.length() > 0 && fileSystem->read(filePathAlpha,job->mDataAlpha);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mWorkers.size() > 0)
+    {
+        mQueue.push_back(job.get());
+        mJobAdded.notify_one();
+    }
+
+    mJobs.push_back(std::move(job));
+}
+
+void OSGTextureJobs::work()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (true)
+    {
+        mJobAdded.wait(lock,[this]() { return mStop || !mQueue.empty(); });
+
+        if (mQueue.empty())
+            return;    // stopped
+
+        Job *job = mQueue.front();
+        mQueue.pop_front();
+        mRunning++;
+
+        lock.unlock();
+        decode(*job);
+        lock.lock();
+
+        mRunning--;
+        mJobDone.notify_all();
+    }
+}
+
+size_t OSGTextureJobs::flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mBatches > 0 || mJobs.empty())
+        return 0;
+
+    if (mWorkers.empty())
+    {
+        lock.unlock();
+
+        for (auto& job : mJobs)
+            if (!job->mDone)
+                decode(*job);
+
+        lock.lock();
+    }
+    else
+    {
+        while (!mQueue.empty())      // help the workers instead of just waiting
+        {
+            Job *job = mQueue.front();
+            mQueue.pop_front();
+
+            lock.unlock();
+            decode(*job);
+            lock.lock();
+        }
+
+        mJobDone.wait(lock,[this]() { return mRunning == 0; });
+    }
+
+    std::vector<std::unique_ptr<Job>> jobs;
+    jobs.swap(mJobs);
+    lock.unlock();
+
+    size_t fromBake = 0;
+
+    for (auto& job : jobs)
+    {
+        fromBake += job->mFromBake ? 1 : 0;
+
+        if (job->mBakeFailed)
+            MFLogger::Logger::warn("Could not save baked texture: " + job->mBakeFileName,OSGTEXTUREJOBS_MODULE_STR);
+
+        if (job->mFilePath.length() > 0 && !job->mRead)
+            MFLogger::Logger::warn("Could not load texture: " + job->mFilePath,OSGTEXTUREJOBS_MODULE_STR);
+
+        if (job->mFilePathAlpha.length() > 0 && !job->mReadAlpha)
+            MFLogger::Logger::warn("Could not load alpha texture: " + job->mFilePathAlpha,OSGTEXTUREJOBS_MODULE_STR);
+
+        job->mTexture->setImage(job->mImage);
+    }
+
+    if (fromBake > 0)
+        MFLogger::Logger::info("Loaded " + std::to_string(fromBake) + " of " + std::to_string(jobs.size()) + " textures from the bakes.",OSGTEXTUREJOBS_MODULE_STR);
+
+    return jobs.size();
+}
+
+void OSGTextureJobs::beginBatch()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBatches++;
+}
+
+size_t OSGTextureJobs::endBatch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mBatches > 0)
+            mBatches--;
+    }
+
+    return flush();
+}
+
+size_t OSGTextureJobs::getNumPending()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mJobs.size();
+}
+
+std::string OSGTextureJobs::getBakeFileName(const Job &job) const
+{
+    std::string key =
+        std::to_string(job.mFilePath.length() > 0 ? DataFormatBaked4DS::hash(job.mData.data(),job.mData.size()) : 0) + ";" +
+        std::to_string(job.mFilePathAlpha.length() > 0 ? DataFormatBaked4DS::hash(job.mDataAlpha.data(),job.mDataAlpha.size()) : 0) + ";" +
+        (job.mColorKey ? "1;" : "0;") + std::to_string(BAKE_VERSION);
+
+    char name[32];
+    snprintf(name,sizeof(name),"%016llx.dds",(unsigned long long) DataFormatBaked4DS::hash(key.data(),key.length()));
+    return mBakeDirectory + "/" + name;
+}
+
+/// Makes an image of all the mip levels of a compressed texture.
+static osg::ref_ptr<osg::Image> makeImage(const DataFormatDDS &dds)
+{
+    const GLenum format = dds.getFormat() == DataFormatDDS::FORMAT_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    unsigned char *data = new unsigned char[dds.getSize()];
+    memcpy(data,dds.getData(),dds.getSize());
+
+    osg::ref_ptr<osg::Image> img = new osg::Image;
+    img->setImage(dds.getWidth(),dds.getHeight(),1,format,format,GL_UNSIGNED_BYTE,data,osg::Image::USE_NEW_DELETE);
+
+    osg::Image::MipmapDataType mipmaps;
+
+    for (unsigned int i = 1; i < dds.getNumLevels(); ++i)
+        mipmaps.push_back(dds.getLevelOffset(i));
+
+    img->setMipmapLevels(mipmaps);
+    return img;
+}
+
+void OSGTextureJobs::decode(Job &job)
+{
+    osg::ref_ptr<osg::Image> img;
+
+    // only complete textures get baked, the files are read while the paths are searched, so the hashes cost little
+
+    bool bake = mBakeDirectory.length() > 0 &&
+        (job.mRead || job.mFilePath.length() == 0) &&
+        (job.mReadAlpha || job.mFilePathAlpha.length() == 0) &&
+        (job.mRead || job.mReadAlpha);
+
+    if (bake)
+    {
+        job.mBakeFileName = getBakeFileName(job);
+
+        std::ifstream bakeFile(job.mBakeFileName,std::ios::binary);
+        DataFormatDDS dds;
+
+        if (bakeFile.good() && dds.load(bakeFile))
+        {
+            job.mImage = makeImage(dds);
+            job.mFromBake = true;
+            job.mData.clear();
+            job.mDataAlpha.clear();
+            job.mDone = true;
+            return;
+        }
+    }
+
+    if (job.mRead)
+    {
+        img = MFUtil::readImage(job.mFilePath,job.mData.data(),job.mData.size());
+
+        MFFormat::BMPInfo bmp;
+
+        if (job.mColorKey && img && bmp.load(job.mData.data(),job.mData.size()))   // the key is the first palette color
+        {
+            osg::Vec3ub transparentColor(
+                bmp.mTransparentColor.r,
+                bmp.mTransparentColor.g,
+                bmp.mTransparentColor.b);
+
+            img = MFUtil::applyColorKey(img.get(),transparentColor,10);
+        }
+    }
+
+    if (job.mReadAlpha)
+    {
+        osg::ref_ptr<osg::Image> imgAlpha = MFUtil::readImage(job.mFilePathAlpha,job.mDataAlpha.data(),job.mDataAlpha.size());
+
+        if (!imgAlpha)
+            job.mReadAlpha = false;    // reported by flush()
+        else
+        {
+            if (!img)
+            {
+                img = new osg::Image;
+                img->allocateImage(imgAlpha->s(),imgAlpha->t(),1,GL_RGBA,GL_UNSIGNED_BYTE);
+                memset(img->data(),255,img->getTotalSizeInBytes());
+            }
+
+            img = MFUtil::addAlphaFromImage(img.get(),imgAlpha.get());
+        }
+    }
+
+    if (bake && img && img->s() > 0 && img->t() > 0)
+    {
+        osg::ref_ptr<osg::Image> rgba = img;
+
+        if (img->getPixelFormat() != GL_RGBA || img->getDataType() != GL_UNSIGNED_BYTE || img->getPacking() != 1)
+            rgba = MFUtil::convertToRGBA(img.get());
+
+        DataFormatDDS dds;
+
+        if (dds.compress(rgba->data(),rgba->s(),rgba->t()))
+        {
+            job.mBakeFailed = !dds.save(job.mBakeFileName);
+            img = makeImage(dds);
+        }
+    }
+
+    job.mData.clear();          // the files aren't needed any more
+    job.mData.shrink_to_fit();
+    job.mDataAlpha.clear();
+    job.mDataAlpha.shrink_to_fit();
+
+    job.mImage = img;
+    job.mDone = true;
+}
+
+}
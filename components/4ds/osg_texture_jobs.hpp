@@ -0,0 +1,103 @@
+#ifndef OSG_TEXTURE_JOBS_H
+#define OSG_TEXTURE_JOBS_H
+
+#include <osg/Image>
+#include <osg/Texture2D>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define OSGTEXTUREJOBS_MODULE_STR "texture jobs"
+
+namespace MFFormat
+{
+
+/**
+  Decodes textures of loaded models on a pool of worker threads. The loaders create the textures
+  empty and add a job for each, the workers decode the images, merge the alpha maps and apply the
+  color keys, and flush() attaches the finished images to the textures on the calling thread.
+
+  While a batch is open (e.g. during a mission load) flush() does nothing, so the decoding of all
+  the models overlaps with the loading, the images are attached by endBatch().
+
+  With baking enabled the decoded images are compressed to BC1/BC3 with all mip levels and stored as
+  DDS files named by the hash of the source files, later loads take the DDS files instead.
+*/
+
+class OSGTextureJobs
+{
+public:
+    OSGTextureJobs();
+    ~OSGTextureJobs();
+
+    static OSGTextureJobs *getInstance()
+    {
+        static OSGTextureJobs sTextureJobs;
+        return &sTextureJobs;
+    }
+
+    /// Number of worker threads, 0 = decode on the thread calling flush().
+    void setNumThreads(unsigned int threads);
+
+    /// Keep compressed textures in given directory (~/.openmf/textures on Linux and "textures" elsewhere by default), fails while a batch is open.
+    bool enableBaking(std::string directory = "");
+
+    /**
+      Reads the files (on the calling thread, the file system isn't thread safe) and queues the decoding
+      of the texture's image. Empty path means no image of that kind.
+    */
+    void add(osg::Texture2D *texture, std::string filePath, std::string filePathAlpha="", bool colorKey=false);
+
+    size_t flush();              ///< Waits for the queued jobs and attaches the images, returns how many.
+    void beginBatch();
+    size_t endBatch();           ///< Closes the batch and flushes when no other batch is open.
+
+    size_t getNumPending();
+
+protected:
+    typedef struct
+    {
+        osg::ref_ptr<osg::Texture2D> mTexture;
+        std::string mFilePath;
+        std::string mFilePathAlpha;
+        bool mColorKey;
+        std::vector<char> mData;             ///< whole files
+        std::vector<char> mDataAlpha;
+        bool mRead;
+        bool mReadAlpha;
+        osg::ref_ptr<osg::Image> mImage;
+        bool mDone;
+        bool mFromBake;
+        bool mBakeFailed;
+        std::string mBakeFileName;
+    } Job;
+
+    static const uint32_t BAKE_VERSION = 1;  ///< part of the bake names, change when the decoding changes
+
+    void decode(Job &job);
+    std::string getBakeFileName(const Job &job) const;
+
+    void stopWorkers();
+    void work();
+
+    std::vector<std::thread> mWorkers;
+    unsigned int mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mJobAdded;
+    std::condition_variable mJobDone;
+    std::deque<Job *> mQueue;                ///< waiting for a worker
+    std::vector<std::unique_ptr<Job>> mJobs;    ///< all not yet flushed, in the order of adding
+    size_t mRunning;
+    bool mStop;
+    unsigned int mBatches;
+    std::string mBakeDirectory;              ///< empty = no baking
+};
+
+}
+
+#endif
@@ -3,11 +3,19 @@
 namespace MFFormat
 {
 
-void DataFormat4DS::loadMaterial(Model *model, std::ifstream &file)
+DataFormat4DS::PoolString DataFormat4DS::loadString(Model *model, BinaryReader &file)
+{
+    uint8_t length = 0;
+    read(file, &length);
+    const char *str = file.skip(length);
+    return str ? model->mStrings.intern(str, length) : PoolString {0, 0};
+}
+
+void DataFormat4DS::loadMaterial(Model *model, BinaryReader &file)
 {
     read(file, &model->mMaterialCount);
     
-    for(size_t i = 0; i < model->mMaterialCount; ++i) 
+    for(size_t i = 0; i < model->mMaterialCount && file.good(); ++i) 
     {
         Material mat = {};
         read(file, &mat.mFlags);
@@ -19,18 +27,14 @@ void DataFormat4DS::loadMaterial(Model *model, std::ifstream &file)
         if(mat.mFlags & MATERIALFLAG_ENVIRONMENTMAP) 
         {
             read(file, &mat.mEnvRatio);
-            read(file, &mat.mEnvMapNameLength);
-            read(file, &mat.mEnvMapName, mat.mEnvMapNameLength);
+            mat.mEnvMapName = loadString(model, file);
         }
 
-        read(file, &mat.mDiffuseMapNameLength);
-        read(file, mat.mDiffuseMapName, mat.mDiffuseMapNameLength);
-       
+        mat.mDiffuseMapName = loadString(model, file);
             
         if(mat.mFlags & MATERIALFLAG_ALPHATEXTURE)
         {
-            read(file, &mat.mAlphaMapNameLength);
-            read(file, mat.mAlphaMapName, mat.mAlphaMapNameLength);
+            mat.mAlphaMapName = loadString(model, file);
         }
         
         if(mat.mFlags & MATERIALFLAG_ANIMATEDTEXTUREDIFFUSE)
@@ -46,33 +50,22 @@ void DataFormat4DS::loadMaterial(Model *model, std::ifstream &file)
     }  
 }
 
-DataFormat4DS::Lod DataFormat4DS::loadLod(std::ifstream &file)
+DataFormat4DS::Lod DataFormat4DS::loadLod(Model *model, BinaryReader &file)
 {
     Lod newLod = {};
     read(file, &newLod.mRelativeDistance);
     read(file, &newLod.mVertexCount);
-
-    for (size_t i = 0; i < newLod.mVertexCount; ++i)
-    {
-        Vertex v;
-        read(file,&v,sizeof(v));
-        newLod.mVertices.push_back(v);
-    }
-
+    newLod.mVertexOffset = model->mVertices.size();
+    readArray(file, model->mVertices, newLod.mVertexCount);
     read(file, &newLod.mFaceGroupCount); 
+    newLod.mFaceGroups.reserve(newLod.mFaceGroupCount);
 
-    for (size_t i = 0; i < newLod.mFaceGroupCount; ++i)
+    for (size_t i = 0; i < newLod.mFaceGroupCount && file.good(); ++i)
     {
         FaceGroup newFaceGroup = {};
         read(file, &newFaceGroup.mFaceCount);
-
-        for (size_t j = 0; j < newFaceGroup.mFaceCount; ++j)
-        {
-           Face f;
-           read(file,&f,sizeof(f));
-           newFaceGroup.mFaces.push_back(f);
-        }
-
+        newFaceGroup.mFaceOffset = model->mFaces.size();
+        readArray(file, model->mFaces, newFaceGroup.mFaceCount);
         read(file, &newFaceGroup.mMaterialID);
         newLod.mFaceGroups.push_back(newFaceGroup);
     }
@@ -80,7 +73,7 @@ DataFormat4DS::Lod DataFormat4DS::loadLod(std::ifstream &file)
     return newLod;
 }
 
-DataFormat4DS::Standard DataFormat4DS::loadStandard(std::ifstream &file)
+DataFormat4DS::Standard DataFormat4DS::loadStandard(Model *model, BinaryReader &file)
 {
     Standard newStandard = {};
     read(file, &newStandard.mInstanced);
@@ -89,10 +82,12 @@ DataFormat4DS::Standard DataFormat4DS::loadStandard(std::ifstream &file)
     {
         read(file, &newStandard.mLODLevel);
 
-        for(size_t i = 0; i < newStandard.mLODLevel; ++i)
+        newStandard.mLODs.reserve(newStandard.mLODLevel);
+
+        for(size_t i = 0; i < newStandard.mLODLevel && file.good(); ++i)
         {
             Lod newLod = {};
-            newLod = loadLod(file);
+            newLod = loadLod(model, file);
             newStandard.mLODs.push_back(newLod);
         }
     }
@@ -100,7 +95,7 @@ DataFormat4DS::Standard DataFormat4DS::loadStandard(std::ifstream &file)
     return newStandard;
 }
 
-DataFormat4DS::Mirror DataFormat4DS::loadMirror(std::ifstream &file)
+DataFormat4DS::Mirror DataFormat4DS::loadMirror(BinaryReader &file)
 {
     Mirror newMirror = {};
     read(file, &newMirror.mMinBox);
@@ -111,30 +106,18 @@ DataFormat4DS::Mirror DataFormat4DS::loadMirror(std::ifstream &file)
     read(file, &newMirror.mViewDistance);
     read(file, &newMirror.mVertexCount);
     read(file, &newMirror.mFaceCount);
-
-    for (size_t i = 0; i < newMirror.mVertexCount; ++i)
-    {
-        MFMath::Vec3 v;
-        read(file,&v,sizeof(v));
-        newMirror.mVertices.push_back(v);
-    }
-
-    for (size_t i = 0; i < newMirror.mFaceCount; ++i)
-    {
-        Face f;
-        read(file,&f,sizeof(f));
-        newMirror.mFaces.push_back(f);
-    }
+    readArray(file, newMirror.mVertices, newMirror.mVertexCount);
+    readArray(file, newMirror.mFaces, newMirror.mFaceCount);
 
     return newMirror;
 }
 
-DataFormat4DS::Glow DataFormat4DS::loadGlow(std::ifstream &file)
+DataFormat4DS::Glow DataFormat4DS::loadGlow(BinaryReader &file)
 {
     Glow newGlow = {};
     read(file, &newGlow.mGlowCount);
     
-    for (size_t i = 0; i < newGlow.mGlowCount; ++i)
+    for (size_t i = 0; i < newGlow.mGlowCount && file.good(); ++i)
     {
         GlowData newGlow_data = {};
         read(file, &newGlow_data.mPosition);
@@ -145,50 +128,32 @@ DataFormat4DS::Glow DataFormat4DS::loadGlow(std::ifstream &file)
     return newGlow;
 }
 
-DataFormat4DS::Portal DataFormat4DS::loadPortal(std::ifstream &file)
+DataFormat4DS::Portal DataFormat4DS::loadPortal(BinaryReader &file)
 {
     Portal newPortal = {};
     read(file, &newPortal.mVertexCount);
     read(file, &newPortal.mUnk0);
     read(file, newPortal.mUnk1, sizeof(float) * 6);
-
-    for (size_t i = 0; i < newPortal.mVertexCount; ++i)
-    {
-        MFMath::Vec3 v;
-        read(file,&v,sizeof(v));
-        newPortal.mVertices.push_back(v);
-    }
+    readArray(file, newPortal.mVertices, newPortal.mVertexCount);
    
     return newPortal;
 }
 
-DataFormat4DS::Sector DataFormat4DS::loadSector(std::ifstream &file)
+DataFormat4DS::Sector DataFormat4DS::loadSector(BinaryReader &file)
 {
     Sector newSector = {};
     read(file, &newSector.mUnk0);
     read(file, &newSector.mUnk1);
     read(file, &newSector.mVertexCount);
     read(file, &newSector.mFaceCount);
-
-    for (size_t i = 0; i < newSector.mVertexCount; ++i)
-    {
-        MFMath::Vec3 v;
-        read(file,&v,sizeof(v));
-        newSector.mVertices.push_back(v);
-    }
-
-    for (size_t i = 0; i < newSector.mFaceCount; ++i)
-    {
-        Face f;
-        read(file,&f,sizeof(f));
-        newSector.mFaces.push_back(f);
-    }
+    readArray(file, newSector.mVertices, newSector.mVertexCount);
+    readArray(file, newSector.mFaces, newSector.mFaceCount);
 
     read(file, &newSector.mMinBox);
     read(file, &newSector.mMaxBox);
     read(file, &newSector.mPortalCount);
 
-    for(size_t i = 0; i < newSector.mPortalCount; ++i) 
+    for(size_t i = 0; i < newSector.mPortalCount && file.good(); ++i) 
     {
         Portal newPortal = {};
         newPortal = loadPortal(file);
@@ -198,29 +163,23 @@ DataFormat4DS::Sector DataFormat4DS::loadSector(std::ifstream &file)
     return newSector;
 }
 
-DataFormat4DS::Target DataFormat4DS::loadTarget(std::ifstream &file)
+DataFormat4DS::Target DataFormat4DS::loadTarget(BinaryReader &file)
 {
     Target newTarget = {};
     read(file, &newTarget.mUnk0);
     read(file, &newTarget.mTargetCount);
-   
-    for (size_t i = 0; i < newTarget.mTargetCount; ++i)
-    {
-        uint16_t t;
-        read(file,&t,sizeof(t));
-        newTarget.mTargets.push_back(t);
-    }
+    readArray(file, newTarget.mTargets, newTarget.mTargetCount);
  
     return newTarget;
 }
 
-DataFormat4DS::Morph DataFormat4DS::loadMorph(std::ifstream &file, bool ignoreStandard)
+DataFormat4DS::Morph DataFormat4DS::loadMorph(Model *model, BinaryReader &file, bool ignoreStandard)
 {
     Morph newMorph = { };
     // NOTE(zaklaus): Single Morph contains Standard Mesh in Single Mesh already.
     if (!ignoreStandard) 
     {
-        newMorph.mStandard = loadStandard(file);
+        newMorph.mStandard = loadStandard(model, file);
     } 
     // NOTE(zaklaus): ELSE ignore Standard Mesh, since Single Mesh has it.
     
@@ -231,29 +190,18 @@ DataFormat4DS::Morph DataFormat4DS::loadMorph(std::ifstream &file, bool ignoreSt
         read(file, &newMorph.mLODLevel);
         read(file, &newMorph.mUnk0);
 
-        for (size_t i = 0; i < newMorph.mLODLevel; ++i) 
+        for (size_t i = 0; i < newMorph.mLODLevel && file.good(); ++i) 
         {
             MorphLod newMorphLod = {};
             read(file, &newMorphLod.mVertexCount);
-
-            for (size_t j = 0; j < newMorph.mFrameCount * newMorphLod.mVertexCount; ++j)
-            {
-                MorphLodVertex v;
-                read(file,&v,sizeof(v));
-                newMorphLod.mVertices.push_back(v);
-            }
+            readArray(file, newMorphLod.mVertices, newMorph.mFrameCount * newMorphLod.mVertexCount);
 
             if (newMorphLod.mVertexCount * newMorph.mFrameCount) 
             {
                 read(file, &newMorphLod.mUnk0);
             }
 
-            for (size_t j = 0; j < newMorphLod.mVertexCount; ++j)
-            {
-                uint16_t v;
-                read(file,&v,sizeof(v));
-                newMorphLod.mVertexLinks.push_back(v);
-            }
+            readArray(file, newMorphLod.mVertexLinks, newMorphLod.mVertexCount);
 
             newMorph.mLODs.push_back(newMorphLod);
         }
@@ -266,7 +214,7 @@ DataFormat4DS::Morph DataFormat4DS::loadMorph(std::ifstream &file, bool ignoreSt
     return newMorph;
 }
 
-DataFormat4DS::SingleMeshLodJoint DataFormat4DS::loadSingleMeshLodJoint(std::ifstream &file)
+DataFormat4DS::SingleMeshLodJoint DataFormat4DS::loadSingleMeshLodJoint(BinaryReader &file)
 {
     SingleMeshLodJoint newJoint = {};
     read(file, &newJoint.mTransform);
@@ -275,18 +223,12 @@ DataFormat4DS::SingleMeshLodJoint DataFormat4DS::loadSingleMeshLodJoint(std::ifs
     read(file, &newJoint.mBoneID);
     read(file, &newJoint.mMinBox);
     read(file, &newJoint.mMaxBox);
-  
-    for (size_t i = 0; i < newJoint.mWeightCount; ++i)
-    {
-        float f;
-        read(file, &f, sizeof(f));
-        newJoint.mWeights.push_back(f);
-    }
+    readArray(file, newJoint.mWeights, newJoint.mWeightCount);
 
     return newJoint;
 }
 
-DataFormat4DS::SingleMeshLod DataFormat4DS::loadSingleMeshLod(std::ifstream &file)
+DataFormat4DS::SingleMeshLod DataFormat4DS::loadSingleMeshLod(BinaryReader &file)
 {
     // Every LOD's vertext buffer is sorted in the following order:
     // - non-weighted vertices
@@ -301,7 +243,9 @@ DataFormat4DS::SingleMeshLod DataFormat4DS::loadSingleMeshLod(std::ifstream &fil
     read(file, &newLod.mMinBox);
     read(file, &newLod.mMaxBox);
 
-    for (size_t i = 0; i < newLod.mJointCount; ++i) 
+    newLod.mJoints.reserve(newLod.mJointCount);
+
+    for (size_t i = 0; i < newLod.mJointCount && file.good(); ++i) 
     {
         SingleMeshLodJoint newJoint = {};
         newJoint = loadSingleMeshLodJoint(file);
@@ -311,13 +255,13 @@ DataFormat4DS::SingleMeshLod DataFormat4DS::loadSingleMeshLod(std::ifstream &fil
     return newLod;
 }
 
-DataFormat4DS::SingleMesh DataFormat4DS::loadSingleMesh(std::ifstream &file)
+DataFormat4DS::SingleMesh DataFormat4DS::loadSingleMesh(Model *model, BinaryReader &file)
 {
     SingleMesh newMesh = {};
     
-    newMesh.mStandard = loadStandard(file);
+    newMesh.mStandard = loadStandard(model, file);
     
-    for(size_t i = 0; i < newMesh.mStandard.mLODLevel; ++i) 
+    for(size_t i = 0; i < newMesh.mStandard.mLODLevel && file.good(); ++i) 
     {
         SingleMeshLod newLod = {};
         newLod = loadSingleMeshLod(file);
@@ -327,20 +271,20 @@ DataFormat4DS::SingleMesh DataFormat4DS::loadSingleMesh(std::ifstream &file)
     return newMesh;
 }
 
-DataFormat4DS::SingleMorph DataFormat4DS::loadSingleMorph(std::ifstream &file)
+DataFormat4DS::SingleMorph DataFormat4DS::loadSingleMorph(Model *model, BinaryReader &file)
 {
     SingleMorph newMorph = {};
-    newMorph.mSingleMesh = loadSingleMesh(file);
+    newMorph.mSingleMesh = loadSingleMesh(model, file);
 
-    newMorph.mMorph = loadMorph(file, 1);
+    newMorph.mMorph = loadMorph(model, file, 1);
     return newMorph;
 }
 
-void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
+void DataFormat4DS::loadMesh(Model *model, BinaryReader &file)
 {
     read(file, &model->mMeshCount);
 
-    for (size_t i = 0; i < model->mMeshCount; ++i)
+    for (size_t i = 0; i < model->mMeshCount && file.good(); ++i)
     {
         Mesh newMesh = {};
         read(file, &newMesh.mMeshType);
@@ -359,10 +303,8 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
         newMesh.mRot.fromMafia();
 
         read(file, &newMesh.mCullingFlags);
-        read(file, &newMesh.mMeshNameLength);
-        read(file, newMesh.mMeshName, newMesh.mMeshNameLength);
-        read(file, &newMesh.mMeshParamsLength);
-        read(file, newMesh.mMeshParams, newMesh.mMeshParamsLength);
+        newMesh.mMeshName = loadString(model, file);
+        newMesh.mMeshParams = loadString(model, file);
 
         switch(newMesh.mMeshType)
         {
@@ -372,59 +314,54 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
                 {
                     case VISUALMESHTYPE_STANDARD:
                     {
-                        Standard newStandard = {};
-                        newStandard = loadStandard(file);
-                        newMesh.mStandard = newStandard;
+                        newMesh.mDataIndex = model->mStandards.size();
+                        model->mStandards.push_back(loadStandard(model, file));
                     } 
                     break;
 
                     case VISUALMESHTYPE_MIRROR:
                     {
-                        Mirror newMirror = {};
-                        newMirror = loadMirror(file);
-                        newMesh.mMirror = newMirror;
+                        newMesh.mDataIndex = model->mMirrors.size();
+                        model->mMirrors.push_back(loadMirror(file));
                     } 
                     break;
 
                     case VISUALMESHTYPE_GLOW:
                     {
-                        Glow newGlow = {};
-                        newGlow = loadGlow(file);
-                        newMesh.mGlow = newGlow;
+                        newMesh.mDataIndex = model->mGlows.size();
+                        model->mGlows.push_back(loadGlow(file));
                     } 
                     break;
 
                     case VISUALMESHTYPE_BILLBOARD:
                     {
                         Billboard new_billboard = {};
-                        new_billboard.mStandard = loadStandard(file);
+                        new_billboard.mStandard = loadStandard(model, file);
                         read(file, &new_billboard.mRotationAxis);
                         read(file, &new_billboard.mIgnoreCamera);
-                        newMesh.mBillboard = new_billboard;
+                        newMesh.mDataIndex = model->mBillboards.size();
+                        model->mBillboards.push_back(new_billboard);
                     } 
                     break;
                     
                     case VISUALMESHTYPE_MORPH:
                     {
-                        Morph newMorph = {};
-                        newMorph = loadMorph(file, 0);
-                        newMesh.mMorph = newMorph;
+                        newMesh.mDataIndex = model->mMorphs.size();
+                        model->mMorphs.push_back(loadMorph(model, file, 0));
                     }
                     break;
                                 
                     case VISUALMESHTYPE_SINGLEMESH:
                     {
-                        SingleMesh new_single_mesh = {};
-                        new_single_mesh = loadSingleMesh(file);
-                        newMesh.mSingleMesh = new_single_mesh;
+                        newMesh.mDataIndex = model->mSingleMeshes.size();
+                        model->mSingleMeshes.push_back(loadSingleMesh(model, file));
                     }
                     break;
                     
                     case VISUALMESHTYPE_SINGLEMORPH:
                     {
-                        SingleMorph new_single_morph = {};
-                        new_single_morph = loadSingleMorph(file);
-                        newMesh.mSingleMorph = new_single_morph;
+                        newMesh.mDataIndex = model->mSingleMorphs.size();
+                        model->mSingleMorphs.push_back(loadSingleMorph(model, file));
                     }
                     break;
 
@@ -441,23 +378,22 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
                 Dummy newDummy = {};
                 read(file, &newDummy.mMinBox);
                 read(file, &newDummy.mMaxBox);
-                newMesh.mDummy = newDummy;
+                newMesh.mDataIndex = model->mDummies.size();
+                model->mDummies.push_back(newDummy);
             }
             break;
             
             case MESHTYPE_SECTOR:
             {
-                Sector newSector = {};
-                newSector = loadSector(file);
-                newMesh.mSector = newSector;
+                newMesh.mDataIndex = model->mSectors.size();
+                model->mSectors.push_back(loadSector(file));
             }
             break;
             
             case MESHTYPE_TARGET:
             {
-                Target newTarget = {};
-                newTarget = loadTarget(file);
-                newMesh.mTarget = newTarget;
+                newMesh.mDataIndex = model->mTargets.size();
+                model->mTargets.push_back(loadTarget(file));
             }
             break;
             
@@ -466,7 +402,8 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
                 Bone newBone = {};
                 read(file, &newBone.mTransform);
                 read(file, &newBone.mBoneID);
-                newMesh.mBone = newBone;
+                newMesh.mDataIndex = model->mBones.size();
+                model->mBones.push_back(newBone);
             }
             break;
 
@@ -479,8 +416,7 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
 
         // NOTE(zaklaus): Check whether this is a collision mesh.
         // happens AFTER we load the required content to skip it.
-        std::string meshName = std::string(newMesh.mMeshName);
-        if (meshName.find("wcol") != meshName.npos)
+        if (strstr(model->mStrings.get(newMesh.mMeshName), "wcol"))
         {
             newMesh.mMeshType = MESHTYPE_COLLISION;
         }
@@ -489,9 +425,63 @@ void DataFormat4DS::loadMesh(Model *model, std::ifstream &file)
     }
 }
 
-DataFormat4DS::Model DataFormat4DS::loadModel(std::ifstream &file)
+void DataFormat4DS::indexMeshes(Model *model)
 {
-    Model model;
+    const size_t meshCount = model->mMeshes.size();
+
+    model->mWorldTransforms.assign(meshCount,MFMath::identity);
+    model->mMeshIndices.clear();
+    model->mMeshIndices.reserve(meshCount);
+
+    for (size_t i = 0; i < meshCount; ++i)
+        model->mMeshIndices.emplace(model->getString(model->mMeshes[i].mMeshName),(uint16_t) i);
+
+    // Parents don't have to precede their children in the file, so each mesh first walks up to
+    // the nearest ancestor that is already done and the chain is then resolved top-down. Every
+    // mesh is visited once this way, and a broken file with a parent cycle can't loop forever.
+
+    std::vector<uint8_t> state(meshCount,0);   // 0 = not visited, 1 = on the current chain, 2 = done
+    std::vector<size_t> chain;
+
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        size_t index = i;
+
+        while (state[index] == 0)
+        {
+            state[index] = 1;
+            chain.push_back(index);
+
+            uint16_t parentID = model->mMeshes[index].mParentID;
+
+            if (parentID == 0 || parentID > meshCount)
+                break;
+
+            index = parentID - 1;
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            const Mesh &m = model->mMeshes[*it];
+
+            MFMath::Mat4 transform = MFMath::translationMatrix(m.mPos);
+            transform = MFMath::mul(transform,MFMath::rotationMatrix(m.mRot));
+            transform = MFMath::mul(transform,MFMath::scalingMatrix(m.mScale));
+
+            if (m.mParentID > 0 && m.mParentID <= meshCount && state[m.mParentID - 1] == 2)
+                transform = MFMath::mul(model->mWorldTransforms[m.mParentID - 1],transform);
+
+            model->mWorldTransforms[*it] = transform;
+            state[*it] = 2;
+        }
+
+        chain.clear();
+    }
+}
+
+DataFormat4DS::Model DataFormat4DS::loadModel(BinaryReader &file)
+{
+    Model model = {};
     read(file, &model.mSignature, 4);
 
     if (strncmp(reinterpret_cast<char*>(model.mSignature), "4DS", 3) != 0)
@@ -506,12 +496,14 @@ DataFormat4DS::Model DataFormat4DS::loadModel(std::ifstream &file)
     loadMaterial(&model, file);
     loadMesh(&model, file);
     read(file, &model.mUse5DS);
-   
-    mErrorCode = DataFormat4DS::ERROR_SUCCESS;
+    indexMeshes(&model);
+
+    // the counts in the file have to match the data, a shorter file is corrupt
+    mErrorCode = file.good() ? DataFormat4DS::ERROR_SUCCESS : DataFormat4DS::ERROR_TRUNCATED;
     return model;
 }
 
-bool DataFormat4DS::load(std::ifstream &srcFile)
+bool DataFormat4DS::load(BinaryReader &srcFile)
 {
     mLoadedModel = loadModel(srcFile);
     return mErrorCode == DataFormat4DS::ERROR_SUCCESS;
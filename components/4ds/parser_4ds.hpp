@@ -4,6 +4,7 @@
 #include <base_parser.hpp>
 #include <loader_cache.hpp>
 #include <cstring>
+#include <unordered_map>
 #include <utils/math.hpp>
 
 namespace MFFormat
@@ -72,6 +73,8 @@ public:
         MESHOCCLUDINGFLAG_INACTIVE = 0x11
     } MeshOccludingFlag;
 
+    typedef StringPool::String PoolString;  ///< to Model::mStrings, use Model::getString(...) to get the string
+
     typedef struct
     {
         uint32_t mFlags;
@@ -82,15 +85,12 @@ public:
 
         // environment map
         float mEnvRatio;                   // parameter for interpolating between env. and diffuse map (only for NORMAL blending flag)
-        char mEnvMapNameLength;
-        char mEnvMapName[255];
+        PoolString mEnvMapName;
 
-        char mDiffuseMapNameLength;
-        char mDiffuseMapName[255];
+        PoolString mDiffuseMapName;
 
         // alpha map
-        char mAlphaMapNameLength;
-        char mAlphaMapName[255];
+        PoolString mAlphaMapName;
 
         // anim map
         uint32_t mAnimSequenceLength;      // how many frames animated texture has
@@ -117,7 +117,7 @@ public:
     typedef struct
     {
         uint16_t mFaceCount;
-        std::vector<Face> mFaces;
+        uint32_t mFaceOffset;      // to Model::mFaces
         uint16_t mMaterialID;      // 1-based, 0 = default material
     } FaceGroup;
 
@@ -125,7 +125,7 @@ public:
     {
         float mRelativeDistance;
         uint16_t mVertexCount;
-        std::vector<Vertex> mVertices;
+        uint32_t mVertexOffset;    // to Model::mVertices
         uint8_t mFaceGroupCount;
         std::vector<FaceGroup> mFaceGroups;
     } Lod;
@@ -222,7 +222,7 @@ public:
     typedef struct
     {
         uint16_t mVertexCount;
-        std::vector<MorphLodVertex> mVertices;
+        std::vector<MorphLodVertex> mVertices;  // frame after frame, mVertexCount per frame
         uint8_t mUnk0;
         std::vector<uint16_t> mVertexLinks; // addresses vertices from Standard's LOD mesh  
     } MorphLod;
@@ -282,21 +282,9 @@ public:
         MFMath::Vec3 mScale;
         MFMath::Quat mRot;
         uint8_t mCullingFlags;
-        uint8_t mMeshNameLength;
-        char mMeshName[255];
-        uint8_t mMeshParamsLength;
-        char mMeshParams[255];
-        Standard mStandard;
-        Dummy mDummy;
-        Mirror mMirror;
-        Glow mGlow;
-        Billboard mBillboard;
-        Sector mSector;
-        Target mTarget;
-        Bone mBone;
-        Morph mMorph;
-        SingleMesh mSingleMesh;
-        SingleMorph mSingleMorph;
+        PoolString mMeshName;
+        PoolString mMeshParams;
+        uint32_t mDataIndex;    // to the Model array given by the mesh type (mStandards, mDummies, ...)
     } Mesh;
 
     typedef struct sModel
@@ -310,31 +298,91 @@ public:
         std::vector<Mesh> mMeshes;
         uint8_t mUse5DS;
 
-        MFMath::Mat4 computeWorldTransform(uint16_t meshIndex)
+        // mesh data, only meshes of given type take space in each array
+        std::vector<Standard> mStandards;
+        std::vector<Dummy> mDummies;
+        std::vector<Mirror> mMirrors;
+        std::vector<Glow> mGlows;
+        std::vector<Billboard> mBillboards;
+        std::vector<Sector> mSectors;
+        std::vector<Target> mTargets;
+        std::vector<Bone> mBones;
+        std::vector<Morph> mMorphs;
+        std::vector<SingleMesh> mSingleMeshes;
+        std::vector<SingleMorph> mSingleMorphs;
+
+        // geometry of all the standard LODs in the model
+        std::vector<Vertex> mVertices;
+        std::vector<Face> mFaces;
+        StringPool mStrings;                                          // names, interned
+
+        const Vertex *getVertices(const Lod &lod) const              { return mVertices.data() + lod.mVertexOffset;          }
+        const Face *getFaces(const FaceGroup &faceGroup) const       { return mFaces.data() + faceGroup.mFaceOffset;         }
+        std::string getString(const PoolString &str) const           { return mStrings.getString(str);                       }
+
+        /// Standard geometry of a visual mesh of any type (standard, billboard, morph, ...), nullptr if it has none.
+        const Standard *getStandard(const Mesh &mesh) const
         {
-            meshIndex += 1;  // convert to 1-based
+            if (mesh.mMeshType != MESHTYPE_STANDARD && mesh.mMeshType != MESHTYPE_COLLISION)
+                return nullptr;
+
+            switch (mesh.mVisualMeshType)
+            {
+                case VISUALMESHTYPE_STANDARD: return &mStandards[mesh.mDataIndex];
+                case VISUALMESHTYPE_BILLBOARD: return &mBillboards[mesh.mDataIndex].mStandard;
+                case VISUALMESHTYPE_MORPH: return &mMorphs[mesh.mDataIndex].mStandard;
+                case VISUALMESHTYPE_SINGLEMESH: return &mSingleMeshes[mesh.mDataIndex].mStandard;
+                case VISUALMESHTYPE_SINGLEMORPH: return &mSingleMorphs[mesh.mDataIndex].mSingleMesh.mStandard;
+                default: return nullptr;
+            }
+        }
 
-            MFMath::Mat4 result = MFMath::identity;
+        /// Morph frames of a morph or single morph mesh, nullptr for other meshes.
+        const Morph *getMorph(const Mesh &mesh) const
+        {
+            if (mesh.mMeshType != MESHTYPE_STANDARD)
+                return nullptr;
 
-            while (meshIndex > 0 && meshIndex <= mMeshCount)
+            switch (mesh.mVisualMeshType)
             {
-                Mesh *m = &(mMeshes[meshIndex - 1]);
-                MFMath::Mat4 meshTransform = MFMath::translationMatrix(MFMath::Vec3(m->mPos.x,m->mPos.y,m->mPos.z));
+                case VISUALMESHTYPE_MORPH: return &mMorphs[mesh.mDataIndex];
+                case VISUALMESHTYPE_SINGLEMORPH: return &mSingleMorphs[mesh.mDataIndex].mMorph;
+                default: return nullptr;
+            }
+        }
 
-                meshTransform = MFMath::mul(meshTransform,MFMath::rotationMatrix(MFMath::Quat(m->mRot.x,m->mRot.y,m->mRot.z,m->mRot.w)));
-                meshTransform = MFMath::mul(meshTransform,MFMath::scalingMatrix(MFMath::Vec3(m->mScale.x,m->mScale.y,m->mScale.z)));
+        /// Skinning data (joints, weights) of a single mesh or single morph mesh, nullptr for other meshes.
+        const SingleMesh *getSingleMesh(const Mesh &mesh) const
+        {
+            if (mesh.mMeshType != MESHTYPE_STANDARD)
+                return nullptr;
 
-                result = MFMath::mul(meshTransform,result);
-                meshIndex = m->mParentID;
+            switch (mesh.mVisualMeshType)
+            {
+                case VISUALMESHTYPE_SINGLEMESH: return &mSingleMeshes[mesh.mDataIndex];
+                case VISUALMESHTYPE_SINGLEMORPH: return &mSingleMorphs[mesh.mDataIndex].mSingleMesh;
+                default: return nullptr;
             }
+        }
+
+        /// World transforms of all meshes (the parent chain applied), computed once after loading.
+        std::vector<MFMath::Mat4> mWorldTransforms;
+        std::unordered_map<std::string,uint16_t> mMeshIndices;      ///< mesh name => index to mMeshes, first mesh of given name
 
-            return result;
+        const MFMath::Mat4 &getWorldTransform(uint16_t meshIndex) const   { return mWorldTransforms[meshIndex];                 }
+
+        /// Returns the index of a mesh of given name, -1 if there is none.
+        int findMesh(const std::string &name) const
+        {
+            auto it = mMeshIndices.find(name);
+            return it != mMeshIndices.end() ? it->second : -1;
         }
     } Model;
 
-    virtual bool load(std::ifstream &srcFile) override;
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
     
-    inline Model getModel()
+    inline const Model &getModel() const
     {
         return mLoadedModel;
     }
@@ -343,6 +391,7 @@ public:
     {
         ERROR_SUCCESS,
         ERROR_SIGNATURE,
+        ERROR_TRUNCATED
     } ErrorCodes;
 
     std::string getErrorStr()
@@ -350,27 +399,30 @@ public:
         switch (mErrorCode)
         {
             case ERROR_SIGNATURE: return "Wrong 4ds signature";
+            case ERROR_TRUNCATED: return "Unexpected end of 4ds file";
         }
 
         return "Unknown error";
     }
 
 protected:
-    void loadMaterial(Model *model, std::ifstream &file);
-    Lod loadLod(std::ifstream &file);
-    Standard loadStandard(std::ifstream &file);
-    Mirror loadMirror(std::ifstream &file);
-    Glow loadGlow(std::ifstream &file);
-    Portal loadPortal(std::ifstream &file);
-    Sector loadSector(std::ifstream &file);
-    Target loadTarget(std::ifstream &file);
-    Morph loadMorph(std::ifstream &file, bool ignoreStandard);
-    SingleMeshLodJoint loadSingleMeshLodJoint(std::ifstream &file);
-    SingleMeshLod loadSingleMeshLod(std::ifstream &file);
-    SingleMesh loadSingleMesh(std::ifstream &file);
-    SingleMorph loadSingleMorph(std::ifstream &file);
-    void loadMesh(Model *model, std::ifstream &file);
-    Model loadModel(std::ifstream &file);
+    PoolString loadString(Model *model, BinaryReader &file);
+    void loadMaterial(Model *model, BinaryReader &file);
+    Lod loadLod(Model *model, BinaryReader &file);
+    Standard loadStandard(Model *model, BinaryReader &file);
+    Mirror loadMirror(BinaryReader &file);
+    Glow loadGlow(BinaryReader &file);
+    Portal loadPortal(BinaryReader &file);
+    Sector loadSector(BinaryReader &file);
+    Target loadTarget(BinaryReader &file);
+    Morph loadMorph(Model *model, BinaryReader &file, bool ignoreStandard);
+    SingleMeshLodJoint loadSingleMeshLodJoint(BinaryReader &file);
+    SingleMeshLod loadSingleMeshLod(BinaryReader &file);
+    SingleMesh loadSingleMesh(Model *model, BinaryReader &file);
+    SingleMorph loadSingleMorph(Model *model, BinaryReader &file);
+    void loadMesh(Model *model, BinaryReader &file);
+    void indexMeshes(Model *model);
+    Model loadModel(BinaryReader &file);
     Model mLoadedModel;
 };
 
@@ -0,0 +1,563 @@
+#include <4ds/parser_baked4ds.hpp>
+#include <filesystem>
+#include <unordered_map>
+
+namespace MFFormat
+{
+
+namespace
+{
+
+const size_t SECTION_ALIGNMENT = 16;
+
+const size_t RECORD_SIZES[DataFormatBaked4DS::SECTION_COUNT] =
+{
+    sizeof(DataFormatBaked4DS::Material),
+    sizeof(DataFormatBaked4DS::Mesh),
+    sizeof(DataFormatBaked4DS::Lod),
+    sizeof(DataFormatBaked4DS::FaceGroup),
+    sizeof(MFMath::Vec3),
+    sizeof(MFMath::Vec3),
+    sizeof(MFMath::Vec2),
+    sizeof(uint32_t),
+    sizeof(DataFormatBaked4DS::Morph),
+    sizeof(MFMath::Vec3),
+    sizeof(MFMath::Vec3),
+    sizeof(uint16_t),
+    sizeof(DataFormatBaked4DS::Skin),
+    sizeof(DataFormatBaked4DS::SkinJoint),
+    sizeof(DataFormatBaked4DS::SkinInfluence),
+    sizeof(char)
+};
+
+/// Same as OSGLoader::toOSG(MFMath::Vec3): swaps Y and Z.
+inline MFMath::Vec3 toRenderSpace(const MFMath::Vec3 &v)
+{
+    return MFMath::Vec3(v.x,v.z,v.y);
+}
+
+/// Normalized normal in the renderer's coordinate system, zero normals are kept.
+inline MFMath::Vec3 toRenderSpaceNormal(const MFMath::Vec3 &v)
+{
+    MFMath::Vec3 normal = toRenderSpace(v);
+    return MFMath::length(normal) > 0.0f ? MFMath::normalize(normal) : normal;
+}
+
+inline bool checkString(const DataFormat4DS::PoolString &str, uint32_t poolSize)
+{
+    return (uint64_t) str.mOffset + str.mLength < poolSize;   // including the terminating zero
+}
+
+}
+
+DataFormatBaked4DS::DataFormatBaked4DS()
+{
+    clear();
+}
+
+void DataFormatBaked4DS::clear()
+{
+    mMapping.close();
+    mStorage.assign(sizeof(Header),0);     // empty bake, all sections have zero records
+    mData = mStorage.data();
+    mSize = mStorage.size();
+}
+
+bool DataFormatBaked4DS::bake(const DataFormat4DS::Model &model, const Source &source)
+{
+    std::vector<Mesh> meshes;
+    std::vector<Lod> lods;
+    std::vector<FaceGroup> faceGroups;
+    std::vector<MFMath::Vec3> positions;
+    std::vector<MFMath::Vec3> normals;
+    std::vector<MFMath::Vec2> uvs;
+    std::vector<uint32_t> indices;
+    std::vector<Morph> morphs;
+    std::vector<MFMath::Vec3> morphPositions;
+    std::vector<MFMath::Vec3> morphNormals;
+    std::vector<uint16_t> morphLinks;
+    std::vector<Skin> skins;
+    std::vector<SkinJoint> skinJoints;
+    std::vector<SkinInfluence> skinInfluences;
+    std::unordered_map<uint32_t,uint32_t> boneMeshes;      // bone ID => mesh index
+
+    for (size_t i = 0; i < model.mMeshes.size(); ++i)
+        if (model.mMeshes[i].mMeshType == DataFormat4DS::MESHTYPE_BONE)
+            boneMeshes.insert(std::make_pair(model.mBones[model.mMeshes[i].mDataIndex].mBoneID,(uint32_t) i));
+
+    positions.reserve(model.mVertices.size());
+    normals.reserve(model.mVertices.size());
+    uvs.reserve(model.mVertices.size());
+    indices.reserve(model.mFaces.size() * 3);
+
+    for (const auto& srcMesh : model.mMeshes)
+    {
+        Mesh mesh = {};
+        mesh.mName = srcMesh.mMeshName;
+        mesh.mMeshType = srcMesh.mMeshType;
+        mesh.mVisualMeshType = srcMesh.mVisualMeshType;
+        mesh.mParentID = srcMesh.mParentID;
+        mesh.mPos = srcMesh.mPos;
+        mesh.mScale = srcMesh.mScale;
+        mesh.mRot = srcMesh.mRot;
+        mesh.mFirstLod = lods.size();
+
+        // only visual meshes are rendered, mirrors and glows have no standard geometry
+        const DataFormat4DS::Standard *standard = srcMesh.mMeshType == DataFormat4DS::MESHTYPE_STANDARD ? model.getStandard(srcMesh) : nullptr;
+
+        if (standard)
+        {
+            mesh.mLODLevel = standard->mLODLevel;
+            mesh.mInstanced = standard->mInstanced;
+            mesh.mLodCount = standard->mLODs.size();
+
+            for (const auto& srcLod : standard->mLODs)
+            {
+                Lod lod;
+                lod.mRelativeDistance = srcLod.mRelativeDistance;
+                lod.mFirstVertex = positions.size();
+                lod.mVertexCount = srcLod.mVertexCount;
+                lod.mFirstFaceGroup = faceGroups.size();
+                lod.mFaceGroupCount = srcLod.mFaceGroups.size();
+
+                const DataFormat4DS::Vertex *vertices = model.getVertices(srcLod);
+
+                for (size_t i = 0; i < srcLod.mVertexCount; ++i)
+                {
+                    positions.push_back(toRenderSpace(vertices[i].mPos));
+                    normals.push_back(toRenderSpaceNormal(vertices[i].mNormal));
+                    uvs.push_back(MFMath::Vec2(vertices[i].mUV.x,1.0f - vertices[i].mUV.y));
+                }
+
+                for (const auto& srcFaceGroup : srcLod.mFaceGroups)
+                {
+                    FaceGroup faceGroup;
+                    faceGroup.mMaterialID = srcFaceGroup.mMaterialID;
+                    faceGroup.mFirstIndex = indices.size();
+                    faceGroup.mIndexCount = srcFaceGroup.mFaceCount * 3;
+
+                    const DataFormat4DS::Face *faces = model.getFaces(srcFaceGroup);
+
+                    for (size_t i = 0; i < srcFaceGroup.mFaceCount; ++i)
+                    {
+                        indices.push_back(faces[i].mA);
+                        indices.push_back(faces[i].mB);
+                        indices.push_back(faces[i].mC);
+                    }
+
+                    faceGroups.push_back(faceGroup);
+                }
+
+                lods.push_back(lod);
+            }
+        }
+
+        const DataFormat4DS::Morph *srcMorph = standard ? model.getMorph(srcMesh) : nullptr;
+        mesh.mFirstMorph = morphs.size();
+
+        if (srcMorph)
+        {
+            // morph LODs deform the standard LODs of the same index
+
+            size_t lodCount = std::min(srcMorph->mLODs.size(),standard->mLODs.size());
+
+            for (size_t i = 0; i < lodCount; ++i)
+            {
+                const DataFormat4DS::MorphLod &srcMorphLod = srcMorph->mLODs[i];
+
+                if (srcMorphLod.mVertexCount == 0 ||
+                    srcMorphLod.mVertices.size() != (size_t) srcMorph->mFrameCount * srcMorphLod.mVertexCount ||
+                    srcMorphLod.mVertexLinks.size() != srcMorphLod.mVertexCount)
+                    continue;   // truncated
+
+                bool linksValid = true;
+
+                for (auto link : srcMorphLod.mVertexLinks)
+                    linksValid = linksValid && link < standard->mLODs[i].mVertexCount;
+
+                if (!linksValid)
+                    continue;
+
+                Morph morph;
+                morph.mLod = mesh.mFirstLod + i;
+                morph.mFrameCount = srcMorph->mFrameCount;
+                morph.mVertexCount = srcMorphLod.mVertexCount;
+                morph.mFirstTarget = morphPositions.size();
+                morph.mFirstLink = morphLinks.size();
+
+                for (const auto& vertex : srcMorphLod.mVertices)
+                {
+                    morphPositions.push_back(toRenderSpace(vertex.mPosition));
+                    morphNormals.push_back(toRenderSpaceNormal(vertex.mNormals));
+                }
+
+                morphLinks.insert(morphLinks.end(),srcMorphLod.mVertexLinks.begin(),srcMorphLod.mVertexLinks.end());
+                morphs.push_back(morph);
+            }
+        }
+
+        mesh.mMorphCount = morphs.size() - mesh.mFirstMorph;
+
+        const DataFormat4DS::SingleMesh *singleMesh = standard ? model.getSingleMesh(srcMesh) : nullptr;
+        mesh.mFirstSkin = skins.size();
+
+        if (singleMesh)
+        {
+            // Vertices of a LOD are ordered: the non-weighted ones, then for each joint the ones fully
+            // weighted to it, followed by the ones shared with the joint's paired bone.
+
+            size_t lodCount = std::min(singleMesh->mLODs.size(),standard->mLODs.size());
+
+            for (size_t i = 0; i < lodCount; ++i)
+            {
+                const DataFormat4DS::SingleMeshLod &srcSkinLod = singleMesh->mLODs[i];
+                const uint32_t vertexCount = standard->mLODs[i].mVertexCount;
+                const uint16_t jointCount = srcSkinLod.mJoints.size();
+
+                if (srcSkinLod.mNonWeightedVertCount >= vertexCount || jointCount == 0)
+                    continue;
+
+                Skin skin;
+                skin.mLod = mesh.mFirstLod + i;
+                skin.mFirstSkinnedVertex = srcSkinLod.mNonWeightedVertCount;
+                skin.mFirstJoint = skinJoints.size();
+                skin.mJointCount = jointCount;
+                skin.mFirstInfluence = skinInfluences.size();
+
+                for (uint16_t j = 0; j < jointCount; ++j)
+                {
+                    auto bone = boneMeshes.find(j);
+
+                    SkinJoint joint;
+                    joint.mBone = bone != boneMeshes.end() ? bone->second : NO_BONE;
+                    skinJoints.push_back(joint);
+                }
+
+                for (uint16_t j = 0; j < jointCount; ++j)
+                {
+                    const DataFormat4DS::SingleMeshLodJoint &srcJoint = srcSkinLod.mJoints[j];
+                    uint16_t paired = srcJoint.mBoneID < jointCount ? srcJoint.mBoneID : jointCount;
+
+                    for (uint32_t k = 0; k < srcJoint.mOneWeightedVertCount; ++k)
+                        skinInfluences.push_back(SkinInfluence {{j,j},1.0f});
+
+                    for (uint32_t k = 0; k < srcJoint.mWeightCount && k < srcJoint.mWeights.size(); ++k)
+                        skinInfluences.push_back(SkinInfluence {{j,paired},srcJoint.mWeights[k]});
+                }
+
+                // the counts may not add up in damaged files, the remaining vertices stay in place
+
+                skinInfluences.resize(skin.mFirstInfluence + vertexCount - skin.mFirstSkinnedVertex,SkinInfluence {{jointCount,jointCount},1.0f});
+                skins.push_back(skin);
+            }
+        }
+
+        mesh.mSkinCount = skins.size() - mesh.mFirstSkin;
+        meshes.push_back(mesh);
+    }
+
+    const void *sections[SECTION_COUNT] =
+    {
+        model.mMaterials.data(), meshes.data(), lods.data(), faceGroups.data(),
+        positions.data(), normals.data(), uvs.data(), indices.data(),
+        morphs.data(), morphPositions.data(), morphNormals.data(), morphLinks.data(),
+        skins.data(), skinJoints.data(), skinInfluences.data(), model.mStrings.data()
+    };
+
+    const size_t counts[SECTION_COUNT] =
+    {
+        model.mMaterials.size(), meshes.size(), lods.size(), faceGroups.size(),
+        positions.size(), normals.size(), uvs.size(), indices.size(),
+        morphs.size(), morphPositions.size(), morphNormals.size(), morphLinks.size(),
+        skins.size(), skinJoints.size(), skinInfluences.size(), model.mStrings.size()
+    };
+
+    Header header = {};
+    header.mMagic = MAGIC;
+    header.mVersion = VERSION;
+    header.mSource = source;
+
+    size_t size = sizeof(Header);
+
+    for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+        size = (size + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.mSections[i].mOffset = size;
+        header.mSections[i].mCount = counts[i];
+        size += counts[i] * RECORD_SIZES[i];
+    }
+
+    if (size > UINT32_MAX)
+    {
+        mErrorCode = ERROR_CORRUPT;
+        return false;
+    }
+
+    mMapping.close();
+    mStorage.assign(size,0);
+    memcpy(mStorage.data(),&header,sizeof(header));
+
+    for (int i = 0; i < SECTION_COUNT; ++i)
+        if (counts[i] > 0)
+            memcpy(mStorage.data() + header.mSections[i].mOffset,sections[i],counts[i] * RECORD_SIZES[i]);
+
+    mData = mStorage.data();
+    mSize = mStorage.size();
+    mErrorCode = ERROR_SUCCESS;
+    return true;
+}
+
+bool DataFormatBaked4DS::validate(const char *data, size_t size)
+{
+    if (size < sizeof(Header))
+    {
+        mErrorCode = ERROR_SIGNATURE;
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+
+    if (header->mMagic != MAGIC)
+    {
+        mErrorCode = ERROR_SIGNATURE;
+        return false;
+    }
+
+    if (header->mVersion != VERSION)
+    {
+        mErrorCode = ERROR_VERSION;
+        return false;
+    }
+
+    mErrorCode = ERROR_CORRUPT;
+
+    for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+        const Section &section = header->mSections[i];
+
+        if (section.mOffset % SECTION_ALIGNMENT != 0 ||
+            (uint64_t) section.mOffset + (uint64_t) section.mCount * RECORD_SIZES[i] > size)
+            return false;
+    }
+
+    // Check everything that is used to index other sections, so that a damaged bake can't make the
+    // loader read out of bounds. Positions, normals etc. are used as they are.
+
+    uint32_t counts[SECTION_COUNT];
+
+    for (int i = 0; i < SECTION_COUNT; ++i)
+        counts[i] = header->mSections[i].mCount;
+
+    const char *strings = data + header->mSections[SECTION_STRINGS].mOffset;
+    const Material *materials = reinterpret_cast<const Material *>(data + header->mSections[SECTION_MATERIALS].mOffset);
+    const Mesh *meshes = reinterpret_cast<const Mesh *>(data + header->mSections[SECTION_MESHES].mOffset);
+    const Lod *lods = reinterpret_cast<const Lod *>(data + header->mSections[SECTION_LODS].mOffset);
+    const FaceGroup *faceGroups = reinterpret_cast<const FaceGroup *>(data + header->mSections[SECTION_FACEGROUPS].mOffset);
+    const uint32_t *indices = reinterpret_cast<const uint32_t *>(data + header->mSections[SECTION_INDICES].mOffset);
+    const Morph *morphs = reinterpret_cast<const Morph *>(data + header->mSections[SECTION_MORPHS].mOffset);
+    const uint16_t *morphLinks = reinterpret_cast<const uint16_t *>(data + header->mSections[SECTION_MORPH_LINKS].mOffset);
+    const Skin *skins = reinterpret_cast<const Skin *>(data + header->mSections[SECTION_SKINS].mOffset);
+    const SkinJoint *skinJoints = reinterpret_cast<const SkinJoint *>(data + header->mSections[SECTION_SKIN_JOINTS].mOffset);
+    const SkinInfluence *skinInfluences = reinterpret_cast<const SkinInfluence *>(data + header->mSections[SECTION_SKIN_INFLUENCES].mOffset);
+
+    if (counts[SECTION_POSITIONS] != counts[SECTION_NORMALS] || counts[SECTION_POSITIONS] != counts[SECTION_UVS] ||
+        counts[SECTION_MORPH_POSITIONS] != counts[SECTION_MORPH_NORMALS])
+        return false;
+
+    if (counts[SECTION_STRINGS] > 0 && strings[counts[SECTION_STRINGS] - 1] != 0)
+        return false;
+
+    for (uint32_t i = 0; i < counts[SECTION_MATERIALS]; ++i)
+        if (!checkString(materials[i].mEnvMapName,counts[SECTION_STRINGS]) ||
+            !checkString(materials[i].mDiffuseMapName,counts[SECTION_STRINGS]) ||
+            !checkString(materials[i].mAlphaMapName,counts[SECTION_STRINGS]))
+            return false;
+
+    for (uint32_t i = 0; i < counts[SECTION_MESHES]; ++i)
+        if (!checkString(meshes[i].mName,counts[SECTION_STRINGS]) ||
+            meshes[i].mParentID > counts[SECTION_MESHES] ||
+            (uint64_t) meshes[i].mFirstLod + meshes[i].mLodCount > counts[SECTION_LODS] ||
+            (uint64_t) meshes[i].mFirstMorph + meshes[i].mMorphCount > counts[SECTION_MORPHS] ||
+            (uint64_t) meshes[i].mFirstSkin + meshes[i].mSkinCount > counts[SECTION_SKINS])
+            return false;
+
+    for (uint32_t i = 0; i < counts[SECTION_LODS]; ++i)
+    {
+        const Lod &lod = lods[i];
+
+        if (lod.mVertexCount > UINT16_MAX ||      // 4DS limit, the renderer uses 16 bit indices
+            (uint64_t) lod.mFirstVertex + lod.mVertexCount > counts[SECTION_POSITIONS] ||
+            (uint64_t) lod.mFirstFaceGroup + lod.mFaceGroupCount > counts[SECTION_FACEGROUPS])
+            return false;
+
+        for (uint32_t j = lod.mFirstFaceGroup; j < lod.mFirstFaceGroup + lod.mFaceGroupCount; ++j)
+        {
+            if ((uint64_t) faceGroups[j].mFirstIndex + faceGroups[j].mIndexCount > counts[SECTION_INDICES])
+                return false;
+
+            for (uint32_t k = faceGroups[j].mFirstIndex; k < faceGroups[j].mFirstIndex + faceGroups[j].mIndexCount; ++k)
+                if (indices[k] >= lod.mVertexCount)
+                    return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < counts[SECTION_MORPHS]; ++i)
+    {
+        const Morph &morph = morphs[i];
+
+        if (morph.mLod >= counts[SECTION_LODS] ||
+            (uint64_t) morph.mFirstTarget + (uint64_t) morph.mFrameCount * morph.mVertexCount > counts[SECTION_MORPH_POSITIONS] ||
+            (uint64_t) morph.mFirstLink + morph.mVertexCount > counts[SECTION_MORPH_LINKS])
+            return false;
+
+        for (uint32_t j = morph.mFirstLink; j < morph.mFirstLink + morph.mVertexCount; ++j)
+            if (morphLinks[j] >= lods[morph.mLod].mVertexCount)
+                return false;
+    }
+
+    for (uint32_t i = 0; i < counts[SECTION_SKINS]; ++i)
+    {
+        const Skin &skin = skins[i];
+
+        if (skin.mLod >= counts[SECTION_LODS] || skin.mFirstSkinnedVertex > lods[skin.mLod].mVertexCount ||
+            skin.mJointCount > UINT16_MAX ||
+            (uint64_t) skin.mFirstJoint + skin.mJointCount > counts[SECTION_SKIN_JOINTS])
+            return false;
+
+        uint32_t influenceCount = lods[skin.mLod].mVertexCount - skin.mFirstSkinnedVertex;
+
+        if ((uint64_t) skin.mFirstInfluence + influenceCount > counts[SECTION_SKIN_INFLUENCES])
+            return false;
+
+        for (uint32_t j = skin.mFirstJoint; j < skin.mFirstJoint + skin.mJointCount; ++j)
+            if (skinJoints[j].mBone != NO_BONE && skinJoints[j].mBone >= counts[SECTION_MESHES])
+                return false;
+
+        for (uint32_t j = skin.mFirstInfluence; j < skin.mFirstInfluence + influenceCount; ++j)
+            if (skinInfluences[j].mJoints[0] > skin.mJointCount || skinInfluences[j].mJoints[1] > skin.mJointCount)
+                return false;
+    }
+
+    mErrorCode = ERROR_SUCCESS;
+    return true;
+}
+
+bool DataFormatBaked4DS::load(BinaryReader &srcFile)
+{
+    size_t size = srcFile.size() - std::min<size_t>(srcFile.size(),srcFile.tellg());
+    const char *src = srcFile.skip(size);
+
+    mMapping.close();
+    mStorage.assign(src,src + size);          // copy first, the source may not be aligned
+
+    if (!validate(mStorage.data(),mStorage.size()))
+    {
+        clear();
+        return false;
+    }
+
+    mData = mStorage.data();
+    mSize = mStorage.size();
+    return true;
+}
+
+bool DataFormatBaked4DS::open(const std::string &fileName)
+{
+    mMapping.close();
+
+    if (!mMapping.open(fileName) || !validate(mMapping.data(),mMapping.size()))
+    {
+        clear();
+        return false;
+    }
+
+    mStorage.clear();
+    mData = mMapping.data();
+    mSize = mMapping.size();
+    return true;
+}
+
+bool DataFormatBaked4DS::save(std::ofstream &dstFile)
+{
+    dstFile.write(mData,mSize);
+    return dstFile.good();
+}
+
+bool DataFormatBaked4DS::save(const std::string &fileName)
+{
+    std::string tmpFileName = fileName + ".tmp";
+    std::ofstream f(tmpFileName,std::ios::binary);
+    std::error_code error;
+
+    bool success = save(f);
+    f.close();
+
+    if (!success || !f.good())
+    {
+        std::filesystem::remove(tmpFileName,error);
+        return false;
+    }
+
+    std::filesystem::rename(tmpFileName,fileName,error);
+    return !error;
+}
+
+bool DataFormatBaked4DS::isBakedFrom(uint64_t timeStamp, const char *data, size_t size) const
+{
+    const Source &source = getHeader().mSource;
+
+    if (getHeader().mMagic != MAGIC)
+        return false;
+
+    if (timeStamp != 0 && source.mTimeStamp == timeStamp)
+        return true;
+
+    return data && source.mSize == size && source.mHash == hash(data,size);
+}
+
+void DataFormatBaked4DS::setSourceTimeStamp(uint64_t timeStamp)
+{
+    if (mSize < sizeof(Header))
+        return;
+
+    if (mData != mStorage.data())     // mapped or empty
+    {
+        mStorage.assign(mData,mData + mSize);
+        mData = mStorage.data();
+        mMapping.close();
+    }
+
+    reinterpret_cast<Header *>(mStorage.data())->mSource.mTimeStamp = timeStamp;
+}
+
+uint64_t DataFormatBaked4DS::hash(const char *data, size_t size)
+{
+    uint64_t result = 0xcbf29ce484222325;    // FNV-1a
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        result ^= (unsigned char) data[i];
+        result *= 0x100000001b3;
+    }
+
+    return result;
+}
+
+std::string DataFormatBaked4DS::getString(const DataFormat4DS::PoolString &str) const
+{
+    return std::string(getSection<char>(SECTION_STRINGS) + str.mOffset,str.mLength);
+}
+
+std::string DataFormatBaked4DS::getErrorStr()
+{
+    switch (mErrorCode)
+    {
+        case ERROR_SIGNATURE: return "Not a baked 4ds file";
+        case ERROR_VERSION: return "Baked 4ds file of a different version";
+        case ERROR_CORRUPT: return "Corrupt baked 4ds file";
+    }
+
+    return "Unknown error";
+}
+
+}
@@ -0,0 +1,210 @@
+#ifndef FORMAT_PARSERS_BAKED_4DS_H
+#define FORMAT_PARSERS_BAKED_4DS_H
+
+#include <4ds/parser_4ds.hpp>
+#include <utils/openmf.hpp>
+
+namespace MFFormat
+{
+
+/**
+  Precompiled ("baked") form of a 4DS model, made for fast loading. Vertices are already converted
+  to the renderer's coordinate system (the conversion of OSGLoader::toOSG, normals normalized, V
+  flipped), so the arrays can be handed to the renderer as they are. The file is a header followed
+  by aligned sections of fixed size records, it's used in place when memory mapped with open(...).
+
+  The header also records the time stamp, size and hash of the source 4DS file, so that outdated
+  bakes can be recognized with isBakedFrom(...). Bakes are only meant to be reused on the machine
+  that made them (the records have native layout and byte order).
+*/
+
+class DataFormatBaked4DS: public DataFormat
+{
+public:
+    static const uint32_t MAGIC = 0x42464d4f;        // "OMFB"
+    static const uint32_t VERSION = 4;               // increase with every change of the layout below
+
+    typedef enum
+    {
+        SECTION_MATERIALS,
+        SECTION_MESHES,
+        SECTION_LODS,
+        SECTION_FACEGROUPS,
+        SECTION_POSITIONS,
+        SECTION_NORMALS,
+        SECTION_UVS,
+        SECTION_INDICES,
+        SECTION_MORPHS,
+        SECTION_MORPH_POSITIONS,
+        SECTION_MORPH_NORMALS,
+        SECTION_MORPH_LINKS,
+        SECTION_SKINS,
+        SECTION_SKIN_JOINTS,
+        SECTION_SKIN_INFLUENCES,
+        SECTION_STRINGS,
+        SECTION_COUNT
+    } SectionType;
+
+    typedef struct
+    {
+        uint32_t mOffset;                  // from the beginning of the file
+        uint32_t mCount;                   // of records
+    } Section;
+
+    typedef struct
+    {
+        uint64_t mTimeStamp;
+        uint64_t mSize;
+        uint64_t mHash;                    // see hash(...)
+    } Source;
+
+    typedef struct
+    {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        Source mSource;
+        Section mSections[SECTION_COUNT];
+    } Header;
+
+    typedef DataFormat4DS::Material Material;   // names point to the baked string section
+
+    typedef struct
+    {
+        DataFormat4DS::PoolString mName;
+        uint8_t mMeshType;
+        uint8_t mVisualMeshType;
+        uint8_t mLODLevel;
+        uint16_t mParentID;                // 1-based, 0 = no parent
+        uint16_t mInstanced;
+        MFMath::Vec3 mPos;                 // the transform is kept in 4DS space
+        MFMath::Vec3 mScale;
+        MFMath::Quat mRot;
+        uint32_t mFirstLod;
+        uint32_t mLodCount;                // 0 for meshes without geometry
+        uint32_t mFirstMorph;
+        uint32_t mMorphCount;              // morphed LODs, 0 for meshes without morph frames
+        uint32_t mFirstSkin;
+        uint32_t mSkinCount;               // skinned LODs, 0 for meshes without joints
+    } Mesh;
+
+    typedef struct
+    {
+        float mRelativeDistance;
+        uint32_t mFirstVertex;
+        uint32_t mVertexCount;
+        uint32_t mFirstFaceGroup;
+        uint32_t mFaceGroupCount;
+    } Lod;
+
+    typedef struct
+    {
+        uint32_t mMaterialID;              // 1-based, 0 = default material
+        uint32_t mFirstIndex;
+        uint32_t mIndexCount;              // indices are relative to the LOD's first vertex
+    } FaceGroup;
+
+    typedef struct
+    {
+        uint32_t mLod;                     // the LOD whose vertices are morphed
+        uint32_t mFrameCount;
+        uint32_t mVertexCount;             // morphed vertices per frame
+        uint32_t mFirstTarget;             // morph positions and normals, frame after frame
+        uint32_t mFirstLink;               // mVertexCount links, relative to the LOD's first vertex
+    } Morph;
+
+    static const uint32_t NO_BONE = 0xffffffff;
+
+    typedef struct
+    {
+        uint32_t mLod;                     // the LOD whose vertices are skinned
+        uint32_t mFirstSkinnedVertex;      // relative to the LOD's first vertex, the vertices before aren't weighted
+        uint32_t mFirstJoint;
+        uint32_t mJointCount;
+        uint32_t mFirstInfluence;          // one per vertex from mFirstSkinnedVertex to the end of the LOD
+    } Skin;
+
+    typedef struct
+    {
+        uint32_t mBone;                    // index of the bone mesh moving the joint, NO_BONE = the skinned mesh itself
+    } SkinJoint;
+
+    typedef struct
+    {
+        uint16_t mJoints[2];               // joint index, mJointCount = the skinned mesh itself
+        float mWeight;                     // of the first joint, the second one has the rest
+    } SkinInfluence;
+
+    typedef enum
+    {
+        ERROR_SUCCESS,
+        ERROR_SIGNATURE,
+        ERROR_VERSION,
+        ERROR_CORRUPT
+    } ErrorCodes;
+
+    DataFormatBaked4DS();
+
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;   ///< Copies the bake (in one piece) and validates it.
+    virtual bool save(std::ofstream &dstFile) override;
+    bool save(const std::string &fileName);              ///< Writes a temporary file first, so readers never see a partial bake.
+    bool open(const std::string &fileName);              ///< Memory maps a bake from disk, the data are used in place.
+    void clear();                                        ///< Makes the bake empty (no materials, no meshes).
+
+    /// Converts a parsed model, source describes the file the model has been loaded from.
+    bool bake(const DataFormat4DS::Model &model, const Source &source);
+
+    /// Whether the bake is up to date with given source, compares the hashes only if the time stamps differ.
+    bool isBakedFrom(uint64_t timeStamp, const char *data, size_t size) const;
+    static uint64_t hash(const char *data, size_t size);
+    void setSourceTimeStamp(uint64_t timeStamp);         ///< For a source that only got a new time stamp, copies a mapped bake to memory.
+
+    const Header &getHeader() const                   { return *reinterpret_cast<const Header *>(mData); }
+    const char *getData() const                       { return mData;                                      }
+    size_t getSize() const                            { return mSize;                                      }
+
+    const Material *getMaterials() const              { return getSection<Material>(SECTION_MATERIALS);    }
+    const Mesh *getMeshes() const                     { return getSection<Mesh>(SECTION_MESHES);           }
+    const Lod *getLods() const                        { return getSection<Lod>(SECTION_LODS);              }
+    const FaceGroup *getFaceGroups() const            { return getSection<FaceGroup>(SECTION_FACEGROUPS);  }
+    const MFMath::Vec3 *getPositions() const          { return getSection<MFMath::Vec3>(SECTION_POSITIONS);}
+    const MFMath::Vec3 *getNormals() const            { return getSection<MFMath::Vec3>(SECTION_NORMALS);  }
+    const MFMath::Vec2 *getUVs() const                { return getSection<MFMath::Vec2>(SECTION_UVS);      }
+    const uint32_t *getIndices() const                { return getSection<uint32_t>(SECTION_INDICES);      }
+    const Morph *getMorphs() const                    { return getSection<Morph>(SECTION_MORPHS);          }
+    const MFMath::Vec3 *getMorphPositions() const     { return getSection<MFMath::Vec3>(SECTION_MORPH_POSITIONS); }
+    const MFMath::Vec3 *getMorphNormals() const       { return getSection<MFMath::Vec3>(SECTION_MORPH_NORMALS);   }
+    const uint16_t *getMorphLinks() const             { return getSection<uint16_t>(SECTION_MORPH_LINKS);  }
+    const Skin *getSkins() const                      { return getSection<Skin>(SECTION_SKINS);            }
+    const SkinJoint *getSkinJoints() const            { return getSection<SkinJoint>(SECTION_SKIN_JOINTS); }
+    const SkinInfluence *getSkinInfluences() const    { return getSection<SkinInfluence>(SECTION_SKIN_INFLUENCES); }
+
+    uint32_t getNumMaterials() const                  { return getCount(SECTION_MATERIALS);                }
+    uint32_t getNumMeshes() const                     { return getCount(SECTION_MESHES);                   }
+    uint32_t getNumVertices() const                   { return getCount(SECTION_POSITIONS);                }
+    uint32_t getNumIndices() const                    { return getCount(SECTION_INDICES);                  }
+
+    std::string getString(const DataFormat4DS::PoolString &str) const;
+
+    virtual std::string getErrorStr() override;
+
+protected:
+    template<typename T>
+    const T *getSection(SectionType type) const
+    {
+        return reinterpret_cast<const T *>(mData + getHeader().mSections[type].mOffset);
+    }
+
+    uint32_t getCount(SectionType type) const         { return getHeader().mSections[type].mCount;         }
+
+    bool validate(const char *data, size_t size);
+
+    const char *mData;                     // points either to mStorage or mMapping
+    size_t mSize;
+    std::vector<char> mStorage;
+    MFUtil::MappedFile mMapping;
+};
+
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include <4ds/skin.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace MFFormat
+{
+
+SkinBatch::SkinBatch()
+{
+    mWork = nullptr;
+    mNext = 0;
+    mGeneration = 0;
+    mBusy = 0;
+    mStop = false;
+}
+
+SkinBatch::~SkinBatch()
+{
+    stopWorkers();
+}
+
+void SkinBatch::setNumThreads(unsigned int threads)
+{
+    stopWorkers();
+
+    for (unsigned int i = 1; i < threads; ++i)
+        mWorkers.push_back(std::thread(&SkinBatch::work,this,mGeneration));
+}
+
+void SkinBatch::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mWorkAdded.notify_all();
+
+    for (auto& worker : mWorkers)
+        worker.join();
+
+    mWorkers.clear();
+    mStop = false;
+}
+
+void SkinBatch::work(unsigned int generation)
+{
+    while (true)
+    {
+        const std::vector<uint32_t> *indices;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAdded.wait(lock,[this,generation]() { return mStop || mGeneration != generation; });
+
+            if (mStop)
+                return;
+
+            generation = mGeneration;
+            indices = mWork;
+        }
+
+        skinNext(*indices);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusy--;
+        }
+
+        mWorkDone.notify_one();
+    }
+}
+
+SkinBatch::InstanceId SkinBatch::add(const Skin &skin, float *positions, float *normals)
+{
+    Instance instance;
+    instance.mId = mNextId++;
+    instance.mSkin = skin;
+    instance.mPositions = positions;
+    instance.mNormals = normals;
+    instance.mPalette.assign((skin.mJointCount + 1) * 16,0.0f);
+
+    for (uint32_t i = 0; i <= skin.mJointCount; ++i)
+        for (int j = 0; j < 4; ++j)
+            instance.mPalette[i * 16 + j * 5] = 1.0f;
+
+    if (mNextId == NO_INSTANCE)
+        mNextId++;
+
+    mInstances.push_back(std::move(instance));
+    return mInstances.back().mId;
+}
+
+void SkinBatch::remove(InstanceId id)
+{
+    int index = getIndex(id);
+
+    if (index >= 0)
+        mInstances.erase(mInstances.begin() + index);
+}
+
+void SkinBatch::clear()
+{
+    mInstances.clear();
+}
+
+int SkinBatch::getIndex(InstanceId id) const
+{
+    for (size_t i = 0; i < mInstances.size(); ++i)
+        if (mInstances[i].mId == id)
+            return i;
+
+    return -1;
+}
+
+void SkinBatch::skin(size_t index)
+{
+    Instance &instance = mInstances[index];
+    skinVertices(instance.mSkin,instance.mPalette.data(),instance.mPositions,instance.mNormals);
+}
+
+void SkinBatch::skinNext(const std::vector<uint32_t> &indices)
+{
+    // the instances don't share any output, the threads just take the next one
+
+    for (size_t i = mNext++; i < indices.size(); i = mNext++)
+        skin(indices[i]);
+}
+
+void SkinBatch::skin(const std::vector<uint32_t> &indices)
+{
+    if (mWorkers.empty() || indices.size() <= 1)
+    {
+        for (auto index : indices)
+            skin(index);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWork = &indices;
+        mNext = 0;
+        mBusy = mWorkers.size();
+        mGeneration++;
+    }
+
+    mWorkAdded.notify_all();
+
+    skinNext(indices);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock,[this]() { return mBusy == 0; });
+    mWork = nullptr;
+}
+
+void SkinBatch::skinVertices(const Skin &skin, const float *palette, float *positions, float *normals)
+{
+    const Influence *influences = skin.mInfluences;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    float result[4];
+
+    for (uint32_t i = 0; i < skin.mVertexCount; ++i)
+    {
+        const float *a = palette + influences[i].mJoints[0] * 16;
+        const float *b = palette + influences[i].mJoints[1] * 16;
+        __m128 rows[4];
+
+        if (a == b)
+        {
+            for (int r = 0; r < 4; ++r)
+                rows[r] = _mm_loadu_ps(a + r * 4);
+        }
+        else
+        {
+            const __m128 wa = _mm_set1_ps(influences[i].mWeight);
+            const __m128 wb = _mm_set1_ps(1.0f - influences[i].mWeight);
+
+            for (int r = 0; r < 4; ++r)
+                rows[r] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + r * 4),wa),_mm_mul_ps(_mm_loadu_ps(b + r * 4),wb));
+        }
+
+        const float *p = skin.mPositions + i * 3;
+        const float *n = skin.mNormals + i * 3;
+
+        __m128 position = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]),rows[0]),_mm_mul_ps(_mm_set1_ps(p[1]),rows[1])),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[2]),rows[2]),rows[3]));
+
+        __m128 normal = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n[0]),rows[0]),_mm_mul_ps(_mm_set1_ps(n[1]),rows[1])),
+            _mm_mul_ps(_mm_set1_ps(n[2]),rows[2]));
+
+        _mm_storeu_ps(result,position);
+        positions[i * 3] = result[0];
+        positions[i * 3 + 1] = result[1];
+        positions[i * 3 + 2] = result[2];
+
+        _mm_storeu_ps(result,normal);
+        float length = std::sqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2]);
+        float scale = length > 0 ? 1.0f / length : 0.0f;
+
+        normals[i * 3] = result[0] * scale;
+        normals[i * 3 + 1] = result[1] * scale;
+        normals[i * 3 + 2] = result[2] * scale;
+    }
+#else
+    for (uint32_t i = 0; i < skin.mVertexCount; ++i)
+    {
+        const float *a = palette + influences[i].mJoints[0] * 16;
+        const float *b = palette + influences[i].mJoints[1] * 16;
+        const float wa = influences[i].mWeight;
+        const float wb = 1.0f - wa;
+        float m[16];
+
+        for (int j = 0; j < 16; ++j)
+            m[j] = a[j] * wa + b[j] * wb;
+
+        const float *p = skin.mPositions + i * 3;
+        const float *n = skin.mNormals + i * 3;
+        float normal[3];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            positions[i * 3 + c] = p[0] * m[c] + p[1] * m[4 + c] + p[2] * m[8 + c] + m[12 + c];
+            normal[c] = n[0] * m[c] + n[1] * m[4 + c] + n[2] * m[8 + c];
+        }
+
+        float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float scale = length > 0 ? 1.0f / length : 0.0f;
+
+        for (int c = 0; c < 3; ++c)
+            normals[i * 3 + c] = normal[c] * scale;
+    }
+#endif
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef SKIN_4DS_H
+#define SKIN_4DS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MFFormat
+{
+
+/**
+  Skins 4DS single meshes on the CPU. Every skinned vertex is moved by a blend of two matrices of
+  the instance's palette (a joint and its paired bone), the palette is set every frame from the
+  bones' transforms. The matrices are blended and applied with SIMD, instances can be spread over
+  several threads, which are kept running between the calls of skin(...).
+*/
+
+class SkinBatch
+{
+public:
+    SkinBatch();
+    ~SkinBatch();
+    SkinBatch(const SkinBatch &) = delete;
+    SkinBatch &operator=(const SkinBatch &) = delete;
+
+    typedef uint32_t InstanceId;
+    static const InstanceId NO_INSTANCE = 0;
+
+    typedef struct
+    {
+        uint16_t mJoints[2];               // palette index, mJointCount = identity (the skinned mesh itself)
+        float mWeight;                     // of the first joint, the second one has the rest
+    } Influence;
+
+    typedef struct
+    {
+        uint32_t mVertexCount;
+        uint32_t mJointCount;
+        const float *mPositions;           // bind pose, 3 floats per vertex
+        const float *mNormals;
+        const Influence *mInfluences;      // one per vertex
+    } Skin;
+
+    /// Starts skinning into given output arrays (3 floats per vertex), the skin data and the outputs have to outlive the instance.
+    InstanceId add(const Skin &skin, float *positions, float *normals);
+    void remove(InstanceId id);
+    void clear();                                               ///< Removes all the instances, the threads keep running.
+
+    /// Instances keep the order in which they were added, -1 if there is no such instance.
+    int getIndex(InstanceId id) const;
+    size_t getNumInstances() const                              { return mInstances.size(); }
+
+    /**
+      Palette of an instance, 4x4 matrices of all the joints (row major, transforming row vectors
+      like OSG) followed by the identity. All the matrices are identities until set.
+    */
+    float *getPalette(size_t index)                             { return mInstances[index].mPalette.data(); }
+
+    /// Number of threads skin(...) spreads the instances over, the calling thread included.
+    void setNumThreads(unsigned int threads);
+    unsigned int getNumThreads() const                          { return mWorkers.size() + 1; }
+
+    /// Skins given instances, all of them are done when it returns.
+    void skin(const std::vector<uint32_t> &indices);
+    void skin(size_t index);
+
+    static void skinVertices(const Skin &skin, const float *palette, float *positions, float *normals);
+
+protected:
+    typedef struct
+    {
+        InstanceId mId;
+        Skin mSkin;
+        float *mPositions;
+        float *mNormals;
+        std::vector<float> mPalette;
+    } Instance;
+
+    void stopWorkers();
+    void work(unsigned int generation);
+    void skinNext(const std::vector<uint32_t> &indices);
+
+    std::vector<Instance> mInstances;
+    InstanceId mNextId = 1;
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWorkAdded;
+    std::condition_variable mWorkDone;
+    const std::vector<uint32_t> *mWork;      ///< indices being skinned
+    std::atomic<size_t> mNext;               ///< next position in mWork to take
+    unsigned int mGeneration;                ///< increased with every skin(...) that uses the workers
+    unsigned int mBusy;                      ///< workers that haven't finished the current work
+    bool mStop;
+};
+
+}
+
+#endif
@@ -0,0 +1,410 @@
+#include <5ds/animation.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace MFFormat
+{
+
+namespace
+{
+
+// same as OSGLoader::toOSG, the Y and Z axes are swapped (a mirroring, which flips the rotation axis)
+
+MFMath::Vec3 toRenderSpace(const MFMath::Vec3 &v)
+{
+    return MFMath::Vec3(v.x,v.z,v.y);
+}
+
+MFMath::Quat toRenderSpace(const MFMath::Quat &q)
+{
+    return MFMath::Quat(-q.x,-q.z,-q.y,q.w);
+}
+
+template<typename T>
+AnimationClip::Channel convertKeys(
+    const DataFormat5DS::Keys &keys,
+    const std::vector<uint16_t> &srcFrames,
+    const std::vector<T> &srcValues,
+    std::vector<float> &times,
+    std::vector<T> &values,
+    float &duration)
+{
+    AnimationClip::Channel channel;
+    channel.mFirstKey = times.size();
+    channel.mKeyCount = keys.mKeyCount;
+
+    for (uint32_t i = keys.mFirstKey; i < keys.mFirstKey + keys.mKeyCount; ++i)
+    {
+        float time = srcFrames[i] / (float) DataFormat5DS::FRAMES_PER_SECOND;
+
+        if (times.size() > channel.mFirstKey)
+            time = std::max(time,times.back());    // the cursors expect non-decreasing times
+
+        times.push_back(time);
+        values.push_back(toRenderSpace(srcValues[i]));
+        duration = std::max(duration,time);
+    }
+
+    return channel;
+}
+
+}
+
+void AnimationClip::build(const DataFormat5DS &animation)
+{
+    mTracks.clear();
+    mPositionTimes.clear();
+    mPositions.clear();
+    mRotationTimes.clear();
+    mRotations.clear();
+    mScaleTimes.clear();
+    mScales.clear();
+    mDuration = animation.getTotalFrameCount() / (float) DataFormat5DS::FRAMES_PER_SECOND;
+
+    for (size_t i = 0; i < animation.getNumSequences(); ++i)
+    {
+        const DataFormat5DS::AnimationSequence &sequence = animation.getSequence(i);
+        Track track;
+
+        track.mName = animation.getString(sequence.mName);
+        track.mPosition = convertKeys(sequence.mMovements,animation.getMovementFrames(),animation.getMovements(),mPositionTimes,mPositions,mDuration);
+        track.mRotation = convertKeys(sequence.mRotations,animation.getRotationFrames(),animation.getRotations(),mRotationTimes,mRotations,mDuration);
+        track.mScale = convertKeys(sequence.mScales,animation.getScaleFrames(),animation.getScales(),mScaleTimes,mScales,mDuration);
+
+        mTracks.push_back(track);
+    }
+
+    for (auto &q : mRotations)
+        if (MFMath::length(q) > 0)
+            q = MFMath::normalize(q);
+}
+
+uint32_t AnimationClip::seek(const float *times, const Channel &channel, uint32_t key, float time)
+{
+    const float *keys = times + channel.mFirstKey;
+
+    if (key >= channel.mKeyCount || keys[key] > time)
+        key = 0;
+
+    while (key + 1 < channel.mKeyCount && keys[key + 1] <= time)
+        key++;
+
+    return key;
+}
+
+float AnimationClip::getBlend(const float *times, const Channel &channel, uint32_t key, float time)
+{
+    const float *keys = times + channel.mFirstKey;
+
+    if (key + 1 >= channel.mKeyCount || time <= keys[key])
+        return 0;
+
+    float span = keys[key + 1] - keys[key];
+    return span > 0 ? std::min((time - keys[key]) / span,1.0f) : 1.0f;
+}
+
+void AnimationBatch::Gather::clear()
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        mA[i].clear();
+        mB[i].clear();
+    }
+
+    mBlend.clear();
+    mSlot.clear();
+}
+
+void AnimationBatch::Gather::add(const float *a, const float *b, unsigned int components, float blend, uint32_t slot)
+{
+    for (unsigned int i = 0; i < components; ++i)
+    {
+        mA[i].push_back(a[i]);
+        mB[i].push_back(b[i]);
+    }
+
+    mBlend.push_back(blend);
+    mSlot.push_back(slot);
+}
+
+AnimationBatch::InstanceId AnimationBatch::play(const AnimationClip *clip, bool loop, float speed)
+{
+    Instance instance;
+    instance.mId = mNextId++;
+    instance.mClip = clip;
+    instance.mTime = 0;
+    instance.mSpeed = speed;
+    instance.mLoop = loop;
+    instance.mFirstSlot = getNumSlots();
+
+    resizeSlots(getNumSlots() + clip->getNumTracks());
+
+    for (size_t i = 0; i < clip->getNumTracks(); ++i)
+        mCursors[instance.mFirstSlot + i] = Cursor {0,0,0};
+
+    mInstances.push_back(instance);
+    return instance.mId;
+}
+
+void AnimationBatch::stop(InstanceId id)
+{
+    int index = findInstance(id);
+
+    if (index < 0)
+        return;
+
+    const Instance &instance = mInstances[index];
+    size_t count = instance.mClip->getNumTracks();
+
+    eraseSlots(instance.mFirstSlot,count);
+
+    for (size_t i = index + 1; i < mInstances.size(); ++i)
+        mInstances[i].mFirstSlot -= count;
+
+    mInstances.erase(mInstances.begin() + index);
+}
+
+void AnimationBatch::setTime(InstanceId id, float time)
+{
+    int index = findInstance(id);
+
+    if (index >= 0)
+        mInstances[index].mTime = time;
+}
+
+void AnimationBatch::setSpeed(InstanceId id, float speed)
+{
+    int index = findInstance(id);
+
+    if (index >= 0)
+        mInstances[index].mSpeed = speed;
+}
+
+void AnimationBatch::setRestPose(InstanceId id, size_t track, const MFMath::Vec3 &position, const MFMath::Quat &rotation, const MFMath::Vec3 &scale)
+{
+    int index = findInstance(id);
+
+    if (index < 0 || track >= mInstances[index].mClip->getNumTracks())
+        return;
+
+    size_t slot = mInstances[index].mFirstSlot + track;
+
+    mPositionX[slot] = position.x; mPositionY[slot] = position.y; mPositionZ[slot] = position.z;
+    mRotationX[slot] = rotation.x; mRotationY[slot] = rotation.y; mRotationZ[slot] = rotation.z; mRotationW[slot] = rotation.w;
+    mScaleX[slot] = scale.x; mScaleY[slot] = scale.y; mScaleZ[slot] = scale.z;
+}
+
+int AnimationBatch::getFirstSlot(InstanceId id) const
+{
+    int index = findInstance(id);
+    return index >= 0 ? (int) mInstances[index].mFirstSlot : -1;
+}
+
+int AnimationBatch::findInstance(InstanceId id) const
+{
+    for (size_t i = 0; i < mInstances.size(); ++i)
+        if (mInstances[i].mId == id)
+            return i;
+
+    return -1;
+}
+
+void AnimationBatch::resizeSlots(size_t count)
+{
+    mCursors.resize(count);
+
+    for (auto v : {&mPositionX,&mPositionY,&mPositionZ,&mRotationX,&mRotationY,&mRotationZ})
+        v->resize(count,0.0f);
+
+    for (auto v : {&mRotationW,&mScaleX,&mScaleY,&mScaleZ})
+        v->resize(count,1.0f);
+}
+
+void AnimationBatch::eraseSlots(size_t first, size_t count)
+{
+    mCursors.erase(mCursors.begin() + first,mCursors.begin() + first + count);
+
+    for (auto v : {&mPositionX,&mPositionY,&mPositionZ,&mRotationX,&mRotationY,&mRotationZ,&mRotationW,&mScaleX,&mScaleY,&mScaleZ})
+        v->erase(v->begin() + first,v->begin() + first + count);
+}
+
+void AnimationBatch::advance(float dt)
+{
+    mPositionKeys.clear();
+    mRotationKeys.clear();
+    mScaleKeys.clear();
+
+    // move the cursors and gather the keys around the current time
+
+    for (auto &instance : mInstances)
+    {
+        const AnimationClip *clip = instance.mClip;
+        float duration = clip->getDuration();
+
+        instance.mTime += dt * instance.mSpeed;
+
+        if (instance.mLoop && duration > 0)
+        {
+            instance.mTime = std::fmod(instance.mTime,duration);
+
+            if (instance.mTime < 0)
+                instance.mTime += duration;
+        }
+        else
+            instance.mTime = std::max(0.0f,std::min(instance.mTime,duration));
+
+        const float time = instance.mTime;
+        const auto &tracks = clip->getTracks();
+
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            const AnimationClip::Track &track = tracks[i];
+            const uint32_t slot = instance.mFirstSlot + i;
+            Cursor &cursor = mCursors[slot];
+
+            if (track.mPosition.mKeyCount > 0)
+            {
+                const float *times = clip->getPositionTimes().data();
+                const MFMath::Vec3 *keys = clip->getPositions().data() + track.mPosition.mFirstKey;
+
+                cursor.mPosition = AnimationClip::seek(times,track.mPosition,cursor.mPosition,time);
+                uint32_t next = std::min(cursor.mPosition + 1,track.mPosition.mKeyCount - 1);
+
+                mPositionKeys.add(&keys[cursor.mPosition].x,&keys[next].x,3,
+                    AnimationClip::getBlend(times,track.mPosition,cursor.mPosition,time),slot);
+            }
+
+            if (track.mRotation.mKeyCount > 0)
+            {
+                const float *times = clip->getRotationTimes().data();
+                const MFMath::Quat *keys = clip->getRotations().data() + track.mRotation.mFirstKey;
+
+                cursor.mRotation = AnimationClip::seek(times,track.mRotation,cursor.mRotation,time);
+                uint32_t next = std::min(cursor.mRotation + 1,track.mRotation.mKeyCount - 1);
+
+                mRotationKeys.add(&keys[cursor.mRotation].x,&keys[next].x,4,
+                    AnimationClip::getBlend(times,track.mRotation,cursor.mRotation,time),slot);
+            }
+
+            if (track.mScale.mKeyCount > 0)
+            {
+                const float *times = clip->getScaleTimes().data();
+                const MFMath::Vec3 *keys = clip->getScales().data() + track.mScale.mFirstKey;
+
+                cursor.mScale = AnimationClip::seek(times,track.mScale,cursor.mScale,time);
+                uint32_t next = std::min(cursor.mScale + 1,track.mScale.mKeyCount - 1);
+
+                mScaleKeys.add(&keys[cursor.mScale].x,&keys[next].x,3,
+                    AnimationClip::getBlend(times,track.mScale,cursor.mScale,time),slot);
+            }
+        }
+    }
+
+    // interpolate all the channels at once
+
+    lerp(mPositionKeys,mPositionX.data(),mPositionY.data(),mPositionZ.data());
+    nlerp(mRotationKeys,mRotationX.data(),mRotationY.data(),mRotationZ.data(),mRotationW.data());
+    lerp(mScaleKeys,mScaleX.data(),mScaleY.data(),mScaleZ.data());
+}
+
+void AnimationBatch::lerp(const Gather &gather, float *x, float *y, float *z)
+{
+    const size_t count = gather.mSlot.size();
+    const float *t = gather.mBlend.data();
+    float *out[3] = {x,y,z};
+
+    for (int c = 0; c < 3; ++c)
+    {
+        const float *a = gather.mA[c].data();
+        const float *b = gather.mB[c].data();
+        float *o = out[c];
+        size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+        float result[4];
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 va = _mm_loadu_ps(a + i);
+            __m128 vb = _mm_loadu_ps(b + i);
+            __m128 vt = _mm_loadu_ps(t + i);
+            _mm_storeu_ps(result,_mm_add_ps(va,_mm_mul_ps(_mm_sub_ps(vb,va),vt)));
+
+            for (int j = 0; j < 4; ++j)
+                o[gather.mSlot[i + j]] = result[j];
+        }
+#endif
+
+        for (; i < count; ++i)
+            o[gather.mSlot[i]] = a[i] + (b[i] - a[i]) * t[i];
+    }
+}
+
+void AnimationBatch::nlerp(const Gather &gather, float *x, float *y, float *z, float *w)
+{
+    // normalized linear interpolation, the shorter way around (keys are close in time)
+
+    const size_t count = gather.mSlot.size();
+    const float *t = gather.mBlend.data();
+    const float *ax = gather.mA[0].data(), *ay = gather.mA[1].data(), *az = gather.mA[2].data(), *aw = gather.mA[3].data();
+    const float *bx = gather.mB[0].data(), *by = gather.mB[1].data(), *bz = gather.mB[2].data(), *bw = gather.mB[3].data();
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    float result[4][4];
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 qa[4] = {_mm_loadu_ps(ax + i),_mm_loadu_ps(ay + i),_mm_loadu_ps(az + i),_mm_loadu_ps(aw + i)};
+        __m128 qb[4] = {_mm_loadu_ps(bx + i),_mm_loadu_ps(by + i),_mm_loadu_ps(bz + i),_mm_loadu_ps(bw + i)};
+        __m128 vt = _mm_loadu_ps(t + i);
+
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qa[0],qb[0]),_mm_mul_ps(qa[1],qb[1])),
+            _mm_add_ps(_mm_mul_ps(qa[2],qb[2]),_mm_mul_ps(qa[3],qb[3])));
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot,zero),signBit);    // negate b where the dot is negative
+
+        __m128 length = zero;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            __m128 b = _mm_xor_ps(qb[c],flip);
+            qa[c] = _mm_add_ps(qa[c],_mm_mul_ps(_mm_sub_ps(b,qa[c]),vt));
+            length = _mm_add_ps(length,_mm_mul_ps(qa[c],qa[c]));
+        }
+
+        __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f),_mm_sqrt_ps(length));
+
+        for (int c = 0; c < 4; ++c)
+            _mm_storeu_ps(result[c],_mm_mul_ps(qa[c],scale));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            uint32_t slot = gather.mSlot[i + j];
+            x[slot] = result[0][j]; y[slot] = result[1][j]; z[slot] = result[2][j]; w[slot] = result[3][j];
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float dot = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+        float sign = dot < 0 ? -1.0f : 1.0f;
+
+        float qx = ax[i] + (sign * bx[i] - ax[i]) * t[i];
+        float qy = ay[i] + (sign * by[i] - ay[i]) * t[i];
+        float qz = az[i] + (sign * bz[i] - az[i]) * t[i];
+        float qw = aw[i] + (sign * bw[i] - aw[i]) * t[i];
+        float scale = 1.0f / std::sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+
+        uint32_t slot = gather.mSlot[i];
+        x[slot] = qx * scale; y[slot] = qy * scale; z[slot] = qz * scale; w[slot] = qw * scale;
+    }
+}
+
+}
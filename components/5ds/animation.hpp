@@ -0,0 +1,156 @@
+#ifndef ANIMATION_5DS_H
+#define ANIMATION_5DS_H
+
+#include <5ds/parser_5ds.hpp>
+#include <utils/math.hpp>
+#include <vector>
+#include <string>
+
+namespace MFFormat
+{
+
+/**
+  Keyframe animation converted from 5DS for playback. Each channel (position, rotation, scale) of
+  each track is a run of key times in seconds with the values in a parallel array, all the tracks
+  share the arrays (structure of arrays). The values are converted to the renderer's coordinate
+  system like in OSGLoader::toOSG, rotations are quaternions.
+*/
+
+class AnimationClip
+{
+public:
+    typedef struct
+    {
+        uint32_t mFirstKey;
+        uint32_t mKeyCount;                // 0 = not animated, the rest pose is kept
+    } Channel;
+
+    typedef struct
+    {
+        std::string mName;                 // of the animated mesh
+        Channel mPosition;
+        Channel mRotation;
+        Channel mScale;
+    } Track;
+
+    void build(const DataFormat5DS &animation);
+
+    float getDuration() const                                   { return mDuration;         }
+    size_t getNumTracks() const                                 { return mTracks.size();    }
+    const std::vector<Track> &getTracks() const                 { return mTracks;           }
+
+    const std::vector<float> &getPositionTimes() const          { return mPositionTimes;    }
+    const std::vector<MFMath::Vec3> &getPositions() const       { return mPositions;        }
+    const std::vector<float> &getRotationTimes() const          { return mRotationTimes;    }
+    const std::vector<MFMath::Quat> &getRotations() const       { return mRotations;        }
+    const std::vector<float> &getScaleTimes() const             { return mScaleTimes;       }
+    const std::vector<MFMath::Vec3> &getScales() const          { return mScales;           }
+
+    /**
+      Returns the key at or before given time in a channel, starting from the key returned last
+      time. Playback moving forward thus only steps over the keys passed since the previous frame
+      instead of searching, going back in time (looping, seeking) restarts from the first key.
+    */
+    static uint32_t seek(const float *times, const Channel &channel, uint32_t key, float time);
+
+    /// Blend factor between given key and the next one, 0 before the first key and after the last one.
+    static float getBlend(const float *times, const Channel &channel, uint32_t key, float time);
+
+protected:
+    std::vector<Track> mTracks;
+    std::vector<float> mPositionTimes;
+    std::vector<MFMath::Vec3> mPositions;
+    std::vector<float> mRotationTimes;
+    std::vector<MFMath::Quat> mRotations;
+    std::vector<float> mScaleTimes;
+    std::vector<MFMath::Vec3> mScales;
+    float mDuration = 0;
+};
+
+/**
+  Plays any number of animation clips at once. Every track of every playing instance has a pose
+  slot, advance(...) samples all of them in one pass: the channel cursors are moved, the keys
+  around the current time are gathered into structure-of-arrays buffers and all the channels
+  of a kind are then interpolated by one (SIMD) loop. Slots of channels that aren't animated keep
+  the rest pose.
+*/
+
+class AnimationBatch
+{
+public:
+    typedef uint32_t InstanceId;
+    static const InstanceId NO_INSTANCE = 0;
+
+    InstanceId play(const AnimationClip *clip, bool loop = true, float speed = 1.0);   ///< The clip has to outlive the instance.
+    void stop(InstanceId id);
+    bool isPlaying(InstanceId id) const                         { return findInstance(id) >= 0; }
+    void setTime(InstanceId id, float time);
+    void setSpeed(InstanceId id, float speed);
+
+    /// Sets the pose a track has when a channel isn't animated (the mesh's own transform).
+    void setRestPose(InstanceId id, size_t track, const MFMath::Vec3 &position, const MFMath::Quat &rotation, const MFMath::Vec3 &scale);
+
+    void advance(float dt);
+
+    /// Pose slots of an instance are getFirstSlot(id) + track index, -1 if the instance isn't playing.
+    int getFirstSlot(InstanceId id) const;
+    size_t getNumSlots() const                                  { return mPositionX.size(); }
+
+    MFMath::Vec3 getPosition(size_t slot) const                 { return MFMath::Vec3(mPositionX[slot],mPositionY[slot],mPositionZ[slot]); }
+    MFMath::Quat getRotation(size_t slot) const                 { return MFMath::Quat(mRotationX[slot],mRotationY[slot],mRotationZ[slot],mRotationW[slot]); }
+    MFMath::Vec3 getScale(size_t slot) const                    { return MFMath::Vec3(mScaleX[slot],mScaleY[slot],mScaleZ[slot]); }
+
+protected:
+    typedef struct
+    {
+        InstanceId mId;
+        const AnimationClip *mClip;
+        float mTime;
+        float mSpeed;
+        bool mLoop;
+        uint32_t mFirstSlot;
+    } Instance;
+
+    typedef struct
+    {
+        uint32_t mPosition;
+        uint32_t mRotation;
+        uint32_t mScale;
+    } Cursor;
+
+    /// Keys around the current time of all the animated channels of a kind, one lane per channel.
+    typedef struct
+    {
+        std::vector<float> mA[4];
+        std::vector<float> mB[4];
+        std::vector<float> mBlend;
+        std::vector<uint32_t> mSlot;
+
+        void clear();
+        void add(const float *a, const float *b, unsigned int components, float blend, uint32_t slot);
+    } Gather;
+
+    int findInstance(InstanceId id) const;
+    void resizeSlots(size_t count);
+    void eraseSlots(size_t first, size_t count);
+
+    static void lerp(const Gather &gather, float *x, float *y, float *z);
+    static void nlerp(const Gather &gather, float *x, float *y, float *z, float *w);
+
+    std::vector<Instance> mInstances;
+    InstanceId mNextId = 1;
+
+    // pose slots
+    std::vector<Cursor> mCursors;
+    std::vector<float> mPositionX, mPositionY, mPositionZ;
+    std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+    std::vector<float> mScaleX, mScaleY, mScaleZ;
+
+    Gather mPositionKeys;
+    Gather mRotationKeys;
+    Gather mScaleKeys;
+};
+
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include <5ds/osg_5ds.hpp>
+#include <vfs/vfs.hpp>
+#include <utils/osg.hpp>
+
+namespace MFFormat
+{
+
+class FindTransformsVisitor: public osg::NodeVisitor
+{
+public:
+    FindTransformsVisitor(): osg::NodeVisitor()
+    {
+    }
+
+    virtual void apply(osg::Node &n) override
+    {
+        osg::MatrixTransform *transform = dynamic_cast<osg::MatrixTransform *>(&n);
+
+        if (transform && transform->getName().length() > 0)
+            mTransforms.insert(std::make_pair(transform->getName(),transform));    // keeps the first one
+
+        MFUtil::traverse(this,n);
+    }
+
+    std::unordered_map<std::string,osg::MatrixTransform *> mTransforms;
+};
+
+const AnimationClip *OSGAnimationPlayer::getClip(std::string fileName)
+{
+    auto it = mClips.find(fileName);
+
+    if (it != mClips.end())
+        return it->second.get();
+
+    std::vector<char> storage;
+    const char *data;
+    size_t size;
+    DataFormat5DS animation;
+
+    if (!MFFile::FileSystem::getInstance()->read(fileName,data,size,storage) || !animation.load(data,size))
+    {
+        MFLogger::Logger::warn("Could not load animation " + fileName + ".",OSG5DS_MODULE_STR);
+        return nullptr;
+    }
+
+    std::unique_ptr<AnimationClip> clip(new AnimationClip);
+    clip->build(animation);
+
+    const AnimationClip *result = clip.get();
+    mClips[fileName] = std::move(clip);
+    return result;
+}
+
+OSGAnimationPlayer::InstanceId OSGAnimationPlayer::play(const AnimationClip *clip, osg::Node *model, bool loop, float speed)
+{
+    if (!clip || !model)
+        return AnimationBatch::NO_INSTANCE;
+
+    FindTransformsVisitor v;
+    model->accept(v);
+
+    const auto &tracks = clip->getTracks();
+    std::vector<osg::MatrixTransform *> targets(tracks.size(),nullptr);
+    size_t bound = 0;
+
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        auto it = v.mTransforms.find(tracks[i].mName);
+
+        if (it != v.mTransforms.end())
+        {
+            targets[i] = it->second;
+            bound++;
+        }
+    }
+
+    if (bound == 0)
+    {
+        MFLogger::Logger::warn("No mesh of model " + model->getName() + " is animated by the clip.",OSG5DS_MODULE_STR);
+        return AnimationBatch::NO_INSTANCE;
+    }
+
+    InstanceId id = mBatch.play(clip,loop,speed);
+
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        mTargets.push_back(targets[i]);
+
+        if (!targets[i])
+            continue;
+
+        // channels that aren't animated keep the mesh's own transform
+
+        osg::Vec3d translation, scale;
+        osg::Quat rotation, scaleOrientation;
+        targets[i]->getMatrix().decompose(translation,rotation,scale,scaleOrientation);
+
+        mBatch.setRestPose(id,i,
+            MFMath::Vec3(translation.x(),translation.y(),translation.z()),
+            MFMath::Quat(rotation.x(),rotation.y(),rotation.z(),rotation.w()),
+            MFMath::Vec3(scale.x(),scale.y(),scale.z()));
+    }
+
+    mNumBound += bound;
+    return id;
+}
+
+void OSGAnimationPlayer::stop(InstanceId id)
+{
+    int first = mBatch.getFirstSlot(id);
+
+    if (first < 0)
+        return;
+
+    size_t slots = mBatch.getNumSlots();
+    mBatch.stop(id);
+
+    auto begin = mTargets.begin() + first;
+    auto end = begin + (slots - mBatch.getNumSlots());
+
+    for (auto it = begin; it != end; ++it)
+        if (it->valid())
+            mNumBound--;
+
+    mTargets.erase(begin,end);
+}
+
+void OSGAnimationPlayer::clear()
+{
+    mBatch = AnimationBatch();
+    mTargets.clear();
+    mNumBound = 0;
+}
+
+void OSGAnimationPlayer::update(double dt)
+{
+    if (mTargets.empty())
+        return;
+
+    mBatch.advance(dt);
+
+    osg::Matrixd m;
+
+    for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+        osg::MatrixTransform *target = mTargets[i].get();
+
+        if (!target)
+            continue;
+
+        // same as OSGLoader::makeTransformMatrix, the pose is already in OSG space
+
+        MFMath::Quat r = mBatch.getRotation(i);
+        MFMath::Vec3 p = mBatch.getPosition(i);
+        MFMath::Vec3 s = mBatch.getScale(i);
+
+        m.makeRotate(osg::Quat(r.x,r.y,r.z,r.w));
+        m.preMultScale(osg::Vec3d(s.x,s.y,s.z));
+        m.setTrans(p.x,p.y,p.z);
+
+        target->setMatrix(m);
+    }
+}
+
+}
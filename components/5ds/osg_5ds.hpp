@@ -0,0 +1,48 @@
+#ifndef OSG_5DS_PLAYER_H
+#define OSG_5DS_PLAYER_H
+
+#include <osg/Node>
+#include <osg/MatrixTransform>
+#include <memory>
+#include <unordered_map>
+#include <5ds/animation.hpp>
+#include <utils/logger.hpp>
+
+#define OSG5DS_MODULE_STR "player 5ds"
+
+namespace MFFormat
+{
+
+/**
+  Plays 5DS animations on loaded models. Tracks are bound to the model's mesh transforms by name,
+  update(...) samples all the playing animations at once (see AnimationBatch) and then sets the
+  matrices of all the bound transforms in a single pass.
+*/
+
+class OSGAnimationPlayer
+{
+public:
+    typedef AnimationBatch::InstanceId InstanceId;
+
+    /// Loads (and caches) an animation clip, nullptr if it can't be loaded.
+    const AnimationClip *getClip(std::string fileName);
+
+    /// Starts playing a clip on given model, returns AnimationBatch::NO_INSTANCE if no track matches a mesh.
+    InstanceId play(const AnimationClip *clip, osg::Node *model, bool loop = true, float speed = 1.0);
+    void stop(InstanceId id);
+    void clear();                ///< Stops all the animations, the loaded clips are kept.
+    void update(double dt);
+
+    AnimationBatch *getBatch()                                  { return &mBatch;       }
+    size_t getNumBoundTransforms() const                        { return mNumBound;     }
+
+protected:
+    AnimationBatch mBatch;
+    std::vector<osg::ref_ptr<osg::MatrixTransform>> mTargets;  ///< per pose slot, null if the track has no mesh
+    size_t mNumBound = 0;
+    std::unordered_map<std::string,std::unique_ptr<AnimationClip>> mClips;
+};
+
+}
+
+#endif
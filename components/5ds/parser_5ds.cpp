@@ -3,171 +3,80 @@
 namespace MFFormat
 {
 
-void DataFormat5DS::AnimationSequence::setNumberOfSequences(uint16_t numberOfSequences)
+template<typename T>
+bool DataFormat5DS::readKeys(BinaryReader &inputFile, std::vector<uint16_t> &frames, std::vector<T> &values, Keys &keys)
 {
-    mNumberOfSequences = numberOfSequences;    
-}
-
-void DataFormat5DS::AnimationSequence::setType(uint16_t type)
-{
-    mType = static_cast<TypeOfSequence>(type); 
-}
-
-void DataFormat5DS::AnimationSequence::setName(const std::string& str)
-{
-    mObjectName = str;
-}
-
-void DataFormat5DS::AnimationSequence::addTimestamp(uint32_t time)
-{
-    mTimestamps.push_back(time);
-}
-
-void DataFormat5DS::AnimationSequence::addMovement(MFMath::Vec3& data)
-{
-    mMovements.push_back(data);
-}
-
-void DataFormat5DS::AnimationSequence::addRotation(MFMath::Vec3& data)
-{
-    mRotations.push_back(data);
-}
-
-void DataFormat5DS::AnimationSequence::addScale(MFMath::Vec3& data)
-{
-    mScale.push_back(data);
-}
-
-const std::string DataFormat5DS::AnimationSequence::getName()
-{
-    return mObjectName;
-}
-
-uint16_t DataFormat5DS::AnimationSequence::getCount() const
-{
-    return mNumberOfSequences;
-}
-
-const uint32_t& DataFormat5DS::AnimationSequence::getTimestamp(uint16_t id) const
-{ 
-    return mTimestamps[id];
-}
-
-const MFMath::Vec3& DataFormat5DS::AnimationSequence::getMovement(uint16_t id) const
-{ 
-    return mMovements[id];
-}
-
-const MFMath::Vec3& DataFormat5DS::AnimationSequence::getRotation(uint16_t id) const
-{ 
-    return mRotations[id];
-}
+    uint16_t keyCount = 0;
+    read(inputFile, &keyCount);
 
-const MFMath::Vec3& DataFormat5DS::AnimationSequence::getScale(uint16_t id) const 
-{ 
-    return mScale[id];
-}
+    keys.mFirstKey = frames.size();
+    keys.mKeyCount = keyCount;
 
-bool DataFormat5DS::AnimationSequence::hasMovement() const
-{ 
-    return (mType & SEQUENCE_MOVEMENT);
-}
-
-bool DataFormat5DS::AnimationSequence::hasRotation() const
-{ 
-    return (mType & SEQUENCE_ROTATION);
-}
+    if (!readArray(inputFile, frames, keyCount))
+        return false;
 
-bool DataFormat5DS::AnimationSequence::hasScale() const
-{ 
-    return (mType & SEQUENCE_SCALE);
-}
+    if (keyCount % 2 == 0)    // the frame numbers are padded to 4 bytes
+        inputFile.seekg(2, inputFile.cur);
 
-void DataFormat5DS::addAnimatedObject(DataFormat5DS::AnimationSequence& seq)
-{
-    mSequences.push_back(seq); 
+    return readArray(inputFile, values, keyCount);
 }
 
-bool DataFormat5DS::parseAnimationSequence(std::ifstream& inputFile, uint32_t pointerData, uint32_t pointerName, AnimationSequence& result)
+bool DataFormat5DS::parseAnimationSequence(BinaryReader &inputFile, uint32_t pointerData, uint32_t pointerName, AnimationSequence& result)
 {
     //seek to destination
     inputFile.seekg(pointerData);
 
-    // read block type; 
-    uint32_t typeOfBlock;
-    read(inputFile, &typeOfBlock);
-    result.setType(typeOfBlock);
+    read(inputFile, &result.mType);
 
-    uint16_t animationCount;
-    read(inputFile, &animationCount);
-    result.setNumberOfSequences(animationCount);
+    // each channel has its own keys, in this order
 
-    uint16_t timeFrame;
-    uint16_t timeFrameCountMax = (animationCount % 2 == 0)?animationCount+1: animationCount;
-    for(uint32_t timeFrameCount = 0; timeFrameCount < timeFrameCountMax; timeFrameCount++)
+    if (result.mType & SEQUENCE_ROTATION)
     {
-        read(inputFile, &timeFrame);
-        
-        // Add frame time
-        result.addTimestamp(timeFrame);
-    }
+        size_t first = mRotations.size();
 
-    // Read moving data
-    for(uint16_t dataIndex = 0; dataIndex < animationCount; dataIndex++)
-    {
-        if(typeOfBlock & SEQUENCE_MOVEMENT)
-        {
-            // read movement
-            MFMath::Vec3 movementData;
-            read(inputFile, &movementData);
-            result.addMovement(movementData);
-
-        }
-        if(typeOfBlock & SEQUENCE_ROTATION)
-        {
-            // read movement
-            MFMath::Vec3 rotationData;
-            read(inputFile, &rotationData);
-            result.addRotation(rotationData);
-
-        }
-        if(typeOfBlock & SEQUENCE_SCALE)
-        {
-            // read movement
-            MFMath::Vec3 scaleData;
-            read(inputFile, &scaleData);
-            result.addScale(scaleData);
-        }
+        if (readKeys(inputFile, mRotationFrames, mRotations, result.mRotations))
+            for (size_t i = first; i < mRotations.size(); ++i)
+                mRotations[i].fromMafia();
     }
-    
+
+    if (result.mType & SEQUENCE_MOVEMENT)
+        readKeys(inputFile, mMovementFrames, mMovements, result.mMovements);
+
+    if (result.mType & SEQUENCE_SCALE)
+        readKeys(inputFile, mScaleFrames, mScales, result.mScales);
+
     // get string
-    inputFile.seekg(pointerName); 
+    inputFile.seekg(pointerName);
 
-    std::string objectName;
-    char objectNameChar;
-    inputFile.get(objectNameChar);
+    const char *objectName;
+    size_t length;
 
-    while(objectNameChar)
-    {
-        objectName.push_back(objectNameChar);
-        inputFile.get(objectNameChar);
-    }
-    
-    result.setName(objectName); 
-    return true;
+    if (inputFile.readString(objectName, length))
+        result.mName = mStrings.intern(objectName, length);
+
+    return inputFile.good();
 }
 
-bool DataFormat5DS::load(std::ifstream &srcFile) 
+bool DataFormat5DS::load(BinaryReader &srcFile)
 {
     Header new_header = {};
     read(srcFile, &new_header);
 
     if(new_header.mMagicByte != 0x00534435)
     {
-        //NOTE(DavoSK): add event handler 
+        //NOTE(DavoSK): add event handler
         return false;
     }
 
+    mSequences.clear();
+    mRotationFrames.clear();
+    mRotations.clear();
+    mMovementFrames.clear();
+    mMovements.clear();
+    mScaleFrames.clear();
+    mScales.clear();
+    mStrings.clear();
+
     auto begginingOfData = srcFile.tellg();
     Description new_desc = {};
     read(srcFile, &new_desc);
@@ -177,6 +86,10 @@ bool DataFormat5DS::load(std::ifstream &srcFile)
     for(unsigned int i = 0; i < new_desc.mNumberOfAnimatedObjects; i++)
     {
         read(srcFile, &new_pointer_table);
+
+        if (!srcFile.good())
+            break;
+
         auto nextBlock = srcFile.tellg();
 
         uint32_t pointerToName = static_cast<uint32_t>(((uint32_t) begginingOfData) + new_pointer_table.mPointerToString);
@@ -184,22 +97,12 @@ bool DataFormat5DS::load(std::ifstream &srcFile)
 
         AnimationSequence new_sequence = {};
         parseAnimationSequence(srcFile, pointerToData, pointerToName, new_sequence);
-        addAnimatedObject(new_sequence);
-    
+        mSequences.push_back(new_sequence);
+
         srcFile.seekg(nextBlock);
     }
 
-    return true;
-}
-
-const DataFormat5DS::AnimationSequence& DataFormat5DS::getSequence(unsigned int id) const
-{
-    return mSequences[id];
-}
-
-unsigned int DataFormat5DS::getTotalFrameCount() const
-{
-    return mTotalFrameCount;
+    return srcFile.good();
 }
 
 }
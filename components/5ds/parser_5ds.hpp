@@ -10,7 +10,10 @@ namespace MFFormat
 class DataFormat5DS: public DataFormat
 {
 public:
-    virtual bool load(std::ifstream &srcFile) override;
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+
+    static const unsigned int FRAMES_PER_SECOND = 25;
 
     typedef enum
     {
@@ -22,22 +25,22 @@ public:
     #pragma pack(push,1)
     typedef struct
     {
-        // should be "5DS\0" 
-        uint32_t mMagicByte; 
+        // should be "5DS\0"
+        uint32_t mMagicByte;
         // should be 0x14
         uint16_t mAnimationType;
         uint32_t mUnk1;
         uint32_t mUnk2;
         uint32_t mLengthOfAnimationData;
     } Header;
-   
+
     typedef struct
     {
         uint16_t mNumberOfAnimatedObjects;
         // Note: 25 frames = 1 seconds
         uint16_t mOverallCountOfFrames;
     } Description;
-    
+
     typedef struct
     {
         uint32_t mPointerToString;
@@ -46,42 +49,54 @@ public:
 
     #pragma pack(pop)
 
-    class AnimationSequence
+    typedef StringPool::String PoolString;  ///< use getString(...) to get the string
+
+    typedef struct
     {
-    public:
-        void setNumberOfSequences(uint16_t numberOfSequences);
-        void setType(uint16_t type);
-        void setName(const std::string& str);
-        void addTimestamp(uint32_t time);
-        void addMovement(MFMath::Vec3& data);
-        void addRotation(MFMath::Vec3& data);
-        void addScale(MFMath::Vec3& data);
-        const std::string getName();
-        uint16_t getCount() const;
-        const uint32_t& getTimestamp(uint16_t id) const;
-        const MFMath::Vec3& getMovement(uint16_t id) const;
-        const MFMath::Vec3& getRotation(uint16_t id) const;
-        const MFMath::Vec3& getScale(uint16_t id) const;
-        bool hasMovement() const;
-        bool hasRotation() const;
-        bool hasScale() const;
-    private:
-        std::string mObjectName;
-        std::vector<uint32_t> mTimestamps;
-        std::vector<MFMath::Vec3> mMovements;
-        std::vector<MFMath::Vec3> mRotations;
-        std::vector<MFMath::Vec3> mScale;
-        uint16_t mNumberOfSequences;
-        TypeOfSequence mType;
-    };
-
-    const AnimationSequence& getSequence(unsigned int id) const;
-    unsigned int getTotalFrameCount() const;
+        uint32_t mFirstKey;                // to the frame and value arrays of the channel
+        uint32_t mKeyCount;                // 0 if the channel isn't animated
+    } Keys;
+
+    /**
+      Keys of one animated object (a mesh of the 4DS model, by name). Each channel has its own key
+      frames, the keys of all the objects are stored one after another in the arrays of the format.
+    */
+    typedef struct
+    {
+        PoolString mName;
+        uint32_t mType;                    // TypeOfSequence flags
+        Keys mRotations;                   // getRotationFrames(), getRotations()
+        Keys mMovements;                   // getMovementFrames(), getMovements()
+        Keys mScales;                      // getScaleFrames(), getScales()
+    } AnimationSequence;
+
+    const AnimationSequence &getSequence(unsigned int id) const             { return mSequences[id];      }
+    size_t getNumSequences() const                                          { return mSequences.size();   }
+    unsigned int getTotalFrameCount() const                                 { return mTotalFrameCount;    }
+    std::string getString(const PoolString &str) const                      { return mStrings.getString(str); }
+
+    const std::vector<uint16_t> &getRotationFrames() const                  { return mRotationFrames;     }
+    const std::vector<MFMath::Quat> &getRotations() const                   { return mRotations;          }
+    const std::vector<uint16_t> &getMovementFrames() const                  { return mMovementFrames;     }
+    const std::vector<MFMath::Vec3> &getMovements() const                   { return mMovements;          }
+    const std::vector<uint16_t> &getScaleFrames() const                     { return mScaleFrames;        }
+    const std::vector<MFMath::Vec3> &getScales() const                      { return mScales;             }
+
 private:
-    void addAnimatedObject(AnimationSequence& seq);
-    bool parseAnimationSequence(std::ifstream& inputFile, uint32_t pointerData, uint32_t pointerName, AnimationSequence& result);
+    bool parseAnimationSequence(BinaryReader &inputFile, uint32_t pointerData, uint32_t pointerName, AnimationSequence& result);
+
+    template<typename T>
+    bool readKeys(BinaryReader &inputFile, std::vector<uint16_t> &frames, std::vector<T> &values, Keys &keys);
+
     std::vector<AnimationSequence> mSequences;
-    unsigned int mTotalFrameCount;
+    std::vector<uint16_t> mRotationFrames;
+    std::vector<MFMath::Quat> mRotations;
+    std::vector<uint16_t> mMovementFrames;
+    std::vector<MFMath::Vec3> mMovements;
+    std::vector<uint16_t> mScaleFrames;
+    std::vector<MFMath::Vec3> mScales;
+    StringPool mStrings;                   // object names
+    unsigned int mTotalFrameCount = 0;
 };
 
 }
@@ -4,7 +4,7 @@
 namespace MFFormat
 {
 
-bool DataFormat6DS::load(std::ifstream &srcFile)
+bool DataFormat6DS::load(BinaryReader &srcFile)
 {
     Header header = {};
     read(srcFile, &header);
@@ -36,13 +36,14 @@ public:
     } Link;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<MFMath::Vec3> getVertices()  { return mVertices;        }
-    inline size_t getNumVertices()                  { return mVertices.size(); }
-    inline std::vector<Face> getFaces()             { return mFaces;           }
-    inline size_t getNumFaces()                     { return mFaces.size();    }
-    inline std::vector<Link> getLinks()             { return mLinks;           }
-    inline size_t getNumLinks()                     { return mLinks.size();    }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<MFMath::Vec3> &getVertices() const  { return mVertices;        }
+    inline size_t getNumVertices() const                         { return mVertices.size(); }
+    inline const std::vector<Face> &getFaces() const             { return mFaces;           }
+    inline size_t getNumFaces() const                            { return mFaces.size();    }
+    inline const std::vector<Link> &getLinks() const             { return mLinks;           }
+    inline size_t getNumLinks() const                            { return mLinks.size();    }
 
 private:
     std::vector<MFMath::Vec3> mVertices;
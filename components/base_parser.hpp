@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <sstream>
 #include <cstdint>
 #include <vector>
@@ -14,12 +15,286 @@
 namespace MFFormat
 {
 
-/// Abstract class representing a game data format.
+/**
+  Bounds-checked read cursor over a file loaded into memory (a mapped file, a buffer decoded from
+  DTA, ...). Mimics the part of the std::istream interface the parsers use: reading past the end
+  doesn't touch the destination, puts the reader into a failed state and makes all the following
+  reads fail too, so a truncated or corrupt file can't make a parser read out of the buffer.
+*/
+
+class BinaryReader
+{
+public:
+    static constexpr std::ios_base::seekdir beg = std::ios::beg;
+    static constexpr std::ios_base::seekdir cur = std::ios::cur;
+    static constexpr std::ios_base::seekdir end = std::ios::end;
+
+    BinaryReader(const char *data, size_t size)
+    {
+        mData = data;
+        mSize = size;
+        mPos = 0;
+        mFailed = false;
+    }
+
+    bool read(char *dst, size_t size)
+    {
+        if (mFailed || size > mSize - mPos)
+        {
+            mFailed = true;
+            return false;
+        }
+
+        memcpy(dst,mData + mPos,size);
+        mPos += size;
+        return true;
+    }
+
+    bool get(char &c)                 { return read(&c,1);                         }
+
+    /// Returns a pointer to the next size bytes and skips them, nullptr if there aren't enough.
+    const char *skip(size_t size)
+    {
+        if (mFailed || size > mSize - mPos)
+        {
+            mFailed = true;
+            return nullptr;
+        }
+
+        mPos += size;
+        return mData + mPos - size;
+    }
+
+    void seekg(size_t position)       { seekg(position,beg);                       }
+
+    void seekg(std::streamoff offset, std::ios_base::seekdir direction)
+    {
+        std::streamoff base = direction == beg ? 0 : (direction == cur ? mPos : mSize);
+
+        if (mFailed || base + offset < 0 || base + offset > (std::streamoff) mSize)
+            mFailed = true;
+        else
+            mPos = base + offset;
+    }
+
+    std::streamoff tellg() const      { return mFailed ? -1 : mPos;                }   ///< -1 after a failure, like std::istream
+    bool good() const                 { return !mFailed;                           }
+    explicit operator bool() const    { return !mFailed;                           }
+    bool eof() const                  { return mPos >= mSize;                      }
+    size_t size() const               { return mSize;                              }
+    const char *data() const          { return mData;                              }
+
+    /// Length of the zero-terminated string at the cursor including the terminator, 0 if unterminated.
+    size_t peekLength() const
+    {
+        const void *terminator = mFailed ? nullptr : memchr(mData + mPos,0,mSize - mPos);
+        return terminator ? (const char *) terminator - (mData + mPos) + 1 : 0;
+    }
+
+    bool readString(std::string &str)     ///< Reads a zero-terminated string.
+    {
+        size_t length = peekLength();
+
+        if (length == 0)
+        {
+            mFailed = true;
+            return false;
+        }
+
+        str.assign(mData + mPos,length - 1);
+        mPos += length;
+        return true;
+    }
+
+    /// Like readString(...) above but without copying, str then points into the buffer.
+    bool readString(const char *&str, size_t &length)
+    {
+        length = peekLength();
+
+        if (length == 0)
+        {
+            mFailed = true;
+            return false;
+        }
+
+        str = mData + mPos;
+        mPos += length;
+        length--;
+        return true;
+    }
+
+protected:
+    const char *mData;
+    size_t mSize;
+    size_t mPos;
+    bool mFailed;
+};
+
+/**
+  Contiguous storage of zero-terminated strings referenced by offset, so that parsed records don't
+  have to allocate for their names. Strings added with intern(...) are stored once: adding the same
+  string again returns the stored one. Offset 0 always holds the empty string, so a zero-initialized
+  String is valid.
+*/
+
+class StringPool
+{
+public:
+    typedef struct
+    {
+        uint32_t mOffset;
+        uint32_t mLength;                  // without the terminator
+    } String;
+
+    StringPool()                                  { clear();                                  }
+
+    void clear()
+    {
+        mData.assign(1,0);
+        mSlots.clear();
+        mCount = 0;
+    }
+
+    /// Stores given string followed by given suffix, unless the same string is already stored.
+    String intern(const char *str, size_t length, const char *suffix = "")
+    {
+        String result = append(str,length,suffix);
+
+        if (result.mLength == 0)
+        {
+            mData.resize(result.mOffset);
+            return String {0,0};
+        }
+
+        if ((mCount + 1) * 2 > mSlots.size())
+            rehash(mSlots.size() > 0 ? mSlots.size() * 2 : 256);
+
+        const char *s = mData.data() + result.mOffset;
+        size_t slot = findSlot(s,result.mLength);
+
+        if (mSlots[slot].mLength > 0)          // already there, drop the copy
+        {
+            mData.resize(result.mOffset);
+            return mSlots[slot];
+        }
+
+        mSlots[slot] = result;
+        mCount++;
+        return result;
+    }
+
+    /// Stores given bytes as they are, without looking for a stored copy (e.g. a list of names).
+    String add(const char *data, size_t length)   { return append(data,length,"");            }
+
+    /// Looks up an interned string, returns false if it has never been added.
+    bool find(const char *str, size_t length, String &result) const
+    {
+        if (length == 0 || mSlots.size() == 0)
+        {
+            result = String {0,0};
+            return length == 0;
+        }
+
+        result = mSlots[findSlot(str,length)];
+        return result.mLength > 0;
+    }
+
+    const char *get(const String &str) const      { return mData.data() + str.mOffset;        }
+    const char *data() const                      { return mData.data();                      }   ///< all the strings, e.g. to save them
+    std::string getString(const String &str) const   { return std::string(get(str),str.mLength); }
+    size_t size() const                           { return mData.size();                      }
+
+protected:
+    String append(const char *str, size_t length, const char *suffix)
+    {
+        size_t suffixLength = strlen(suffix);
+        String result = {(uint32_t) mData.size(),(uint32_t) (length + suffixLength)};
+
+        mData.insert(mData.end(),str,str + length);
+        mData.insert(mData.end(),suffix,suffix + suffixLength);
+        mData.push_back(0);
+        return result;
+    }
+
+    static uint32_t hash(const char *str, size_t length)
+    {
+        uint32_t h = 2166136261u;    // FNV-1a
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            h ^= (unsigned char) str[i];
+            h *= 16777619u;
+        }
+
+        return h;
+    }
+
+    /// Open addressing with linear probing, returns the slot holding the string or the empty one to put it in.
+    size_t findSlot(const char *str, size_t length) const
+    {
+        size_t mask = mSlots.size() - 1;
+        size_t slot = hash(str,length) & mask;
+
+        while (mSlots[slot].mLength > 0 &&
+            (mSlots[slot].mLength != length || memcmp(mData.data() + mSlots[slot].mOffset,str,length) != 0))
+            slot = (slot + 1) & mask;
+
+        return slot;
+    }
+
+    void rehash(size_t slotCount)
+    {
+        std::vector<String> oldSlots(slotCount,String {0,0});
+        oldSlots.swap(mSlots);
+
+        for (const auto &s : oldSlots)
+            if (s.mLength > 0)
+                mSlots[findSlot(get(s),s.mLength)] = s;
+    }
+
+    std::vector<char> mData;
+    std::vector<String> mSlots;            // length 0 = empty slot
+    size_t mCount;
+};
+
+/**
+  Abstract class representing a game data format. Parsers work on files loaded into memory (see
+  BinaryReader), load(std::ifstream&) just reads the whole file and passes it on. Formats too big
+  to be loaded at once (DTA) override the stream version instead.
+
+  Derived classes have to add "using DataFormat::load;" so that the overloads they don't override
+  stay visible.
+*/
 
 class DataFormat
 {
 public:
-    virtual bool load(std::ifstream &srcFile)=0;
+    virtual bool load(std::ifstream &srcFile)
+    {
+        srcFile.seekg(0,std::ios::end);
+        std::streamoff size = srcFile.tellg();
+        srcFile.seekg(0,std::ios::beg);
+
+        if (size < 0 || !srcFile.good())
+            return false;
+
+        std::vector<char> data(size);
+        srcFile.read(data.data(),size);
+
+        if (!srcFile.good())
+            return false;
+
+        return load(data.data(),data.size());
+    }
+
+    virtual bool load(BinaryReader &srcFile)     { return false; /* optional */ };
+
+    bool load(const char *data, size_t size)
+    {
+        BinaryReader reader(data,size);
+        return load(reader);
+    }
+
     virtual bool save(std::ofstream &dstFile)    { return false; /* optional */ };
     virtual std::string getErrorStr()            { return "Unknown error";      };
 
@@ -30,6 +305,27 @@ protected:
         stream.read((char*)a, size);
     }
 
+    template<typename T>
+    void read(BinaryReader & reader, T* a, size_t size = sizeof(T))
+    {
+        reader.read((char*)a, size);
+    }
+
+    /// Appends count records stored one after another in a single copy, fails if the file is shorter.
+    template<typename T>
+    bool readArray(BinaryReader & reader, std::vector<T> &v, size_t count)
+    {
+        const char *src = reader.skip(count * sizeof(T));
+
+        if (!src)
+            return false;
+
+        size_t start = v.size();
+        v.resize(start + count);
+        memcpy(v.data() + start, src, count * sizeof(T));
+        return true;
+    }
+
     std::streamsize fileLength(std::ifstream &f);
 
     uint32_t mErrorCode = 0;
@@ -11,14 +11,14 @@ osg::ref_ptr<osg::Node> OSGCachedCityLoader::load(MFFormat::DataFormatCacheBIN *
     MFLogger::Logger::info("loading cache.bin", OSGCACHEBIN_MODULE_STR);
     MFFormat::OSGModelLoader loader4DS;
     
-    for (auto object : format->getObjects())
+    for (const auto &object : format->getObjects())
     {
         MFLogger::Logger::info("Loading object " + object.mObjectName + ".", OSGCACHEBIN_MODULE_STR);
         
         osg::ref_ptr<osg::Group> objectGroup = new osg::Group();
         group->setName("object group");
 
-        for (auto instance : object.mInstances)
+        for (const auto &instance : object.mInstances)
         {
             osg::ref_ptr<osg::Node> objectNode = mObjectFactory->loadModel(instance.mModelName);
                 
@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatCacheBIN::load(std::ifstream &srcFile) 
+bool DataFormatCacheBIN::load(BinaryReader &srcFile) 
 {
     Header newHeader = {};
     read(srcFile, &newHeader);
@@ -11,13 +11,17 @@ bool DataFormatCacheBIN::load(std::ifstream &srcFile)
     Chunk newChunk = {};
     read(srcFile, &newChunk.mVersion);
 
-    while((uint32_t)srcFile.tellg() < newHeader.mSize - sizeof(uint32_t)) 
+    while(srcFile.good() && (uint32_t)srcFile.tellg() < newHeader.mSize - sizeof(uint32_t)) 
     {
         Object newObject = {};
         uint32_t objectNameLength, modelNameLength;
         
         read(srcFile, &newObject.mHeader);
         read(srcFile, &objectNameLength);
+
+        if (!srcFile.good())
+            break;
+
         char *objectName = reinterpret_cast<char*>(malloc(objectNameLength + 1));
         read(srcFile, objectName, objectNameLength);
         objectName[objectNameLength] = '\0';
@@ -28,13 +32,17 @@ bool DataFormatCacheBIN::load(std::ifstream &srcFile)
 
         size_t current_pos = srcFile.tellg();
         size_t header_size = sizeof(Header) + sizeof(uint32_t) + objectNameLength + 0x4C;
-        while((uint32_t)srcFile.tellg() < current_pos + newObject.mHeader.mSize - header_size)
+        while(srcFile.good() && (uint32_t)srcFile.tellg() < current_pos + newObject.mHeader.mSize - header_size)
         {
             Instance newInstance = {};
 
             read(srcFile, &newInstance.mHeader);
 
             read(srcFile, &modelNameLength);
+
+            if (!srcFile.good() || modelNameLength < 4)
+                break;
+
             char *modelName = reinterpret_cast<char*>(malloc(modelNameLength + 1));
             read(srcFile, modelName, modelNameLength);
             modelName[modelNameLength - 4] = '\0';
@@ -44,11 +44,12 @@ public:
         uint32_t mVersion; // NOTE(zaklaus): Should always be 1.
     } Chunk;
 
-    virtual bool load(std::ifstream &srcFile) override;
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
 
-    inline std::vector<Object> getObjects()     { return mObjects; }
-    inline size_t getNumObjects()               { return mObjects.size(); }
-    inline Object* getObject(size_t index)      { return &mObjects.at(index); }
+    inline const std::vector<Object> &getObjects() const  { return mObjects; }
+    inline size_t getNumObjects() const                   { return mObjects.size(); }
+    inline Object* getObject(size_t index)                { return &mObjects.at(index); }
 private:
     std::vector<Object> mObjects;
 };
@@ -3,20 +3,20 @@
 namespace MFFormat
 {
 
-std::vector<OSGCheckBinLoader::Line> OSGCheckBinLoader::resolveLinks(MFFormat::DataFormatCheckBIN parser)
+std::vector<OSGCheckBinLoader::Line> OSGCheckBinLoader::resolveLinks(const MFFormat::DataFormatCheckBIN &parser)
 {
     std::vector<Line> mPointsConnections;
-    auto links = parser.getLinks();
-    auto points = parser.getPoints();
+    const auto &links = parser.getLinks();
+    const auto &points = parser.getPoints();
 
     size_t linkIndex = 0;
-    for(auto point : points) 
+    for(const auto &point : points) 
     {
         if(point.mEnterLinks > 0) 
         {
             for(size_t i = linkIndex; i < linkIndex + point.mEnterLinks; i++)
             {
-                auto currentLink = links.at(i);
+                const auto &currentLink = links.at(i);
                 if(currentLink.mTargetPoint > 0 && currentLink.mTargetPoint < points.size()) 
                 {
                     auto targetPoint = points.at(currentLink.mTargetPoint);
@@ -112,7 +112,7 @@ osg::ref_ptr<osg::Node> OSGCheckBinLoader::load(std::ifstream &srcFile, std::str
 
         } //for links
 
-        for (auto point : parser.getPoints())
+        for (const auto &point : parser.getPoints())
         {   
             osg::ref_ptr<osg::MatrixTransform> objectTransform = new osg::MatrixTransform();    
             osg::Matrixd m;
@@ -26,7 +26,7 @@ public:
     } Line;
 
     osg::ref_ptr<osg::Node> load(std::ifstream &srcFile, std::string fileName = "");
-    std::vector<Line> resolveLinks(MFFormat::DataFormatCheckBIN parser);
+    std::vector<Line> resolveLinks(const MFFormat::DataFormatCheckBIN &parser);
     size_t getColorFromIndexOfType(uint16_t type);
 };
 
@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatCheckBIN::load(std::ifstream &srcFile)
+bool DataFormatCheckBIN::load(BinaryReader &srcFile)
 {
     Header header = {};
     read(srcFile, &header);
@@ -53,11 +53,12 @@ public:
     } Link;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<Point> getPoints()     { return mPoints; }
-    inline size_t getNumPoints()              { return mPoints.size(); }
-    inline std::vector<Link> getLinks()       { return mLinks; }
-    inline size_t getNumLinks()               { return mLinks.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<Point> &getPoints() const  { return mPoints; }
+    inline size_t getNumPoints() const                  { return mPoints.size(); }
+    inline const std::vector<Link> &getLinks() const    { return mLinks; }
+    inline size_t getNumLinks() const                   { return mLinks.size(); }
 
 private:
     std::vector<Point> mPoints;
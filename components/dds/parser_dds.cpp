@@ -0,0 +1,433 @@
+#include <dds/parser_dds.hpp>
+#include <filesystem>
+#include <thread>
+#include <cmath>
+
+namespace MFFormat
+{
+
+static uint16_t to565(const int color[3])
+{
+    return ((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255);
+}
+
+static void from565(uint16_t c, int color[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/// The 4 colors of a color block, returns whether the block is in the 4 color mode.
+static bool makePalette(uint16_t c0, uint16_t c1, bool alwaysFourColors, int palette[4][4])
+{
+    from565(c0,palette[0]);
+    from565(c1,palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+
+    bool fourColors = alwaysFourColors || c0 > c1;
+
+    for (int c = 0; c < 3; ++c)
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+    return fourColors;
+}
+
+void DataFormatDDS::encodeColorBlock(const uint8_t rgba[64], uint8_t dst[8], bool bc1)
+{
+    // end points: the extremes of the pixels along their principal axis, moved inwards a bit
+
+    float mean[3] = {0,0,0};
+
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += rgba[i * 4 + c] / 16.0f;
+
+    float covariance[6] = {0,0,0,0,0,0};      // rr rg rb gg gb bb
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[3] = {rgba[i * 4] - mean[0],rgba[i * 4 + 1] - mean[1],rgba[i * 4 + 2] - mean[2]};
+
+        covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+        covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+    }
+
+    float axis[3] = {1,1,1};
+
+    for (int iteration = 0; iteration < 8; ++iteration)     // power iteration
+    {
+        float a[3] = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+
+        float length = std::max(std::abs(a[0]),std::max(std::abs(a[1]),std::abs(a[2])));
+
+        if (length < 1e-6f)
+            break;        // all pixels of the same color
+
+        for (int c = 0; c < 3; ++c)
+            axis[c] = a[c] / length;
+    }
+
+    float minProjection = 1e30f, maxProjection = -1e30f;
+    int minPixel = 0, maxPixel = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float projection = rgba[i * 4] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+
+        if (projection < minProjection) { minProjection = projection; minPixel = i; }
+        if (projection > maxProjection) { maxProjection = projection; maxPixel = i; }
+    }
+
+    int endPoints[2][3];
+
+    for (int c = 0; c < 3; ++c)
+    {
+        int high = rgba[maxPixel * 4 + c], low = rgba[minPixel * 4 + c];
+        int inset = (high - low) / 16;
+
+        endPoints[0][c] = std::max(0,std::min(255,high - inset));
+        endPoints[1][c] = std::max(0,std::min(255,low + inset));
+    }
+
+    uint16_t c0 = to565(endPoints[0]);
+    uint16_t c1 = to565(endPoints[1]);
+
+    if (bc1 && c0 < c1)
+        std::swap(c0,c1);     // BC1 blocks with c0 <= c1 have a transparent color
+
+    int palette[4][4];
+    makePalette(c0,c1,!bc1,palette);
+
+    uint32_t indices = 0;
+
+    if (c0 != c1)
+        for (int i = 15; i >= 0; --i)
+        {
+            int best = 0, bestDistance = 1 << 30;
+
+            for (int p = 0; p < 4; ++p)
+            {
+                int distance = 0;
+
+                for (int c = 0; c < 3; ++c)
+                    distance += (rgba[i * 4 + c] - palette[p][c]) * (rgba[i * 4 + c] - palette[p][c]);
+
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+
+            indices = (indices << 2) | best;
+        }
+
+    dst[0] = c0 & 0xff; dst[1] = c0 >> 8;
+    dst[2] = c1 & 0xff; dst[3] = c1 >> 8;
+
+    for (int i = 0; i < 4; ++i)
+        dst[4 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+void DataFormatDDS::encodeBlockBC1(const uint8_t rgba[64], uint8_t dst[8])
+{
+    encodeColorBlock(rgba,dst,true);
+}
+
+void DataFormatDDS::encodeBlockBC3(const uint8_t rgba[64], uint8_t dst[16])
+{
+    int a0 = 0, a1 = 255;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        a0 = std::max<int>(a0,rgba[i * 4 + 3]);
+        a1 = std::min<int>(a1,rgba[i * 4 + 3]);
+    }
+
+    int palette[8] = {a0,a1};
+
+    for (int i = 1; i < 7; ++i)    // 8 alpha mode (a0 > a1)
+        palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+    uint64_t indices = 0;
+
+    if (a0 != a1)
+        for (int i = 15; i >= 0; --i)
+        {
+            int best = 0, bestDistance = 256;
+
+            for (int p = 0; p < 8; ++p)
+                if (std::abs(rgba[i * 4 + 3] - palette[p]) < bestDistance)
+                {
+                    best = p;
+                    bestDistance = std::abs(rgba[i * 4 + 3] - palette[p]);
+                }
+
+            indices = (indices << 3) | best;
+        }
+
+    dst[0] = a0;
+    dst[1] = a1;
+
+    for (int i = 0; i < 6; ++i)
+        dst[2 + i] = (indices >> (i * 8)) & 0xff;
+
+    encodeColorBlock(rgba,dst + 8,false);
+}
+
+static void decodeColorBlock(const uint8_t src[8], uint8_t rgba[64], bool alwaysFourColors)
+{
+    int palette[4][4];
+    makePalette(src[0] | (src[1] << 8),src[2] | (src[3] << 8),alwaysFourColors,palette);
+
+    uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | ((uint32_t) src[7] << 24);
+
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            rgba[i * 4 + c] = palette[(indices >> (i * 2)) & 3][c];
+}
+
+void DataFormatDDS::decodeBlockBC1(const uint8_t src[8], uint8_t rgba[64])
+{
+    decodeColorBlock(src,rgba,false);
+}
+
+void DataFormatDDS::decodeBlockBC3(const uint8_t src[16], uint8_t rgba[64])
+{
+    decodeColorBlock(src + 8,rgba,true);
+
+    int a0 = src[0], a1 = src[1];
+    int palette[8] = {a0,a1};
+
+    for (int i = 1; i < 7; ++i)
+        palette[i + 1] = a0 > a1 ? ((7 - i) * a0 + i * a1) / 7 : 0;
+
+    if (a0 <= a1)    // 6 alpha mode
+    {
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+
+    for (int i = 5; i >= 0; --i)
+        indices = (indices << 8) | src[2 + i];
+
+    for (int i = 0; i < 16; ++i)
+        rgba[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+}
+
+size_t DataFormatDDS::getLevelSize(unsigned int level) const
+{
+    return ((getWidth(level) + 3) / 4) * ((getHeight(level) + 3) / 4) * getBlockSize(mFormat);
+}
+
+bool DataFormatDDS::compress(const uint8_t *rgba, uint32_t width, uint32_t height, bool mipmaps)
+{
+    if (width == 0 || height == 0)
+        return false;
+
+    mWidth = width;
+    mHeight = height;
+    mFormat = FORMAT_BC1;
+    mData.clear();
+    mLevelOffsets.clear();
+
+    for (size_t i = 0; i < (size_t) width * height; ++i)
+        if (rgba[i * 4 + 3] != 255)
+        {
+            mFormat = FORMAT_BC3;
+            break;
+        }
+
+    std::vector<uint8_t> level(rgba,rgba + (size_t) width * height * 4);
+    std::vector<uint8_t> nextLevel;
+
+    while (true)
+    {
+        const unsigned int l = mLevelOffsets.size();
+        const uint32_t w = getWidth(l), h = getHeight(l);
+
+        mLevelOffsets.push_back(mData.size());
+        mData.resize(mData.size() + getLevelSize(l));
+        uint8_t *dst = mData.data() + mLevelOffsets.back();
+
+        for (uint32_t by = 0; by < h; by += 4)
+            for (uint32_t bx = 0; bx < w; bx += 4)
+            {
+                uint8_t block[64];
+
+                for (uint32_t y = 0; y < 4; ++y)       // the edge pixels repeat in partial blocks
+                    for (uint32_t x = 0; x < 4; ++x)
+                        memcpy(block + (y * 4 + x) * 4,level.data() + ((size_t) std::min(by + y,h - 1) * w + std::min(bx + x,w - 1)) * 4,4);
+
+                if (mFormat == FORMAT_BC1)
+                    encodeBlockBC1(block,dst);
+                else
+                    encodeBlockBC3(block,dst);
+
+                dst += getBlockSize(mFormat);
+            }
+
+        if (!mipmaps || (w == 1 && h == 1))
+            break;
+
+        // 2x2 box filter, an odd row or column gets averaged with its neighbour
+
+        const uint32_t nw = getWidth(l + 1), nh = getHeight(l + 1);
+        nextLevel.resize((size_t) nw * nh * 4);
+
+        for (uint32_t y = 0; y < nh; ++y)
+            for (uint32_t x = 0; x < nw; ++x)
+            {
+                const uint32_t x0 = std::min(x * 2,w - 1), x1 = std::min(x * 2 + 1,w - 1);
+                const uint32_t y0 = std::min(y * 2,h - 1), y1 = std::min(y * 2 + 1,h - 1);
+
+                for (int c = 0; c < 4; ++c)
+                    nextLevel[((size_t) y * nw + x) * 4 + c] = (
+                        level[((size_t) y0 * w + x0) * 4 + c] + level[((size_t) y0 * w + x1) * 4 + c] +
+                        level[((size_t) y1 * w + x0) * 4 + c] + level[((size_t) y1 * w + x1) * 4 + c] + 2) / 4;
+            }
+
+        level.swap(nextLevel);
+    }
+
+    return true;
+}
+
+bool DataFormatDDS::decompress(unsigned int level, std::vector<uint8_t> &rgba) const
+{
+    if (level >= getNumLevels())
+        return false;
+
+    const uint32_t w = getWidth(level), h = getHeight(level);
+    const uint8_t *src = mData.data() + mLevelOffsets[level];
+
+    rgba.resize((size_t) w * h * 4);
+
+    for (uint32_t by = 0; by < h; by += 4)
+        for (uint32_t bx = 0; bx < w; bx += 4)
+        {
+            uint8_t block[64];
+
+            if (mFormat == FORMAT_BC1)
+                decodeBlockBC1(src,block);
+            else
+                decodeBlockBC3(src,block);
+
+            src += getBlockSize(mFormat);
+
+            for (uint32_t y = 0; y < 4 && by + y < h; ++y)
+                for (uint32_t x = 0; x < 4 && bx + x < w; ++x)
+                    memcpy(rgba.data() + ((size_t) (by + y) * w + bx + x) * 4,block + (y * 4 + x) * 4,4);
+        }
+
+    return true;
+}
+
+bool DataFormatDDS::load(BinaryReader &srcFile)
+{
+    Header header;
+    read(srcFile,&header);
+
+    if (!srcFile.good() || header.mMagic != MAGIC || header.mSize != 124 || header.mPixelFormat.mSize != 32)
+        return false;
+
+    if (header.mPixelFormat.mFourCC != FOURCC_DXT1 && header.mPixelFormat.mFourCC != FOURCC_DXT5)
+        return false;
+
+    if (header.mWidth == 0 || header.mHeight == 0 || header.mWidth > 16384 || header.mHeight > 16384)
+        return false;
+
+    mWidth = header.mWidth;
+    mHeight = header.mHeight;
+    mFormat = header.mPixelFormat.mFourCC == FOURCC_DXT1 ? FORMAT_BC1 : FORMAT_BC3;
+    mData.clear();
+    mLevelOffsets.clear();
+
+    const unsigned int levels = std::max(1u,header.mMipMapCount);
+    size_t size = 0;
+
+    for (unsigned int l = 0; l < levels && l < 32; ++l)
+    {
+        mLevelOffsets.push_back(size);
+        size += getLevelSize(l);
+
+        if (getWidth(l) == 1 && getHeight(l) == 1)
+            break;
+    }
+
+    const char *data = srcFile.skip(size);
+
+    if (!data)
+        return false;
+
+    mData.assign(data,data + size);
+    return true;
+}
+
+bool DataFormatDDS::save(std::ofstream &dstFile)
+{
+    if (mLevelOffsets.empty())
+        return false;
+
+    Header header = {};
+    header.mMagic = MAGIC;
+    header.mSize = 124;
+    header.mFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (getNumLevels() > 1 ? 0x20000 : 0);   // caps, height, width, pixel format, linear size, mip map count
+    header.mHeight = mHeight;
+    header.mWidth = mWidth;
+    header.mPitchOrLinearSize = getLevelSize(0);
+    header.mMipMapCount = getNumLevels();
+    header.mPixelFormat.mSize = 32;
+    header.mPixelFormat.mFlags = 0x4;                // four CC
+    header.mPixelFormat.mFourCC = mFormat == FORMAT_BC1 ? FOURCC_DXT1 : FOURCC_DXT5;
+    header.mCaps[0] = 0x1000 | (getNumLevels() > 1 ? 0x400008 : 0);                            // texture, mip map, complex
+
+    dstFile.write((const char *) &header,sizeof(header));
+    dstFile.write((const char *) mData.data(),mData.size());
+    return dstFile.good();
+}
+
+bool DataFormatDDS::save(const std::string &fileName)
+{
+    // several threads may store the same texture at once
+
+    std::string tmpFileName = fileName + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    std::ofstream f(tmpFileName,std::ios::binary);
+    std::error_code error;
+
+    bool success = save(f);
+    f.close();
+
+    if (!success || !f.good())
+    {
+        std::filesystem::remove(tmpFileName,error);
+        return false;
+    }
+
+    std::filesystem::rename(tmpFileName,fileName,error);
+    return !error;
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef FORMAT_PARSERS_DDS_H
+#define FORMAT_PARSERS_DDS_H
+
+#include <base_parser.hpp>
+#include <algorithm>
+
+namespace MFFormat
+{
+
+/**
+  DDS texture with BC1 (DXT1) or BC3 (DXT5) compressed mip levels, used to keep compressed game
+  textures on disk (see OSGTextureJobs). Only these two formats are read. The rows are kept in the
+  order they were compressed in (OSG's bottom-up), the files are not meant for other programs.
+*/
+
+class DataFormatDDS: public DataFormat
+{
+public:
+    typedef enum
+    {
+        FORMAT_BC1 = 0,      ///< RGB, 8 bytes per 4x4 block
+        FORMAT_BC3           ///< RGBA, 16 bytes per 4x4 block
+    } Format;
+
+    #pragma pack(push,1)
+    typedef struct
+    {
+        uint32_t mSize;                    // 32
+        uint32_t mFlags;
+        uint32_t mFourCC;
+        uint32_t mRGBBitCount;
+        uint32_t mBitMasks[4];
+    } PixelFormat;
+
+    typedef struct
+    {
+        uint32_t mMagic;                   // 'DDS '
+        uint32_t mSize;                    // 124
+        uint32_t mFlags;
+        uint32_t mHeight;
+        uint32_t mWidth;
+        uint32_t mPitchOrLinearSize;
+        uint32_t mDepth;
+        uint32_t mMipMapCount;
+        uint32_t mReserved1[11];
+        PixelFormat mPixelFormat;
+        uint32_t mCaps[4];
+        uint32_t mReserved2;
+    } Header;
+    #pragma pack(pop)
+
+    static const uint32_t MAGIC = 0x20534444;
+    static const uint32_t FOURCC_DXT1 = 0x31545844;
+    static const uint32_t FOURCC_DXT5 = 0x35545844;
+
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    virtual bool save(std::ofstream &dstFile) override;
+    bool save(const std::string &fileName);              ///< Writes a temporary file first, so readers never see a partial file.
+
+    /**
+      Compresses 8 bit RGBA pixels (rows of width pixels) to BC1 if they're all opaque, otherwise to BC3,
+      with all the mip levels down to 1x1 if mipmaps is true.
+    */
+    bool compress(const uint8_t *rgba, uint32_t width, uint32_t height, bool mipmaps=true);
+
+    /// Decompresses a mip level to 8 bit RGBA.
+    bool decompress(unsigned int level, std::vector<uint8_t> &rgba) const;
+
+    static void encodeBlockBC1(const uint8_t rgba[64], uint8_t dst[8]);
+    static void encodeBlockBC3(const uint8_t rgba[64], uint8_t dst[16]);
+    static void decodeBlockBC1(const uint8_t src[8], uint8_t rgba[64]);
+    static void decodeBlockBC3(const uint8_t src[16], uint8_t rgba[64]);
+
+    uint32_t getWidth(unsigned int level=0) const        { return std::max(1u,mWidth >> level);                  }
+    uint32_t getHeight(unsigned int level=0) const       { return std::max(1u,mHeight >> level);                 }
+    Format getFormat() const                             { return mFormat;                                        }
+    unsigned int getNumLevels() const                    { return mLevelOffsets.size();                           }
+    const uint8_t *getData() const                       { return mData.data();                                   }
+    size_t getSize() const                               { return mData.size();                                   }
+    size_t getLevelOffset(unsigned int level) const      { return mLevelOffsets[level];                           }
+    size_t getLevelSize(unsigned int level) const;
+
+    static size_t getBlockSize(Format format)            { return format == FORMAT_BC1 ? 8 : 16;                  }
+
+protected:
+    static void encodeColorBlock(const uint8_t rgba[64], uint8_t dst[8], bool bc1);   ///< bc1: keeps the block in the 4 color mode
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    Format mFormat = FORMAT_BC1;
+    std::vector<uint8_t> mData;                          ///< all the levels one after another
+    std::vector<size_t> mLevelOffsets;
+};
+
+}
+
+#endif // FORMAT_PARSERS_DDS_H
@@ -1,5 +1,9 @@
 #include <dta/parser_dta.hpp>
 
+#if defined(__SSE2__) || defined(__AVX2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 namespace MFFormat
 {
 
@@ -135,23 +139,68 @@ bool DataFormatDTA::load(std::ifstream &srcFile)
         mDataFileHeaders.push_back(h);
     }
 
+    // build the name index:
+
+    mFileNameIndex.clear();
+    mFileNameIndex.reserve(mDataFileHeaders.size());
+    mChecksumFilter.assign(0x10000,false);
+    mChecksumsValid = true;
+
+    for (unsigned int i = 0; i < mDataFileHeaders.size(); ++i)
+    {
+        uint16_t checksum;
+        mFileNameIndex.emplace(canonicalizeName(getFileName(i),&checksum),i);
+
+        mChecksumFilter[mFileTableRecords[i].mFileNameChecksum] = true;
+        mChecksumsValid = mChecksumsValid && checksum == mFileTableRecords[i].mFileNameChecksum;
+    }
+
     return true;
 }
 
-int DataFormatDTA::getFileIndex(std::string fileName)
+std::string DataFormatDTA::canonicalizeName(const std::string &fileName, uint16_t *checksum)
 {
-    for (int i = 0; i < (int) mDataFileHeaders.size(); i++)
-        if (fileName.compare((char *) mDataFileHeaders[i].mName) == 0)
-            return i;
+    std::string result = fileName;
+    uint16_t sum = 0;
 
-    return -1;
+    for (auto& c : result)
+    {
+        c = c == '/' ? '\\' : (char) toupper((unsigned char) c);
+        sum += (unsigned char) c;
+    }
+
+    if (checksum)
+        *checksum = sum;
+
+    return result;
 }
 
-MFUtil::ScopedBuffer DataFormatDTA::getFile(std::ifstream &srcFile, unsigned int index)
+int DataFormatDTA::getFileIndex(const std::string &fileName) const
 {
-    unsigned length = getFileSize(index);
-    MFUtil::ScopedBuffer dstBuffer(length);
+    uint16_t checksum;
+    std::string name = canonicalizeName(fileName,&checksum);
+
+    if (mChecksumsValid && !mChecksumFilter[checksum])
+        return -1;
 
+    auto it = mFileNameIndex.find(name);
+    return it != mFileNameIndex.end() ? (int) it->second : -1;
+}
+
+std::vector<int> DataFormatDTA::getFileIndices(const std::vector<std::string> &fileNames) const
+{
+    std::vector<int> result;
+    result.reserve(fileNames.size());
+
+    for (const auto& fileName : fileNames)
+        result.push_back(getFileIndex(fileName));
+
+    return result;
+}
+
+bool DataFormatDTA::getFile(std::ifstream &srcFile, unsigned int index, char *dst)
+{
+    unsigned length = getFileSize(index);
     unsigned int fileOffset = mFileTableRecords[index].mDataOffset;
 
     srcFile.clear();
@@ -165,59 +214,277 @@ MFUtil::ScopedBuffer DataFormatDTA::getFile(std::ifstream &srcFile, unsigned int
 
     for (uint32_t i = 0; i < mDataFileHeaders[index].mCompressedBlockCount; ++i)
     {
-        // FIXME: make this function nicer
         uint32_t blockSize;     // compressed size
 
         srcFile.read((char *) &blockSize,sizeof(blockSize));
         blockSize = blockSize & 0xffff;
 
-        MFUtil::ScopedBuffer block(blockSize);
+        if (!srcFile.good() || blockSize < 1)     // at least the type byte
+            return false;
+
+        std::vector<char> block(blockSize);
 
-        srcFile.read(block,blockSize);
+        srcFile.read(block.data(),blockSize);
+
+        if (!srcFile.good())
+            return false;
 
         if (blockEncrypted)
-            decrypt(block,blockSize);
+            decrypt(block.data(),blockSize);
 
         unsigned char blockType = block[0];
+        const unsigned char *payload = reinterpret_cast<const unsigned char *>(block.data() + 1);   // don't include the type byte
+        unsigned int payloadSize = blockSize - 1;
+        unsigned int remaining = length - bufferPos;
+
+        int dpcmType = getDPCMType(blockType);
 
-        dstBuffer.copy_from(bufferPos, block + 1, blockSize - 1);      // 1 - don't include the type byte
+        if (blockType == BLOCK_UNCOMPRESSED)
+        {
+            if (payloadSize > remaining)
+                return false;
 
-        std::vector<unsigned char> decompressed;
+            memcpy(dst + bufferPos,payload,payloadSize);
+            bufferPos += payloadSize;
+        }
+        else if (blockType == BLOCK_LZSS_RLE)
+        {
+            int written = decompressLZSS(payload,payloadSize,reinterpret_cast<unsigned char *>(dst + bufferPos),remaining);
 
-        int dpcmType = -1;
+            if (written < 0)
+                return false;
 
-        switch (blockType)
+            bufferPos += written;
+        }
+        else if (dpcmType >= 0)
         {
-            case BLOCK_UNCOMPRESSED:
-                for (uint32_t j = 0; j < blockSize - 1; ++j)           // just copy the data
-                    decompressed.push_back(block[1 + j]);
-                break;
-
-            case BLOCK_LZSS_RLE:
-                decompressed = decompressLZSS((unsigned char *) (*dstBuffer + bufferPos),blockSize - 1);
-                break;
-
-            case BLOCK_DPCM0: dpcmType = 0; break;
-            case BLOCK_DPCM1: dpcmType = 1; break;
-            case BLOCK_DPCM2: dpcmType = 2; break;
-            case BLOCK_DPCM3: dpcmType = 3; break;
-            case BLOCK_DPCM4: dpcmType = 4; break;
-            case BLOCK_DPCM5: dpcmType = 5; break;
-            case BLOCK_DPCM6: dpcmType = 6; break;
-            default: break;
+            if (!mWavHeaderRead && payloadSize < sizeof(mWavHeader))
+                return false;
+
+            std::vector<unsigned char> decompressed = decompressDPCM(&WAV_DELTAS[128 * dpcmType],payload,payloadSize);
+
+            if (decompressed.size() > remaining)
+                return false;
+
+            memcpy(dst + bufferPos,decompressed.data(),decompressed.size());
+            bufferPos += (uint32_t) decompressed.size();
         }
+    }
+
+    return true;
+}
+
+int DataFormatDTA::getDPCMType(unsigned char blockType)
+{
+    switch (blockType)
+    {
+        case BLOCK_DPCM0: return 0;
+        case BLOCK_DPCM1: return 1;
+        case BLOCK_DPCM2: return 2;
+        case BLOCK_DPCM3: return 3;
+        case BLOCK_DPCM4: return 4;
+        case BLOCK_DPCM5: return 5;
+        case BLOCK_DPCM6: return 6;
+        default: return -1;
+    }
+}
+
+bool DataFormatDTA::getFile(const MFUtil::MappedFile &archive, unsigned int index, char *dst) const
+{
+    DataFormatDTADecoder decoder(*this,archive,index);
+    uint32_t length = getFileSize(index);
+    uint32_t bufferPos = 0;
 
-        if (dpcmType >= 0)
-            decompressed = decompressDPCM(&WAV_DELTAS[128 * dpcmType],(unsigned char *) (*dstBuffer + bufferPos),blockSize - 1);
+    while (!decoder.isFinished())
+    {
+        int written = decoder.decodeBlock(dst + bufferPos,length - bufferPos);
+
+        if (written < 0)
+            return false;
 
-        dstBuffer.copy_from(bufferPos,decompressed.data(),decompressed.size());
-        bufferPos += (uint32_t) decompressed.size();
+        bufferPos += written;
     }
 
-    return dstBuffer;
+    return true;
+}
+
+DataFormatDTADecoder::DataFormatDTADecoder(const DataFormatDTA &dta, const MFUtil::MappedFile &archive, unsigned int fileIndex):
+    mDTA(dta), mArchive(archive)
+{
+    mPosition = dta.mFileTableRecords[fileIndex].mDataOffset;
+    mBlock = 0;
+    mBlockCount = dta.mDataFileHeaders[fileIndex].mCompressedBlockCount;
+    mFileSize = dta.mDataFileHeaders[fileIndex].mSize;
+    mDecodedSize = 0;
+    mEncrypted = dta.mDataFileHeaders[fileIndex].mFlags[0] & 0x80;
+    mWavHeaderRead = false;
+}
+
+bool DataFormatDTADecoder::peekBlock(const char *&block, uint32_t &blockSize, unsigned char &blockType)
+{
+    if (mPosition + sizeof(blockSize) > mArchive.size())
+        return false;
+
+    memcpy(&blockSize,mArchive.data() + mPosition,sizeof(blockSize));
+    blockSize = blockSize & 0xffff;
+
+    if (blockSize == 0 || mPosition + sizeof(blockSize) + blockSize > mArchive.size())
+        return false;
+
+    block = mArchive.data() + mPosition + sizeof(blockSize);
+
+    char type = block[0];
+
+    if (mEncrypted)
+        mDTA.decrypt(&type,1);
+
+    blockType = type;
+    return true;
+}
+
+unsigned int DataFormatDTADecoder::getMaxBlockSize()
+{
+    const char *block;
+    uint32_t blockSize;
+    unsigned char blockType;
+
+    if (isFinished() || !peekBlock(block,blockSize,blockType))
+        return 0;
+
+    unsigned int remaining = mFileSize - mDecodedSize;
+    unsigned int payloadSize = blockSize - 1;
+
+    if (blockType == DataFormatDTA::BLOCK_UNCOMPRESSED)
+        return std::min(payloadSize,remaining);
+
+    if (DataFormatDTA::getDPCMType(blockType) >= 0)   // every sample byte becomes 2 bytes
+        return std::min(2 * payloadSize,remaining);
+
+    return remaining;
+}
+
+int DataFormatDTADecoder::decodeBlock(char *dst, unsigned int dstLen)
+{
+    if (isFinished())
+        return 0;
+
+    const char *block;
+    uint32_t blockSize;
+    unsigned char blockType;
+
+    if (!peekBlock(block,blockSize,blockType))
+        return -1;
+
+    mPosition += sizeof(blockSize) + blockSize;
+    mBlock++;
+
+    unsigned int payloadSize = blockSize - 1;   // without the type byte
+    dstLen = std::min(dstLen,mFileSize - mDecodedSize);
+    int written = -1;
+
+    if (blockType == DataFormatDTA::BLOCK_UNCOMPRESSED)        // decrypt in place in the destination
+    {
+        if (payloadSize > dstLen)
+            return -1;
+
+        memcpy(dst,block + 1,payloadSize);
+
+        if (mEncrypted)
+            mDTA.decrypt(dst,payloadSize,1);
+
+        mDecodedSize += payloadSize;
+        return payloadSize;
+    }
+
+    const unsigned char *payload = reinterpret_cast<const unsigned char *>(block + 1);
+
+    if (mEncrypted)
+    {
+        mDecrypted.assign(block + 1,block + blockSize);
+        mDTA.decrypt(mDecrypted.data(),payloadSize,1);
+        payload = reinterpret_cast<const unsigned char *>(mDecrypted.data());
+    }
+
+    int dpcmType = DataFormatDTA::getDPCMType(blockType);
+
+    if (blockType == DataFormatDTA::BLOCK_LZSS_RLE)
+        written = DataFormatDTA::decompressLZSS(payload,payloadSize,reinterpret_cast<unsigned char *>(dst),dstLen);
+    else if (dpcmType >= 0)
+        written = decodeDPCM(&WAV_DELTAS[128 * dpcmType],payload,payloadSize,reinterpret_cast<unsigned char *>(dst),dstLen);
+    else
+        written = 0;                             // unknown block type, skip it
+
+    if (written > 0)
+        mDecodedSize += written;
+
+    return written;
 }
 
-unsigned int DataFormatDTA::getFileSize(unsigned int index)
+int DataFormatDTADecoder::decodeDPCM(const uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen, unsigned char *dst, unsigned int dstLen)
+{
+    unsigned char *dstStart = dst;
+
+    if (!mWavHeaderRead)     // the WAV header is at the start of the first block, encrypted on its own
+    {
+        if (bufferLen < sizeof(mWavHeader) || dstLen < sizeof(mWavHeader))
+            return -1;
+
+        memcpy(&mWavHeader,buffer,sizeof(mWavHeader));
+        mDTA.decrypt(reinterpret_cast<char *>(&mWavHeader),sizeof(mWavHeader));
+        memcpy(dst,&mWavHeader,sizeof(mWavHeader));
+
+        buffer += sizeof(mWavHeader);
+        bufferLen -= sizeof(mWavHeader);
+        dst += sizeof(mWavHeader);
+        dstLen -= sizeof(mWavHeader);
+        mWavHeaderRead = true;
+    }
+
+    if (bufferLen == 0)
+        return (int) (dst - dstStart);
+
+    unsigned int channels = mWavHeader.mChannels == 2 ? 2 : 1;
+    unsigned int size = DataFormatDTA::getDPCMDecodedSize(bufferLen,channels);
+
+    if (bufferLen < 2 * channels || dstLen < size)
+        return -1;
+
+    DataFormatDTA::decodeDPCMSamples(delta,buffer,bufferLen,channels,dst);
+    return (int) (dst + size - dstStart);
+}
+
+bool DataFormatDTADecoder::getWavHeader(DataFormatDTA::WavHeader &header) const
+{
+    if (!mWavHeaderRead)
+        return false;
+
+    header = mWavHeader;
+    return true;
+}
+
+const char *DataFormatDTA::getFileView(const MFUtil::MappedFile &archive, unsigned int index) const
+{
+    if (mDataFileHeaders[index].mCompressedBlockCount != 1 || (mDataFileHeaders[index].mFlags[0] & 0x80))
+        return nullptr;
+
+    size_t position = mFileTableRecords[index].mDataOffset;
+    uint32_t blockSize;
+
+    if (position + sizeof(blockSize) > archive.size())
+        return nullptr;
+
+    memcpy(&blockSize,archive.data() + position,sizeof(blockSize));
+    blockSize = blockSize & 0xffff;
+    position += sizeof(blockSize);
+
+    if (blockSize != getFileSize(index) + 1 || position + blockSize > archive.size())
+        return nullptr;
+
+    const char *block = archive.data() + position;
+    return block[0] == BLOCK_UNCOMPRESSED ? block + 1 : nullptr;
+}
+
+unsigned int DataFormatDTA::getFileSize(unsigned int index) const
 {
     return mDataFileHeaders[index].mSize;
 }
@@ -234,37 +501,66 @@ void DataFormatDTA::setDecryptKeys(uint32_t keys[2])
     mKey2 = keys[1];
 }
 
-unsigned int DataFormatDTA::getNumFiles()
+unsigned int DataFormatDTA::getNumFiles() const
 {
     return mFileHeader.mFileCount;
 }
 
-std::string DataFormatDTA::getFileName(unsigned int index)
+std::string DataFormatDTA::getFileName(unsigned int index) const
 {
-    return std::string(reinterpret_cast<char *>(mDataFileHeaders[index].mName));
+    return std::string(reinterpret_cast<const char *>(mDataFileHeaders[index].mName));
 }
 
-void DataFormatDTA::decrypt(char *buffer, unsigned int bufferLen, unsigned int relativeShift)
+void DataFormatDTA::decrypt(char *buffer, unsigned int bufferLen, unsigned int relativeShift) const
 {
-    uint32_t key1 = mKey1;
-    uint32_t key2 = mKey2;
+    uint32_t keys[2] = {mKey1 ^ 0x39475694, mKey2 ^ 0x34985762};   // has to be done for some reason
+    unsigned char *keyBytes = reinterpret_cast<unsigned char *>(keys);
+
+    // ~((~data) ^ key) == data ^ key, so just XOR with the key rotated by the shift, 8 bytes repeat
+
+    unsigned char rotatedKey[8];
+
+    for (unsigned int i = 0; i < 8; ++i)
+        rotatedKey[i] = keyBytes[(i + relativeShift) % 8];
 
-    key1 ^= 0x39475694;    // has to be done for some reason
-    key2 ^= 0x34985762;
+    uint64_t key64;
+    memcpy(&key64,rotatedKey,8);
 
-    uint32_t keys[2] = {key1, key2};
-    char *keyBytes = reinterpret_cast<char *>(keys);
+    unsigned int i = 0;
 
-    for (unsigned int i = 0; i < bufferLen; ++i)
+#if defined(__AVX2__)
+    __m256i key256 = _mm256_set1_epi64x(key64);
+
+    for (; i + 32 <= bufferLen; i += 32)
+    {
+        __m256i *p = reinterpret_cast<__m256i *>(buffer + i);
+        _mm256_storeu_si256(p,_mm256_xor_si256(_mm256_loadu_si256(p),key256));
+    }
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i key128 = _mm_set1_epi64x(key64);
+
+    for (; i + 16 <= bufferLen; i += 16)
     {
-        char dataByte = buffer[i];
-        char keyByte = keyBytes[(i + relativeShift) % sizeof(keys)];
+        __m128i *p = reinterpret_cast<__m128i *>(buffer + i);
+        _mm_storeu_si128(p,_mm_xor_si128(_mm_loadu_si128(p),key128));
+    }
+#endif
 
-        buffer[i] = (char) ( ~((~dataByte) ^ keyByte) );
+    for (; i + 8 <= bufferLen; i += 8)
+    {
+        uint64_t data;
+        memcpy(&data,buffer + i,8);
+        data ^= key64;
+        memcpy(buffer + i,&data,8);
     }
+
+    for (; i < bufferLen; ++i)
+        buffer[i] ^= rotatedKey[i % 8];
 }
 
-std::vector<unsigned char> DataFormatDTA::decompressDPCM(uint16_t *delta, unsigned char *buffer, unsigned int bufferLen)
+std::vector<unsigned char> DataFormatDTA::decompressDPCM(uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen)
 {
     unsigned int position = 0;
     std::vector<unsigned char> decompressed;
@@ -278,33 +574,152 @@ std::vector<unsigned char> DataFormatDTA::decompressDPCM(uint16_t *delta, unsign
         mWavHeaderRead = true;
     }
 
-    if (mWavHeader.mChannels == 1)
+    unsigned int channels = mWavHeader.mChannels == 2 ? 2 : 1;
+
+    if (bufferLen >= position + 2 * channels)
     {
-        decompressed.push_back(buffer[position]);
-        decompressed.push_back(buffer[position + 1]);
+        size_t headerSize = decompressed.size();
+        decompressed.resize(headerSize + getDPCMDecodedSize(bufferLen - position,channels));
+        decodeDPCMSamples(delta,buffer + position,bufferLen - position,channels,decompressed.data() + headerSize);
+    }
 
-        uint16_t value = *((uint16_t *) &(buffer[position]));
+    return decompressed;
+}
 
-        position += 2;
+unsigned int DataFormatDTA::getDPCMDecodedSize(unsigned int bufferLen, unsigned int channels)
+{
+    return 2 * bufferLen - 2 * channels;
+}
 
-        while (position < bufferLen)
-        {
-            int sign = (buffer[position] & 0x80) == 0 ? 1.0 : -1.0;
-            value += sign * delta[buffer[position] & 0x7f];
-            decompressed.push_back(value & 0xff);
-            decompressed.push_back(value >> 8);
-            position += 1;
-        }
+void DataFormatDTA::decodeDPCMSamples(const uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen, unsigned int channels, unsigned char *dst)
+{
+    // Each block starts with the initial 16bit sample of each channel, followed by one byte per
+    // sample (sign bit + index to the delta table). Stereo samples alternate between the channels.
+
+    uint16_t values[2];
+    unsigned int headerSize = 2 * channels;
+
+    for (unsigned int c = 0; c < channels; ++c)
+        values[c] = buffer[2 * c] | (buffer[2 * c + 1] << 8);
+
+    memcpy(dst,buffer,headerSize);
+    dst += headerSize;
+
+    unsigned int c = 0;
+
+    for (unsigned int i = headerSize; i < bufferLen; ++i)
+    {
+        unsigned char sample = buffer[i];
+
+        if (sample & 0x80)
+            values[c] -= delta[sample & 0x7f];
+        else
+            values[c] += delta[sample & 0x7f];
+
+        dst[0] = values[c] & 0xff;
+        dst[1] = values[c] >> 8;
+        dst += 2;
+
+        c = (c + 1) % channels;
     }
-    else
+}
+
+int DataFormatDTA::decompressLZSS(const unsigned char *buffer, unsigned int bufferLen, unsigned char *dst, unsigned int dstLen)
+{
+    // same format as decompressLZSS(buffer, bufferLen) below, but writes to a preallocated buffer
+
+    const unsigned char *in = buffer;
+    const unsigned char *inEnd = buffer + bufferLen;
+    unsigned char *out = dst;
+    unsigned char *outEnd = dst + dstLen;
+
+    while (in < inEnd)
     {
-        // TODO: find a stereo WAV and implement this or prove there are no stereo WAVs
+        if (inEnd - in < 2)
+            return -1;
+
+        uint16_t value = (in[0] << 8) | in[1];
+        in += 2;
+
+        if (value == 0)   // copy the next (at most) 16 bytes
+        {
+            size_t n = std::min(inEnd - in,(ptrdiff_t) 16);
+
+            if ((size_t) (outEnd - out) < n)
+                return -1;
+
+            memcpy(out,in,n);
+            in += n;
+            out += n;
+            continue;
+        }
+
+        for (unsigned int i = 0; i < 16 && in < inEnd; ++i, value <<= 1)
+        {
+            if (!(value & 0x8000))
+            {
+                if (out == outEnd)
+                    return -1;
+
+                *out++ = *in++;
+                continue;
+            }
+
+            if (inEnd - in < 2)
+                return -1;
+
+            uint32_t offset = (in[0] << 4) | (in[1] >> 4);
+            uint32_t n = in[1] & 0x0f;
+
+            if (offset == 0)   // RLE
+            {
+                if (inEnd - in < 4)
+                    return -1;
+
+                n = ((n << 8) | in[2]) + 16;
+
+                if ((size_t) (outEnd - out) < n)
+                    return -1;
+
+                memset(out,in[3],n);
+                out += n;
+                in += 4;
+                continue;
+            }
+
+            n += 3;
+            in += 2;
+
+            if (offset > (uint32_t) (out - dst) || (size_t) (outEnd - out) < n)
+                return -1;
+
+            const unsigned char *src = out - offset;
+
+            if (offset == 1)
+            {
+                memset(out,*src,n);
+            }
+            else if (offset >= 8 && outEnd - out >= 24)
+            {
+                // n <= 18, so copy 3 words at once, the bytes written after the sequence get overwritten later
+                memcpy(out,src,8);
+                memcpy(out + 8,src + 8,8);
+                memcpy(out + 16,src + 16,8);
+            }
+            else
+            {
+                for (unsigned int j = 0; j < n; ++j)    // overlapping sequence, has to go byte by byte
+                    out[j] = src[j];
+            }
+
+            out += n;
+        }
     }
 
-    return decompressed;
+    return (int) (out - dst);
 }
 
-std::vector<unsigned char> DataFormatDTA::decompressLZSS(unsigned char *buffer, unsigned int bufferLen)
+std::vector<unsigned char> DataFormatDTA::decompressLZSS(const unsigned char *buffer, unsigned int bufferLen)
 {
     // rewritten version of hdmaster's source
 
@@ -4,6 +4,7 @@
 #include <base_parser.hpp>
 #include <utils/openmf.hpp>
 #include <string.h>
+#include <unordered_map>
 #include <vector>
 
 namespace MFFormat
@@ -15,15 +16,45 @@ public:
     virtual bool load(std::ifstream &srcFile) override; ///< Loads the file table from the DTA file.
     void setDecryptKeys(uint32_t key1, uint32_t key2);  ///< Decrypting keys have to be set before load(...) is called.
     void setDecryptKeys(uint32_t keys[2]);
-    unsigned int getNumFiles();                         ///< Get the number of files inside the DTA.
-    unsigned int getFileSize(unsigned int index);
-    std::string getFileName(unsigned int index);
-    MFUtil::ScopedBuffer getFile(std::ifstream &srcFile, unsigned int index);   ///< Get the concrete file from within the DST file into a buffer.
-    int getFileIndex(std::string fileName);
+    unsigned int getNumFiles() const;                         ///< Get the number of files inside the DTA.
+    unsigned int getFileSize(unsigned int index) const;
+    std::string getFileName(unsigned int index) const;
+    uint64_t getFileTimeStamp(unsigned int index) const  { return mDataFileHeaders[index].mTimeStamp; }
 
-    void decrypt(char *buffer, unsigned int bufferLen, unsigned int relativeShift=0);
-    std::vector<unsigned char> decompressLZSS(unsigned char *buffer, unsigned int bufferLen);
-    std::vector<unsigned char> decompressDPCM(uint16_t *delta, unsigned char *buffer, unsigned int bufferLen);
+    /**
+      Stream backend: decodes given file into dst, which has to be getFileSize(index) bytes long.
+      Returns false if the archive data are corrupt.
+    */
+    bool getFile(std::ifstream &srcFile, unsigned int index, char *dst);
+
+    /**
+      Memory mapped backend: decrypts and decompresses given file straight into dst, which has to be
+      getFileSize(index) bytes long. Returns false if the archive data are corrupt. Unlike the stream
+      version it keeps no state in the object, so any number of threads can read files at once.
+    */
+    bool getFile(const MFUtil::MappedFile &archive, unsigned int index, char *dst) const;
+
+    /**
+      If given file is stored as a single unencrypted uncompressed block, returns a pointer to its
+      data inside the mapping (no copy is made), otherwise nullptr.
+    */
+    const char *getFileView(const MFUtil::MappedFile &archive, unsigned int index) const;
+
+    int getFileIndex(const std::string &fileName) const;      ///< Case-insensitive, both '\\' and '/' work as separators, -1 if not found.
+    std::vector<int> getFileIndices(const std::vector<std::string> &fileNames) const;   ///< Bulk version of getFileIndex(...).
+
+    static std::string canonicalizeName(const std::string &fileName, uint16_t *checksum=0);
+
+    void decrypt(char *buffer, unsigned int bufferLen, unsigned int relativeShift=0) const;
+    std::vector<unsigned char> decompressLZSS(const unsigned char *buffer, unsigned int bufferLen);
+
+    /**
+      Decompresses an LZSS/RLE block into dst, which has dstLen bytes. Returns the number of bytes
+      written or -1 if the block is corrupt (truncated, referring before the block start or not
+      fitting into dst).
+    */
+    static int decompressLZSS(const unsigned char *buffer, unsigned int bufferLen, unsigned char *dst, unsigned int dstLen);
+    std::vector<unsigned char> decompressDPCM(uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen);
 
     typedef struct
     {
@@ -35,7 +66,7 @@ public:
 
     typedef struct
     {
-        uint16_t mFileNameChecksum;        // checksum of upper file name
+        uint16_t mFileNameChecksum;        // checksum of upper file name (sum of its characters)
         uint16_t mFileNameLength;
         uint32_t mHeaderOffset;            // where DataFileHeader starts
         uint32_t mDataOffset;              // where the data start
@@ -86,19 +117,70 @@ public:
         uint32_t mChunkSize3;
     } WavHeader;
 
-    inline std::vector<FileTableRecord> getFileTableRecords() { return mFileTableRecords; };
-    inline std::vector<DataFileHeader>  getDataFileHeaders()  { return mDataFileHeaders;  };
+    inline const std::vector<FileTableRecord> &getFileTableRecords() const { return mFileTableRecords; };
+    inline const std::vector<DataFileHeader>  &getDataFileHeaders() const  { return mDataFileHeaders;  };
 
 protected:
+    friend class DataFormatDTADecoder;
+
+    static int getDPCMType(unsigned char blockType);      ///< -1 if not a DPCM block
+    static unsigned int getDPCMDecodedSize(unsigned int bufferLen, unsigned int channels);
+    static void decodeDPCMSamples(const uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen, unsigned int channels, unsigned char *dst);
+
     FileHeader mFileHeader;
     std::vector<FileTableRecord> mFileTableRecords;
     std::vector<DataFileHeader> mDataFileHeaders;
     uint32_t mKey1;
     uint32_t mKey2;
+
+    std::unordered_map<std::string,unsigned int> mFileNameIndex;  ///< canonical name => file index, built by load(...)
+    std::vector<bool> mChecksumFilter;                            ///< checksums present in the file table, to quickly reject missing names
+    bool mChecksumsValid = false;                                 ///< whether the archive's checksums match ours, only then the filter is used
+
     bool mWavHeaderRead;
     WavHeader mWavHeader;
 };
 
+/**
+  Decodes a file from a memory mapped DTA archive one block at a time into caller's buffers, so that
+  e.g. a sound can be played while it's still being decoded. All the decoding state lives in the
+  decoder, so any number of decoders can work on the same archive concurrently, each in its own
+  thread (the DataFormatDTA object is only read from).
+*/
+
+class DataFormatDTADecoder
+{
+public:
+    DataFormatDTADecoder(const DataFormatDTA &dta, const MFUtil::MappedFile &archive, unsigned int fileIndex);
+
+    /**
+      Decodes the next block into dst of dstLen bytes. Returns the number of bytes written, 0 if there
+      are no more blocks and -1 if the data are corrupt or don't fit.
+    */
+    int decodeBlock(char *dst, unsigned int dstLen);
+
+    unsigned int getMaxBlockSize();       ///< Upper bound of what the next decodeBlock(...) writes.
+    bool isFinished() const               { return mBlock >= mBlockCount; }
+    unsigned int getDecodedSize() const   { return mDecodedSize;          }
+    bool getWavHeader(DataFormatDTA::WavHeader &header) const;    ///< Available after the first DPCM block is decoded.
+
+protected:
+    bool peekBlock(const char *&block, uint32_t &blockSize, unsigned char &blockType);
+    int decodeDPCM(const uint16_t *delta, const unsigned char *buffer, unsigned int bufferLen, unsigned char *dst, unsigned int dstLen);
+
+    const DataFormatDTA &mDTA;
+    const MFUtil::MappedFile &mArchive;
+    size_t mPosition;                     ///< of the next block in the archive
+    uint32_t mBlock;
+    uint32_t mBlockCount;
+    uint32_t mFileSize;
+    uint32_t mDecodedSize;
+    bool mEncrypted;
+    std::vector<char> mDecrypted;         ///< encrypted compressed blocks have to be decrypted before decompressing
+    bool mWavHeaderRead;
+    DataFormatDTA::WavHeader mWavHeader;
+};
+
 }
 
 #endif
@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatEffectsBIN::load(std::ifstream &srcFile)
+bool DataFormatEffectsBIN::load(BinaryReader &srcFile)
 {
     Header header = {};
     read(srcFile, &header);
@@ -27,9 +27,10 @@ public:
     } Effect;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline size_t getNumEffects()             { return mEffects.size(); }
-    inline std::vector<Effect> getEffects()   { return mEffects; }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline size_t getNumEffects() const                   { return mEffects.size(); }
+    inline const std::vector<Effect> &getEffects() const  { return mEffects; }
 
 private:
     std::vector<Effect> mEffects;
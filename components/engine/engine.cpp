@@ -3,6 +3,7 @@
 #include <thread>
 #include <utils/logger.hpp>
 #include <renderer/osg_renderer.hpp>
+#include <4ds/osg_texture_jobs.hpp>
 #include <utils/math.hpp>
 
 #ifdef _WIN32
@@ -41,11 +42,31 @@ Engine::Engine(EngineSettings settings)
     mEngineSettings = settings;
     mIsRunning = false;
 
+    if (mEngineSettings.mMountArchives)
+    {
+        unsigned int archives = MFFile::FileSystem::getInstance()->mountArchives();
+        MFLogger::Logger::info("Mounted " + std::to_string(archives) + " DTA archives.",ENGINE_MODULE_STR);
+
+        if (mEngineSettings.mDiskCache)
+            MFFile::FileSystem::getInstance()->enableDiskCache();
+    }
+
     mRenderer = new MFRender::OSGRenderer();
     mPhysicsWorld = new MFPhysics::BulletPhysicsWorld();
     mInputManager = new MFInput::InputManagerImpl();
     mEntityManager = new EntityManager(this);
     mEntityFactory = new EntityFactory(mRenderer,mPhysicsWorld,mEntityManager);
+    mAnimationPlayer = new MFFormat::OSGAnimationPlayer();
+    mMorphPlayer = new MFFormat::OSGMorphPlayer();
+    mSkinPlayer = new MFFormat::OSGSkinPlayer();
+    mSkinPlayer->setNumThreads(mEngineSettings.mSkinningThreads);
+    MFFormat::OSGTextureJobs::getInstance()->setNumThreads(mEngineSettings.mTextureThreads);
+
+    if (mEngineSettings.mBakeModels)
+        mEntityFactory->enableModelBaking();
+
+    if (mEngineSettings.mBakeTextures)
+        MFFormat::OSGTextureJobs::getInstance()->enableBaking();
     
     mInputManager->initWindow(
         mEngineSettings.mInitWindowWidth,
@@ -146,6 +167,9 @@ Engine::~Engine()
     delete mEntityManager;
     delete mEntityFactory;
     delete mPhysicsWorld;
+    delete mAnimationPlayer;
+    delete mMorphPlayer;
+    delete mSkinPlayer;
 }
 
 void Engine::update(double dt)
@@ -193,6 +217,9 @@ void Engine::update(double dt)
     if (render) {
         mRenderTime = mEngineSettings.mUpdatePeriod; // Use actual delta time
         frame(mRenderTime);
+        mAnimationPlayer->update(mRenderTime);
+        mMorphPlayer->update(mRenderTime);
+        mSkinPlayer->update();                  // after the bones and morphs have moved
         mRenderer->frame(mRenderTime);
     }
     else if(!mEngineSettings.mVsync) {
@@ -7,6 +7,9 @@
 #include <entity/factory.hpp>
 #include <renderer/base_renderer.hpp>
 #include <mission/mission_manager.hpp>
+#include <5ds/osg_5ds.hpp>
+#include <4ds/osg_morph.hpp>
+#include <4ds/osg_skin.hpp>
 #include <string>
 
 namespace MFGame
@@ -34,7 +37,13 @@ public:
             mLoadScene2Bin      = true;
             mLoadCacheBin       = true;
             mLoadTreeKlz        = true;
+            mMountArchives      = true;
+            mDiskCache          = false;
+            mBakeModels         = false;
+            mBakeTextures       = false;
             mVsync              = false;
+            mSkinningThreads    = 1;
+            mTextureThreads     = 4;
 
             mUpdatePeriod       = 1.0 / 60.0;
             mSleepPeriod        = 1.0;
@@ -51,7 +60,13 @@ public:
         bool         mLoadScene2Bin;
         bool         mLoadCacheBin;
         bool         mLoadTreeKlz;
+        bool         mMountArchives;   ///< Whether to serve game data directly from the DTA archives.
+        bool         mDiskCache;       ///< Whether to keep files decoded from the archives in a cache on disk.
+        bool         mBakeModels;      ///< Whether to keep converted models on disk for faster loading.
+        bool         mBakeTextures;    ///< Whether to keep compressed textures with mipmaps on disk for faster loading and less video memory.
         bool         mVsync;
+        unsigned int mSkinningThreads; ///< Number of threads the visible characters are skinned by.
+        unsigned int mTextureThreads;  ///< Number of threads decoding the textures of loaded models, 0 = the loading thread.
 
         double       mUpdatePeriod;
         double       mSleepPeriod;
@@ -74,6 +89,9 @@ public:
     MFGame::EntityManager *getEntityManager() const { return mEntityManager; };
     MFInput::InputManager *getInputManager() const { return mInputManager;         };
     MFGame::MissionManager *getMissionManager() const { return mMissionManager; };
+    MFFormat::OSGAnimationPlayer *getAnimationPlayer() const { return mAnimationPlayer; };
+    MFFormat::OSGMorphPlayer *getMorphPlayer() const { return mMorphPlayer; };
+    MFFormat::OSGSkinPlayer *getSkinPlayer() const { return mSkinPlayer; };
     
     std::string getCameraInfoString();                     ///< Get camera position and rotation encoded in string.
     void setCameraFromString(const std::string& cameraString) const;    ///< For debconst ug - set cu&rrent camera from string returned by getCameraInfoString().
@@ -97,6 +115,9 @@ protected:
     MFRender::OSGRenderer               *mRenderer;
     MFPhysics::BulletPhysicsWorld       *mPhysicsWorld;
     MFGame::MissionManager              *mMissionManager;
+    MFFormat::OSGAnimationPlayer        *mAnimationPlayer;
+    MFFormat::OSGMorphPlayer            *mMorphPlayer;
+    MFFormat::OSGSkinPlayer             *mSkinPlayer;
     bool mIsRunning;
 
     EngineSettings mEngineSettings;
@@ -1,6 +1,7 @@
 #include <entity/factory.hpp>
 #include <4ds/osg_4ds.hpp>
 #include <4ds/parser_4ds.hpp>
+#include <filesystem>
 
 #define ENTITY_FACTORY_MODULE_STR "spatial entity factory"
 
@@ -55,8 +56,9 @@ MFGame::Entity::Id EntityFactory::createTestShapeEntity(btCollisionShape *colSha
     return createEntity(visualTransform.get(),physicalBody,motionState,"test");
 }
 
-MFGame::Entity::Id EntityFactory::createPropEntity(MFFormat::DataFormatScene2BIN::Object * object)
+MFGame::Entity::Id EntityFactory::createPropEntity(const MFFormat::DataFormatScene2BIN &scene, const MFFormat::DataFormatScene2BIN::Object * object)
 {
+    std::string modelName = scene.getString(object->mModelName);
     btScalar mass = object->mSpecialProps.mWeight;
     btTransform transform;
     transform.setIdentity();
@@ -64,7 +66,7 @@ MFGame::Entity::Id EntityFactory::createPropEntity(MFFormat::DataFormatScene2BIN
 
     btVector3 inertia = btVector3(0,0,0);
 
-    auto btMesh = loadFaceCols(object->mModelName);
+    auto btMesh = loadFaceCols(modelName);
 
     auto shape = new btConvexTriangleMeshShape(btMesh, true);
     shape->setMargin(0.05f);
@@ -75,17 +77,17 @@ MFGame::Entity::Id EntityFactory::createPropEntity(MFFormat::DataFormatScene2BIN
     osg::ref_ptr<osg::MatrixTransform> visualTransform = new osg::MatrixTransform();
 
     auto cache = mRenderer->getLoaderCache();
-    auto node = (osg::Node *)cache->getObject(object->mModelName).get();
+    auto node = (osg::Node *)cache->getObject(modelName).get();
 
     if (!node) {
-        node = loadModel(object->mModelName);
+        node = loadModel(modelName);
     }
 
     visualTransform->addChild(node);
 
     mRenderer->getRootNode()->addChild(visualTransform);
 
-    return createEntity(visualTransform.get(), body, motionState, object->mName, Entity::RIGID);
+    return createEntity(visualTransform.get(), body, motionState, scene.getString(object->mName), Entity::RIGID);
 }
 
 MFGame::Entity::Id EntityFactory::createPropEntity(std::string modelName, btScalar mass)
@@ -122,18 +124,108 @@ MFGame::Entity::Id EntityFactory::createPropEntity(std::string modelName, btScal
 
 osg::ref_ptr<osg::Node> ObjectFactory::loadModel(std::string modelName)
 {
-    osg::ref_ptr<osg::Node> node = nullptr;
     auto cache = mRenderer->getLoaderCache();
+    osg::ref_ptr<osg::Node> node = (osg::Node *) cache->getObject(modelName).get();
+
+    if (node)
+        return node;
+
     MFFormat::OSGModelLoader l4ds;
     l4ds.setLoaderCache(cache);
-    auto model = loadModelData(modelName);
 
-    node = l4ds.load(model, modelName);
+    MFFormat::DataFormatBaked4DS baked;
+    loadBakedModel(modelName, baked);    // an empty model on failure, same as with a missing file
+
+    node = l4ds.load(&baked, modelName);
     node->setName(modelName);
 
     return node;
 }
 
+bool ObjectFactory::enableModelBaking(std::string directory)
+{
+    if (directory.length() == 0)
+        directory = mFileSystem->getUserDir().length() > 0 ? mFileSystem->getUserDir() + "/baked" : "baked";
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    if (!std::filesystem::is_directory(directory, error)) {
+        MFLogger::Logger::warn("Could not create directory for baked models: " + directory + ".", ENTITY_FACTORY_MODULE_STR);
+        return false;
+    }
+
+    mFileSystem->excludeFromIndex(directory);
+    mBakeDirectory = directory;
+    return true;
+}
+
+bool ObjectFactory::loadBakedModel(std::string modelName, MFFormat::DataFormatBaked4DS &baked)
+{
+    const std::string fileName = "models/" + modelName;
+    const uint64_t timeStamp = mFileSystem->getTimeStamp(fileName);
+    std::string bakedFileName;
+
+    if (mBakeDirectory.length() > 0) {
+        // all bakes in one directory, the escaping keeps distinct paths apart ("a/b_c" vs. "a_b/c") and inside it
+        std::string flatName;
+
+        for (char c : MFFile::convertPathToCanonical(modelName)) {
+            if (c == '%')
+                flatName += "%25";
+            else if (c == '/')
+                flatName += "%2f";
+            else
+                flatName += c;
+        }
+
+        bakedFileName = mBakeDirectory + "/" + flatName + ".baked";
+
+        // the common case: the source hasn't been touched since baking, don't even read it
+        if (baked.open(bakedFileName) && baked.isBakedFrom(timeStamp, nullptr, 0))
+            return true;
+    }
+
+    std::vector<char> storage;
+    const char *data;
+    size_t size;
+
+    if (!mFileSystem->read(fileName, data, size, storage)) {
+        MFLogger::Logger::warn("Could not open 4ds file: " + modelName + ".", ENTITY_FACTORY_MODULE_STR);
+        baked.clear();
+        return false;
+    }
+
+    if (bakedFileName.length() > 0 && baked.isBakedFrom(timeStamp, data, size)) {
+        // only the time stamp changed (e.g. the file was copied), keep it so that the source isn't read next time
+        baked.setSourceTimeStamp(timeStamp);
+
+        if (!baked.save(bakedFileName))
+            MFLogger::Logger::warn("Could not save baked model: " + bakedFileName + ".", ENTITY_FACTORY_MODULE_STR);
+
+        return true;
+    }
+
+    MFFormat::DataFormat4DS model;
+    bool parsed = model.load(data, size);
+
+    if (!parsed)
+        MFLogger::Logger::warn("Could not parse 4ds file " + modelName + ": " + model.getErrorStr() + ".", ENTITY_FACTORY_MODULE_STR);
+
+    MFFormat::DataFormatBaked4DS::Source source;
+    source.mTimeStamp = timeStamp;
+    source.mSize = size;
+    source.mHash = MFFormat::DataFormatBaked4DS::hash(data, size);
+
+    if (!baked.bake(model.getModel(), source))
+        return false;
+
+    if (parsed && bakedFileName.length() > 0 && !baked.save(bakedFileName))
+        MFLogger::Logger::warn("Could not save baked model: " + bakedFileName + ".", ENTITY_FACTORY_MODULE_STR);
+
+    return true;
+}
+
 MFFormat::DataFormat4DS * ObjectFactory::loadModelData(std::string modelName)
 {
     MFFormat::DataFormat4DS *model = nullptr;
@@ -142,13 +234,15 @@ MFFormat::DataFormat4DS * ObjectFactory::loadModelData(std::string modelName)
 
     if (!model) {
         model = new MFFormat::DataFormat4DS();
-        std::ifstream file4DS;
-        if (!mFileSystem->open(file4DS, "models/" + modelName)) {
+        std::vector<char> storage;
+        const char *data;
+        size_t size;
+
+        if (!mFileSystem->read("models/" + modelName, data, size, storage)) {
             MFLogger::Logger::warn("Couldn't not open 4ds file: " + modelName + ".", ENTITY_FACTORY_MODULE_STR);
         }
         else {
-            model->load(file4DS);
-            file4DS.close();
+            model->load(data, size);
         }
 
         mModelCache.storeObject(modelName, model);
@@ -170,19 +264,22 @@ btTriangleMesh *ObjectFactory::loadFaceCols(std::string modelName, int meshId)
 
         btMesh = new btTriangleMesh();
 
-        auto mesh = model->getModel().mMeshes[meshId];
+        const auto &modelData = model->getModel();
+        const auto &mesh = modelData.mMeshes[meshId];
         // TODO support more types?
         if (mesh.mMeshType == MFFormat::DataFormat4DS::MESHTYPE_STANDARD && mesh.mVisualMeshType == MFFormat::DataFormat4DS::VISUALMESHTYPE_STANDARD) {
-            auto lod = mesh.mStandard.mLODs[0];
-            for (auto faceGroup : lod.mFaceGroups) {
-                for (auto face : faceGroup.mFaces) {
-                    auto i1 = face.mA;
-                    auto i2 = face.mB;
-                    auto i3 = face.mC;
-
-                    auto p1 = lod.mVertices[i1].mPos;
-                    auto p2 = lod.mVertices[i2].mPos;
-                    auto p3 = lod.mVertices[i3].mPos;
+            const auto &lod = modelData.mStandards[mesh.mDataIndex].mLODs[0];
+            auto vertices = modelData.getVertices(lod);
+            for (const auto &faceGroup : lod.mFaceGroups) {
+                auto faces = modelData.getFaces(faceGroup);
+                for (size_t i = 0; i < faceGroup.mFaceCount; ++i) {
+                    auto i1 = faces[i].mA;
+                    auto i2 = faces[i].mB;
+                    auto i3 = faces[i].mC;
+
+                    auto p1 = vertices[i1].mPos;
+                    auto p2 = vertices[i2].mPos;
+                    auto p3 = vertices[i3].mPos;
 
                     btVector3 v1 = MFUtil::mafiaVec3ToBullet(p1.x, p1.y, p1.z);
                     btVector3 v2 = MFUtil::mafiaVec3ToBullet(p2.x, p2.y, p2.z);
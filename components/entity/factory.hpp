@@ -7,6 +7,7 @@
 #include <renderer/osg_renderer.hpp>
 #include <entity/manager.hpp>
 #include <vfs/vfs.hpp>
+#include <4ds/parser_baked4ds.hpp>
 
 #define ENTITY_FACTORY_MODULE_STR "spatial entity factory"
 
@@ -23,6 +24,13 @@ public:
     osg::ref_ptr<osg::Node> loadModel(std::string modelName);
     MFFormat::DataFormat4DS *loadModelData(std::string modelName);
     btTriangleMesh *loadFaceCols(std::string modelName, int meshId=0);
+
+    /**
+      Makes loadModel(...) keep baked models in given directory (~/.openmf/baked on Linux and "baked"
+      elsewhere by default) and load them from there as long as the source 4ds file doesn't change.
+    */
+    bool enableModelBaking(std::string directory = "");
+    bool loadBakedModel(std::string modelName, MFFormat::DataFormatBaked4DS &baked);
     
     void setDebugMode(bool enable) { mDebugMode = enable; };
 
@@ -32,6 +40,7 @@ protected:
     MFPhysics::BulletPhysicsWorld *mPhysicsWorld;
     MFFile::FileSystem *mFileSystem;
     MFRender::OSGRenderer *mRenderer;
+    std::string mBakeDirectory;                    ///< empty = models are baked in memory only
 
     osg::ref_ptr<osg::StateSet> mTestStateSet;
     osg::ref_ptr<osg::Material> mTestMaterial;
@@ -136,7 +145,7 @@ public:
 
     MFGame::Entity::Id createCameraEntity();
     MFGame::Entity::Id createTestShapeEntity(btCollisionShape *colShape, osg::ShapeDrawable *visualNode);
-    MFGame::Entity::Id createPropEntity(MFFormat::DataFormatScene2BIN::Object *object);
+    MFGame::Entity::Id createPropEntity(const MFFormat::DataFormatScene2BIN &scene, const MFFormat::DataFormatScene2BIN::Object *object);
     MFGame::Entity::Id createPropEntity(std::string modelName, btScalar mass=20.0f);
 
 protected: 
@@ -9,10 +9,10 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
 
     #define loopBegin(getFunc)\
     {\
-        auto cols = klz->getFunc(); \
+        const auto &cols = klz->getFunc(); \
         for (int i = 0; i < (int) cols.size(); ++i)\
         {\
-            auto col = cols[i];\
+            const auto &col = cols[i];\
             MFUtil::NamedRigidBody newBody;\
 
     #define loopEnd \
@@ -81,7 +81,7 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
 
     // load face collisions:
 
-    auto cols = klz->getFaceCols();
+    const auto &cols = klz->getFaceCols();
 
     int currentLink = -1;
     MeshFaceCollision faceCol;
@@ -90,7 +90,7 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
 
     for (int i = 0; i < (int) cols.size(); ++i)
     {
-        auto col = cols[i];
+        const auto &col = cols[i];
 
         FaceIndices face;
         face.mI1 = col.mIndices[0].mIndex;
@@ -118,28 +118,12 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
 
     // make the bodies now:
     
-    auto model = scene4ds.getModel();
+    const auto &model = scene4ds.getModel();
 
     for (int i = 0; i < (int) mFaceCollisions.size(); ++i)
     {
-        MFFormat::DataFormat4DS::Mesh *m = 0;
-
-        // find the corresponding mesh
-
-        unsigned int meshIndex = 0;
-
-        for (int j = 0; j < (int) model.mMeshCount; ++j)
-        {
-            MFFormat::DataFormat4DS::Mesh *mesh = &(model.mMeshes[j]);            
-            std::string meshName = std::string(mesh->mMeshName,0,mesh->mMeshNameLength);
-
-            if (meshName.compare(mFaceCollisions[i].mMeshName) == 0)
-            {
-                m = mesh;
-                meshIndex = j;
-                break;
-            }
-        }
+        int meshIndex = model.findMesh(mFaceCollisions[i].mMeshName);
+        const MFFormat::DataFormat4DS::Mesh *m = meshIndex >= 0 ? &(model.mMeshes[meshIndex]) : 0;
 
         if (m == 0)
         {
@@ -154,27 +138,29 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
             continue;
         }
 
-        if (m->mStandard.mLODs.size() == 0)
+        const MFFormat::DataFormat4DS::Standard *standard = model.getStandard(*m);
+
+        if (!standard || standard->mLODs.size() == 0)
         {
             MFLogger::Logger::warn("Could not load face collisions for \"" + mFaceCollisions[i].mMeshName + "\" - no LODs.",TREE_KLZ_BULLET_LOADER_MODULE_STR);
             continue;
         }
 
-        auto vertices = &(m->mStandard.mLODs[0].mVertices);
+        const MFFormat::DataFormat4DS::Vertex *vertices = model.getVertices(standard->mLODs[0]);
 
         MFUtil::NamedRigidBody newBody;
         newBody.mRigidBody.mMesh = std::make_shared<btTriangleMesh>();
 
         for (int j = 0; j < (int) mFaceCollisions[i].mFaces.size(); ++j)
         {
-            auto indices = mFaceCollisions[i].mFaces[j];
-            auto v = (*vertices)[indices.mI1].mPos;
+            const auto &indices = mFaceCollisions[i].mFaces[j];
+            auto v = vertices[indices.mI1].mPos;
             btVector3 v0 = MFUtil::mafiaVec3ToBullet(v.x,v.y,v.z);
 
-            v = (*vertices)[indices.mI2].mPos;
+            v = vertices[indices.mI2].mPos;
             btVector3 v1 = MFUtil::mafiaVec3ToBullet(v.x,v.y,v.z);
 
-            v = (*vertices)[indices.mI3].mPos;
+            v = vertices[indices.mI3].mPos;
             btVector3 v2 = MFUtil::mafiaVec3ToBullet(v.x,v.y,v.z);
             newBody.mRigidBody.mMesh->addTriangle(v0,v1,v2);
         }
@@ -186,7 +172,7 @@ void BulletStaticCollisionLoader::load(MFFormat::DataFormatTreeKLZ *klz, MFForma
         btRigidBody::btRigidBodyConstructionInfo ci(0,0,newBody.mRigidBody.mShape.get());
         newBody.mRigidBody.mBody = std::make_shared<btRigidBody>(ci);
         newBody.mRigidBody.mBody->setCollisionFlags(newBody.mRigidBody.mBody->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
-        newBody.mRigidBody.mBody->setWorldTransform(MFUtil::mafiaMat4ToBullet(model.computeWorldTransform(meshIndex)));
+        newBody.mRigidBody.mBody->setWorldTransform(MFUtil::mafiaMat4ToBullet(model.getWorldTransform(meshIndex)));
         mRigidBodies.push_back(newBody);
     }
 }
@@ -24,7 +24,7 @@ DataFormatTreeKLZ::~DataFormatTreeKLZ()
     free(mCellBoundariesY); 
 }
 
-bool DataFormatTreeKLZ::load(std::ifstream &srcFile)
+bool DataFormatTreeKLZ::load(BinaryReader &srcFile)
 {
     read(srcFile, &mHeader);
     
@@ -37,7 +37,7 @@ bool DataFormatTreeKLZ::load(std::ifstream &srcFile)
         srcFile.seekg(mLinkNameOffsetTable[i], srcFile.beg);
         read(srcFile, &newLink.mFlags);
       
-        newLink.mNameLength = MFUtil::peekLength(srcFile);
+        newLink.mNameLength = srcFile.peekLength();
         newLink.mName = reinterpret_cast<char*>(malloc(newLink.mNameLength));
         read(srcFile, newLink.mName, newLink.mNameLength);
         mLinkTables.push_back(newLink);
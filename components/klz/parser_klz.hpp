@@ -146,19 +146,20 @@ public:
         uint8_t* mFlags;
     } Cell;                     // grid cell, indexes collision objects in space
 
-    virtual bool load(std::ifstream &srcFile) override;
-    std::vector<FaceCol> getFaceCols()                   { return mFaceCols; }
-    std::vector<AABBCol> getAABBCols()                   { return mAABBCols; }
-    std::vector<XTOBBCol> getXTOBBCols()                 { return mXTOBBCols; }
-    std::vector<CylinderCol> getCylinderCols()           { return mCylinderCols; }
-    std::vector<OBBCol> getOBBCols()                     { return mOBBCols; }
-    std::vector<SphereCol> getSphereCols()               { return mSphereCols; }
-    std::vector<Link> getLinks()                         { return mLinkTables; }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    const std::vector<FaceCol> &getFaceCols() const              { return mFaceCols; }
+    const std::vector<AABBCol> &getAABBCols() const              { return mAABBCols; }
+    const std::vector<XTOBBCol> &getXTOBBCols() const            { return mXTOBBCols; }
+    const std::vector<CylinderCol> &getCylinderCols() const      { return mCylinderCols; }
+    const std::vector<OBBCol> &getOBBCols() const                { return mOBBCols; }
+    const std::vector<SphereCol> &getSphereCols() const          { return mSphereCols; }
+    const std::vector<Link> &getLinks() const                    { return mLinkTables; }
     std::vector<std::string> getLinkStrings();
-    Cell *getGridCells()                                 { return mGridCellsMemory; }
-    Cell getGridCell(unsigned int x, unsigned int y)     { return mGridCellsMemory[y * mDataHeader.mGridWidth + x]; }
-    unsigned int getGridWidth()                          { return mDataHeader.mGridWidth; }
-    unsigned int getGridHeight()                         { return mDataHeader.mGridHeight; }
+    const Cell *getGridCells() const                             { return mGridCellsMemory; }
+    const Cell &getGridCell(unsigned int x, unsigned int y) const { return mGridCellsMemory[y * mDataHeader.mGridWidth + x]; }
+    unsigned int getGridWidth() const                            { return mDataHeader.mGridWidth; }
+    unsigned int getGridHeight() const                           { return mDataHeader.mGridHeight; }
 
     ~DataFormatTreeKLZ();
 
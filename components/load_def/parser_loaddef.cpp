@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatLoadDEF::load(std::ifstream &srcFile)
+bool DataFormatLoadDEF::load(BinaryReader &srcFile)
 {
     while (srcFile)
     {
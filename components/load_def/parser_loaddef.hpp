@@ -18,9 +18,10 @@ public:
     } LoadingScreen;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<LoadingScreen> getLoadingScreens()   { return mLoadingScreens; }
-    inline size_t getNumLoadingScreens()                    { return mLoadingScreens.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<LoadingScreen> &getLoadingScreens() const  { return mLoadingScreens; }
+    inline size_t getNumLoadingScreens() const                          { return mLoadingScreens.size(); }
 
 private:
     std::vector<LoadingScreen> mLoadingScreens;
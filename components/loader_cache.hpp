@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include <utils/logger.hpp>
+#include <vfs/vfs.hpp>
 
 #define LOADERCACHE_MODULE_STR "loader cache"
 
@@ -60,6 +61,12 @@ public:
         MFLogger::Logger::info("  objects: " + std::to_string(getNumObjects()),LOADERCACHE_MODULE_STR);
         MFLogger::Logger::info("  cache hits: " + std::to_string(getCacheHits()),LOADERCACHE_MODULE_STR);
         MFLogger::Logger::info("  cache array memory size: " + std::to_string(getCacheSize()),LOADERCACHE_MODULE_STR);
+
+        MFFile::FileSystem *fileSystem = MFFile::FileSystem::getInstance();
+        MFLogger::Logger::info("  file index hits: " + std::to_string(fileSystem->getIndexHits()),LOADERCACHE_MODULE_STR);
+        MFLogger::Logger::info("  file index misses: " + std::to_string(fileSystem->getIndexMisses()),LOADERCACHE_MODULE_STR);
+        MFLogger::Logger::info("  disk cache hits: " + std::to_string(fileSystem->getDiskCache()->getHits()),LOADERCACHE_MODULE_STR);
+        MFLogger::Logger::info("  disk cache misses: " + std::to_string(fileSystem->getDiskCache()->getMisses()),LOADERCACHE_MODULE_STR);
     }
 
 protected:
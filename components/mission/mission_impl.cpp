@@ -24,12 +24,6 @@ bool MissionImpl::load()
     const std::string checkBinPath = missionDir + "/check.bin";
     const std::string treeKlzPath = missionDir + "/tree.klz";
 
-    std::ifstream file4DS;
-    std::ifstream fileScene2Bin;
-    std::ifstream fileCacheBin;
-    std::ifstream fileCheckBin;
-    std::ifstream fileTreeKlz;
-
     MFFormat::OSGModelLoader l4ds;
     MFFormat::OSGStaticSceneLoader lScene2;
     MFFormat::OSGCachedCityLoader lCache;
@@ -44,9 +38,9 @@ bool MissionImpl::load()
     l4ds.setNodeMap(&mNodeMap);
     lScene2.setNodeMap(&mNodeMap);
 
-    if (mFileSystem->open(file4DS, scene4dsPath)) {   
-        file4DS.close();
+    MFFormat::OSGTextureJobs::getInstance()->beginBatch();    // decode the textures of all the models in parallel with the loading
 
+    if (mFileSystem->exists(scene4dsPath)) {
         osg::ref_ptr<osg::Node> n = l4ds.load(&mSceneModel);
         mSceneModelNode = n->asGroup();
         mRenderer->getRootNode()->addChild(n);
@@ -58,7 +52,7 @@ bool MissionImpl::load()
 
     float viewDistance = 2000;    // default value
 
-    if (mFileSystem->open(fileScene2Bin, scene2BinPath))
+    if (mFileSystem->exists(scene2BinPath))
     {
         osg::ref_ptr<osg::Node> n = lScene2.load(&mSceneData);
         mSceneNode = n->asGroup();
@@ -73,14 +67,12 @@ bool MissionImpl::load()
             lightsAreSet = true;
             viewDistance = lScene2.getViewDistance();
         }
-
-        fileScene2Bin.close();
     }
 
     if (!lightsAreSet)
         mRenderer->setUpLights(nullptr);
 
-    if (mFileSystem->open(fileCacheBin, cacheBinPath))
+    if (mFileSystem->exists(cacheBinPath))
     {
         osg::ref_ptr<osg::Node> n = lCache.load(&mCacheData);
         mCachedCityNode = n->asGroup();
@@ -89,8 +81,6 @@ bool MissionImpl::load()
             MFLogger::Logger::warn("Could not parse cache.bin file: " + cacheBinPath + ".", OSGRENDERER_MODULE_STR);
         else
             mRenderer->getRootNode()->addChild(n);
-
-        fileCacheBin.close();
     }
 
     lTreeKlz.load(&mStaticColsData, mSceneModel);
@@ -116,9 +106,20 @@ bool MissionImpl::load()
 
     createMissionEntities();
 
+    size_t textures = MFFormat::OSGTextureJobs::getInstance()->endBatch();   // before optimizing, which looks at the images
+    MFLogger::Logger::info("Decoded " + std::to_string(textures) + " textures.",OSGRENDERER_MODULE_STR);
+
     mRenderer->setViewDistance(viewDistance);
     mRenderer->optimize();
+    mEngine->getMorphPlayer()->add(mRenderer->getRootNode());   // after optimizing, which may rebuild the geometry
+    mEngine->getSkinPlayer()->add(mRenderer->getRootNode());
     mRenderer->getLoaderCache()->logStats();
+
+    MFUtil::CountStateSetsVisitor stateSetCounter;
+    mRenderer->getRootNode()->accept(stateSetCounter);
+    MFLogger::Logger::info("Unique state sets: " + std::to_string(stateSetCounter.getUniqueCount()) + " (used " +
+        std::to_string(stateSetCounter.getUseCount()) + " times).",OSGRENDERER_MODULE_STR);
+
     return true;
 }
 
@@ -142,6 +143,9 @@ bool MissionImpl::unload()
     mLoadedEntities.clear();
 
     mNodeMap.clear();
+    mEngine->getAnimationPlayer()->clear();
+    mEngine->getMorphPlayer()->clear();
+    mEngine->getSkinPlayer()->clear();
 
     return true;
 }
@@ -155,31 +159,27 @@ bool MissionImpl::importFile()
     const std::string checkBinPath = missionDir + "/check.bin";
     const std::string treeKlzPath = missionDir + "/tree.klz";
 
-    std::ifstream file4DS;
-    std::ifstream fileScene2Bin;
-    std::ifstream fileCacheBin;
-    std::ifstream fileCheckBin;
-    std::ifstream fileTreeKlz;
+    // the parsers work on memory, so the files are read as a whole (straight from DTA if needed)
+    std::vector<char> storage;
+    const char *data;
+    size_t size;
 
-    if (mFileSystem->open(file4DS, scene4dsPath)) {
-        if (!mSceneModel.load(file4DS)) return false;
-        file4DS.close();
+    if (mFileSystem->read(scene4dsPath, data, size, storage)) {
+        if (!mSceneModel.load(data, size)) return false;
     }
-    if (mFileSystem->open(fileScene2Bin, scene2BinPath))
+
+    if (mFileSystem->read(scene2BinPath, data, size, storage))
     {
-        if (!mSceneData.load(fileScene2Bin)) return false;
-        fileScene2Bin.close();
+        if (!mSceneData.load(data, size)) return false;
     }
 
-    if (mFileSystem->open(fileCacheBin, cacheBinPath))
+    if (mFileSystem->read(cacheBinPath, data, size, storage))
     {
-        if (!mCacheData.load(fileCacheBin)) return false;
-        fileCacheBin.close();
+        if (!mCacheData.load(data, size)) return false;
     }
 
-    if (mFileSystem->open(fileTreeKlz, treeKlzPath)) {
-        if (!mStaticColsData.load(fileTreeKlz)) return false;
-        fileTreeKlz.close();
+    if (mFileSystem->read(treeKlzPath, data, size, storage)) {
+        if (!mStaticColsData.load(data, size)) return false;
     }
 
     return true;
@@ -307,8 +307,7 @@ void MissionImpl::createMissionEntities()
             treeKlzBodies[i].mName);
     }
 
-    for (const auto pair : mSceneData.getObjects()) {
-        auto object = pair.second;
+    for (const auto &object : mSceneData.getObjects()) {
 
         MFGame::EntityImpl *entity = nullptr;
 
@@ -318,7 +317,7 @@ void MissionImpl::createMissionEntities()
                 switch (object.mSpecialType) {
                     case MFFormat::DataFormatScene2BIN::SPECIAL_OBJECT_TYPE_PHYSICAL:
                     {
-                        const auto entityId = mEngine->getEntityFactory()->createPropEntity(&object);
+                        const auto entityId = mEngine->getEntityFactory()->createPropEntity(mSceneData, &object);
                         entity = static_cast<MFGame::EntityImpl *>(mEngine->getEntityManager()->getEntityById(entityId));
                     }
                     break;
@@ -327,7 +326,7 @@ void MissionImpl::createMissionEntities()
                     {
                         // TODO real character support
 
-                        const auto entityId = mEngine->getEntityFactory()->createPawnEntity(object.mModelName, 1000.0f);
+                        const auto entityId = mEngine->getEntityFactory()->createPawnEntity(mSceneData.getString(object.mModelName), 1000.0f);
                         entity = static_cast<MFGame::EntityImpl *>(mEngine->getEntityManager()->getEntityById(entityId));
                     }
                     break;
@@ -335,7 +334,7 @@ void MissionImpl::createMissionEntities()
                     case MFFormat::DataFormatScene2BIN::SPECIAL_OBJECT_TYPE_PLAYER:
                     {
                         osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform();
-                        auto node = mEngine->getEntityFactory()->loadModel(object.mModelName);
+                        auto node = mEngine->getEntityFactory()->loadModel(mSceneData.getString(object.mModelName));
                         transform->addChild(node);
                         mRenderer->getRootNode()->addChild(transform);
 
@@ -347,16 +346,16 @@ void MissionImpl::createMissionEntities()
                     default: 
                     {
                         if (!object.mSpecialType)continue;
-                        MFLogger::Logger::info("Unsupported special object: " + object.mName + " with type: " + std::to_string(object.mSpecialType), MISSION_MANAGER_MODULE_STR);
+                        MFLogger::Logger::info("Unsupported special object: " + mSceneData.getString(object.mName) + " with type: " + std::to_string(object.mSpecialType), MISSION_MANAGER_MODULE_STR);
                         
-                        if (object.mModelName.length() == 0) continue;
-                        auto node = mEngine->getEntityFactory()->loadModel(object.mModelName);
+                        if (object.mModelName.mLength == 0) continue;
+                        auto node = mEngine->getEntityFactory()->loadModel(mSceneData.getString(object.mModelName));
 
                         osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform();
                         transform->addChild(node);
                         mRenderer->getRootNode()->addChild(transform);
 
-                        const auto entityId = mEngine->getEntityFactory()->createEntity(transform, nullptr, nullptr, object.mName);
+                        const auto entityId = mEngine->getEntityFactory()->createEntity(transform, nullptr, nullptr, mSceneData.getString(object.mName));
                         entity = static_cast<MFGame::EntityImpl *>(mEngine->getEntityManager()->getEntityById(entityId));
                     }
                     break;
@@ -366,12 +365,12 @@ void MissionImpl::createMissionEntities()
 
             default:
                 if (!object.mSpecialType)continue;
-                MFLogger::Logger::info("Unsupported special object: " + object.mName + " with type: " + std::to_string(object.mSpecialType), MISSION_MANAGER_MODULE_STR);
+                MFLogger::Logger::info("Unsupported special object: " + mSceneData.getString(object.mName) + " with type: " + std::to_string(object.mSpecialType), MISSION_MANAGER_MODULE_STR);
         }
 
         if (!entity) continue;
 
-        const auto it = mNodeMap.find(object.mParentName);
+        const auto it = mNodeMap.find(mSceneData.getString(object.mParentName));
 
 
         if (it != mNodeMap.end()) {
@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatMNU::load(std::ifstream &srcFile)
+bool DataFormatMNU::load(BinaryReader &srcFile)
 {
     Header header = {};
     read(srcFile, &header);
@@ -24,7 +24,7 @@ bool DataFormatMNU::load(std::ifstream &srcFile)
     return true;
 }
 
-bool DataFormatMenuDEF::load(std::ifstream &srcFile)
+bool DataFormatMenuDEF::load(BinaryReader &srcFile)
 {
     while (srcFile)
     {
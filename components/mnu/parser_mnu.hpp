@@ -35,9 +35,10 @@ public:
     } Control;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<Control> getControls()   { return mControls; }
-    inline size_t getNumControls()              { return mControls.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<Control> &getControls() const  { return mControls; }
+    inline size_t getNumControls() const                    { return mControls.size(); }
 
 private:
     std::vector<Control> mControls;
@@ -65,9 +66,10 @@ public:
     } Control;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<Control> getControls()   { return mControls; }
-    inline size_t getNumControls()              { return mControls.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<Control> &getControls() const  { return mControls; }
+    inline size_t getNumControls() const                    { return mControls.size(); }
 
 private:
     std::vector<Control> mControls;
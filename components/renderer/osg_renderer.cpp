@@ -54,12 +54,7 @@ void OSGRenderer::debugClick(unsigned int x, unsigned int y)
         const osgUtil::LineSegmentIntersector::Intersection result = intersector->getFirstIntersection();
 
         if (mSelected)
-        {
-            if (mMaterialBackup)
-                mSelected->getOrCreateStateSet()->setAttributeAndModes(mMaterialBackup);
-            else
-                mSelected->getOrCreateStateSet()->removeAttribute(osg::StateAttribute::MATERIAL);
-        }
+            mSelected->setStateSet(mStateSetBackup);
 
         if (mSelected == result.drawable)  // clicking the same node twice will deselect it
         {
@@ -68,8 +63,11 @@ void OSGRenderer::debugClick(unsigned int x, unsigned int y)
         else
         {
             mSelected = result.drawable;
-            mMaterialBackup = static_cast<osg::Material *>(mSelected->getOrCreateStateSet()->getAttribute(osg::StateAttribute::MATERIAL));
-            mSelected->getOrCreateStateSet()->setAttributeAndModes(mHighlightMaterial);
+            // the state sets are shared between models, so highlight a copy
+            mStateSetBackup = mSelected->getStateSet();
+            osg::ref_ptr<osg::StateSet> highlighted = mStateSetBackup ? new osg::StateSet(*mStateSetBackup) : new osg::StateSet;
+            highlighted->setAttributeAndModes(mHighlightMaterial);
+            mSelected->setStateSet(highlighted);
 
             MFLogger::Logger::info(MFUtil::makeInfoString(result.drawable.get()),OSGRENDERER_MODULE_STR);
 
@@ -205,7 +203,7 @@ OSGRenderer::OSGRenderer(): Renderer()
     mHighlightMaterial->setAmbient(osg::Material::FRONT_AND_BACK,osg::Vec4f(0.5,0,0,1));
     mHighlightMaterial->setDiffuse(osg::Material::FRONT_AND_BACK,osg::Vec4f(0.5,0,0,1));
     mHighlightMaterial->setEmission(osg::Material::FRONT_AND_BACK,osg::Vec4f(0.5,0,0,1));
-    mMaterialBackup = nullptr;
+    mStateSetBackup = nullptr;
     mSelected = nullptr;
 
     // TODO make this work
@@ -292,7 +290,7 @@ void OSGRenderer::optimize()
     mRootNode->accept(redundantRemover);
     mRootNode->accept(emptyRemover);
 //    mRootNode->accept(subgraphCopier);
-    mRootNode->accept(flattener);
+    mRootNode->accept(flattener);   // leaves the DYNAMIC transforms of skinned and morphed 4DS meshes alone, their vertex arrays stay in the mesh space
 //    mRootNode->accept(transformCombiner);
     mRootNode->accept(geometryOptimizer);
 //    mRootNode->accept(tesselator);
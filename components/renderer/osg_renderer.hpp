@@ -78,7 +78,7 @@ protected:
 
     osg::ref_ptr<osg::Drawable> mSelected;           ///< debug selection
     osg::ref_ptr<osg::Material> mHighlightMaterial;  ///< for highlighting debug selection
-    osg::ref_ptr<osg::Material> mMaterialBackup;
+    osg::ref_ptr<osg::StateSet> mStateSetBackup;
 
     osg::ref_ptr<osgViewer::StatsHandler> mStatsHandler;
 };
@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatRoadBIN::load(std::ifstream &srcFile)
+bool DataFormatRoadBIN::load(BinaryReader &srcFile)
 {
     uint32_t header = 0;
     read(srcFile, &header);
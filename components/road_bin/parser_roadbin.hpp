@@ -61,11 +61,12 @@ public:
     } Waypoint;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::vector<Crossroad> getCrossroads()       { return mCrossroads; }
-    inline size_t getNumCrossroads()                    { return mCrossroads.size(); }
-    inline std::vector<Waypoint> getWaypoints()         { return mWaypoints; }
-    inline size_t getNumWaypoints()                     { return mWaypoints.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::vector<Crossroad> &getCrossroads() const  { return mCrossroads; }
+    inline size_t getNumCrossroads() const                      { return mCrossroads.size(); }
+    inline const std::vector<Waypoint> &getWaypoints() const    { return mWaypoints; }
+    inline size_t getNumWaypoints() const                       { return mWaypoints.size(); }
 
 private:
     std::vector<Crossroad> mCrossroads;
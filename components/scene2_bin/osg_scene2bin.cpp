@@ -15,8 +15,20 @@ public:
 
     virtual void apply(osg::Node &n) override
     {
-        osg::StateSet *stateSet = n.getStateSet();
+        overrideWrap(n.getStateSet());
 
+        osg::Geode *geode = n.asGeode();
+
+        if (geode)      // model materials are set on the drawables
+            for (unsigned int i = 0; i < geode->getNumDrawables(); ++i)
+                overrideWrap(geode->getDrawable(i)->getStateSet());
+
+        MFUtil::traverse(this,n);
+    }
+
+protected:
+    void overrideWrap(osg::StateSet *stateSet)
+    {
         if (stateSet)
         {
             osg::StateAttribute *stateAttribute = stateSet->getTextureAttribute(0,osg::StateAttribute::TEXTURE);
@@ -27,11 +39,8 @@ public:
                 stateAttribute->asTexture()->setWrap(osg::Texture::WRAP_T,osg::Texture::MIRROR);    
             }
         }
-
-        MFUtil::traverse(this,n);
     }
 
-protected:
     osg::Texture::WrapMode mWrapMode;
 };
 
@@ -51,7 +60,7 @@ OSGStaticSceneLoader::OSGStaticSceneLoader(): OSGLoader()
     mDebugOtherLightNode->setName("debug other light node");
 }
 
-osg::ref_ptr<osg::Node> OSGStaticSceneLoader::makeLightNode(MFFormat::DataFormatScene2BIN::Object object)
+osg::ref_ptr<osg::Node> OSGStaticSceneLoader::makeLightNode(const MFFormat::DataFormatScene2BIN::Object &object)
 {
     osg::ref_ptr<osg::Group> lightGroup = new osg::Group;
     lightGroup->setName(MFFormat::DataFormatScene2BIN::lightTypeToStr(object.mLightType));
@@ -147,11 +156,11 @@ osg::ref_ptr<osg::Node> OSGStaticSceneLoader::load(MFFormat::DataFormatScene2BIN
     mCameraRelative = new MFUtil::SkyboxNode();   // for Backdrop sector (camera relative placement)
     group->addChild(mCameraRelative);
  
-    for (auto pair : format->getObjects())
+    for (const auto &object : format->getObjects())
     {
-        auto object = pair.second;
         osg::ref_ptr<osg::Node> objectNode;
-        std::string logStr = object.mName + ": ";
+        std::string objectName = format->getString(object.mName);
+        std::string logStr = objectName + ": ";
         bool hasTransform = true;
 
         switch (object.mType)
@@ -168,9 +177,10 @@ osg::ref_ptr<osg::Node> OSGStaticSceneLoader::load(MFFormat::DataFormatScene2BIN
                 // Check if object is special (is not static)
                 if (object.mSpecialType) continue;
 
-                logStr += "model: " + object.mModelName;
+                std::string modelName = format->getString(object.mModelName);
+                logStr += "model: " + modelName;
 
-                objectNode = (osg::Node *) mObjectFactory->loadModel(object.mModelName);
+                objectNode = (osg::Node *) mObjectFactory->loadModel(modelName);
 
                 break;
             }
@@ -197,10 +207,10 @@ osg::ref_ptr<osg::Node> OSGStaticSceneLoader::load(MFFormat::DataFormatScene2BIN
 
             objectTransform->addChild(objectNode);
             objectTransform->getOrCreateUserDataContainer()->addDescription("scene2.bin model"); // mark the node as a model loaded from scene2.bin
-            objectTransform->setName(object.mParentName);    // hack: store the parent name in node name
-            nodeMap->insert(nodeMap->begin(),std::make_pair(object.mName,objectTransform));
+            objectTransform->setName(format->getString(object.mParentName));    // hack: store the parent name in node name
+            nodeMap->insert(nodeMap->begin(),std::make_pair(objectName,objectTransform));
             loadedNodes.push_back(objectTransform.get());
-            loadedNames.push_back(object.mName);
+            loadedNames.push_back(objectName);
         }
     }   // for
 
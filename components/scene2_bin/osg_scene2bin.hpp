@@ -46,7 +46,7 @@ protected:
     osg::ref_ptr<osg::Node> mDebugOtherLightNode;
 
     osg::ref_ptr<MFUtil::SkyboxNode> mCameraRelative;   ///< children of this node move relatively with the camera
-    osg::ref_ptr<osg::Node> makeLightNode(MFFormat::DataFormatScene2BIN::Object object);
+    osg::ref_ptr<osg::Node> makeLightNode(const MFFormat::DataFormatScene2BIN::Object &object);
 };
 
 }
@@ -1,4 +1,5 @@
 #include <scene2_bin/parser_scene2bin.hpp>
+#include <algorithm>
 
 namespace MFFormat
 {
@@ -19,13 +20,17 @@ std::string DataFormatScene2BIN::lightTypeToStr(LightType t)
     return "unknown";
 }
 
-bool DataFormatScene2BIN::load(std::ifstream &srcFile)
+bool DataFormatScene2BIN::load(BinaryReader &srcFile)
 {
+    mObjects.clear();
+    mSpecialObjects.clear();
+    mStrings.clear();
+
     Header newHeader = {};
     read(srcFile, &newHeader);
     uint32_t position = 6;
 
-    while(position + 6 < newHeader.mSize)
+    while(srcFile.good() && position + 6 < newHeader.mSize)
     {
         srcFile.seekg(position, srcFile.beg);
         Header nextHeader = {};
@@ -34,10 +39,88 @@ bool DataFormatScene2BIN::load(std::ifstream &srcFile)
         position += nextHeader.mSize;
     }
 
+    indexObjects();
     return true;
 }
 
-void DataFormatScene2BIN::readHeader(std::ifstream &srcFile, Header* header, uint32_t offset)
+const DataFormatScene2BIN::Object *DataFormatScene2BIN::getObject(const std::string &name) const
+{
+    PoolString str;
+
+    if (!mStrings.find(name.c_str(), name.length(), str))
+        return nullptr;
+
+    int index = findObject(str);
+    return index >= 0 ? &mObjects[index] : nullptr;
+}
+
+int DataFormatScene2BIN::findObject(const PoolString &name) const
+{
+    auto it = std::lower_bound(mObjectsByName.begin(), mObjectsByName.end(), name.mOffset,
+        [this](uint32_t index, uint32_t offset) { return mObjects[index].mName.mOffset < offset; });
+
+    if (it == mObjectsByName.end() || mObjects[*it].mName.mOffset != name.mOffset)
+        return -1;
+
+    return *it;
+}
+
+void DataFormatScene2BIN::indexObjects()
+{
+    // Names are interned, so equal names have equal offsets and the objects can be sorted by them.
+    // Objects with the same name as an earlier object are dropped.
+
+    auto sortByName = [this]()
+    {
+        mObjectsByName.resize(mObjects.size());
+
+        for (size_t i = 0; i < mObjects.size(); ++i)
+            mObjectsByName[i] = i;
+
+        std::sort(mObjectsByName.begin(), mObjectsByName.end(), [this](uint32_t a, uint32_t b)
+            {
+                uint32_t offsetA = mObjects[a].mName.mOffset;
+                uint32_t offsetB = mObjects[b].mName.mOffset;
+                return offsetA < offsetB || (offsetA == offsetB && a < b);
+            });
+    };
+
+    sortByName();
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < mObjectsByName.size(); ++i)
+        if (i == 0 || mObjects[mObjectsByName[i]].mName.mOffset != mObjects[mObjectsByName[i - 1]].mName.mOffset)
+            mObjectsByName[count++] = mObjectsByName[i];
+
+    if (count < mObjects.size())
+    {
+        mObjectsByName.resize(count);
+        std::sort(mObjectsByName.begin(), mObjectsByName.end());    // keep the file order
+
+        for (size_t i = 0; i < count; ++i)
+            mObjects[i] = mObjects[mObjectsByName[i]];
+
+        mObjects.resize(count);
+        sortByName();
+    }
+
+    for (const auto &special : mSpecialObjects)
+    {
+        int index = findObject(special.mName);
+
+        if (index >= 0) {
+            Object *object = &mObjects[index];
+            object->mSpecialType = special.mSpecialType;
+
+            memcpy(&object->mSpecialProps, &special.mSpecialProps, sizeof(special.mSpecialProps));
+        }
+    }
+
+    mSpecialObjects.clear();
+}
+
+void DataFormatScene2BIN::readHeader(BinaryReader &srcFile, Header* header, uint32_t offset)
 {
     switch(header->mType)
     {
@@ -45,7 +128,7 @@ void DataFormatScene2BIN::readHeader(std::ifstream &srcFile, Header* header, uin
         case HEADER_WORLD:
         {
             uint32_t position = offset;
-            while(position + 6 < offset + header->mSize)
+            while(srcFile.good() && position + 6 < offset + header->mSize)
             {
                 Header nextHeader = {};
                 srcFile.seekg(position, srcFile.beg);
@@ -79,7 +162,7 @@ void DataFormatScene2BIN::readHeader(std::ifstream &srcFile, Header* header, uin
         {
             uint32_t position = offset;
             Object newObject = {};
-            while(position + 6 < offset + header->mSize)
+            while(srcFile.good() && position + 6 < offset + header->mSize)
             {
                 Header nextHeader = {};
                 srcFile.seekg(position, srcFile.beg);
@@ -88,25 +171,16 @@ void DataFormatScene2BIN::readHeader(std::ifstream &srcFile, Header* header, uin
                 position += nextHeader.mSize;
             }
 
-            if (header->mType == HEADER_OBJECT) {
-                mObjects.insert(make_pair(newObject.mName, newObject));
-            }
-            else {
-                auto object_it = mObjects.find(newObject.mName);
-
-                if (object_it != mObjects.end()) {
-                    auto object = &object_it->second;
-                    object->mSpecialType = newObject.mSpecialType;
-
-                    memcpy(&object->mSpecialProps, &newObject.mSpecialProps, sizeof(newObject.mSpecialProps));
-                }
-            }
+            if (header->mType == HEADER_OBJECT)
+                mObjects.push_back(newObject);
+            else
+                mSpecialObjects.push_back(newObject);
         } 
         break;
     }
 }
 
-void DataFormatScene2BIN::readObject(std::ifstream &srcFile, Header* header, Object* object, uint32_t offset)
+void DataFormatScene2BIN::readObject(BinaryReader &srcFile, Header* header, Object* object, uint32_t offset)
 {
     switch(header->mType)
     {
@@ -125,12 +199,7 @@ void DataFormatScene2BIN::readObject(std::ifstream &srcFile, Header* header, Obj
         case OBJECT_NAME:
         case OBJECT_NAME_SPECIAL:
         {
-            char *name = reinterpret_cast<char*>(malloc(header->mSize + 1));
-            read(srcFile, name, header->mSize - 1);
-            name[header->mSize] = '\0';
-
-            object->mName = std::string(name);
-            free(name);
+            object->mName = readString(srcFile, header);
         }
         break;
 
@@ -159,14 +228,7 @@ void DataFormatScene2BIN::readObject(std::ifstream &srcFile, Header* header, Obj
 
         case OBJECT_MODEL:
         {
-            char *modelName = reinterpret_cast<char*>(malloc(header->mSize + 1));
-            read(srcFile, modelName, header->mSize);
-            modelName[strlen(modelName) - 4] = '\0';
-            sprintf(modelName, "%s.4ds", modelName);
-            modelName[header->mSize] = '\0';
-
-            object->mModelName = std::string(modelName);
-            free(modelName);
+            object->mModelName = readString(srcFile, header, ".4ds");    // the name ends with .i3d
         }
         break;
 
@@ -206,7 +268,7 @@ void DataFormatScene2BIN::readObject(std::ifstream &srcFile, Header* header, Obj
         case OBJECT_LIGHT_MAIN:
         {
             uint32_t position = offset;
-            while (position + 6 < offset + header->mSize)
+            while (srcFile.good() && position + 6 < offset + header->mSize)
             {
                 Header lightHeader = {};
                 read(srcFile, &lightHeader);
@@ -229,7 +291,28 @@ void DataFormatScene2BIN::readObject(std::ifstream &srcFile, Header* header, Obj
     }
 }
 
-void DataFormatScene2BIN::readLight(std::ifstream &srcFile, Header* header, Object* object)
+DataFormatScene2BIN::PoolString DataFormatScene2BIN::readString(BinaryReader &srcFile, Header* header, const char *suffix)
+{
+    // the string takes the rest of the chunk, zero-terminated (unless it fills the chunk)
+
+    uint32_t size = header->mSize > sizeof(Header) ? header->mSize - sizeof(Header) : 0;
+    const char *data = srcFile.skip(size);
+
+    if (!data)
+        return PoolString {0, 0};
+
+    size_t length = strnlen(data, size);
+
+    if (length == 0)
+        return PoolString {0, 0};
+
+    if (suffix[0] != 0)             // the suffix replaces the extension
+        length = length >= 4 ? length - 4 : 0;
+
+    return mStrings.intern(data, length, suffix);
+}
+
+void DataFormatScene2BIN::readLight(BinaryReader &srcFile, Header* header, Object* object)
 {
     switch(header->mType)
     {
@@ -260,7 +343,11 @@ void DataFormatScene2BIN::readLight(std::ifstream &srcFile, Header* header, Obje
         
         case OBJECT_LIGHT_SECTOR:
         {
-            //read(srcFile, object->mLightSectors, header->mSize);
+            uint32_t size = header->mSize > sizeof(Header) ? header->mSize - sizeof(Header) : 0;
+            const char *data = srcFile.skip(size);
+
+            if (data)
+                object->mLightSectors = mStrings.add(data, size);
         }
         break;
         
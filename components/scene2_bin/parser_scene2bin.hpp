@@ -88,6 +88,8 @@ public:
     } Header;
     #pragma pack(pop)
 
+    typedef StringPool::String PoolString;  ///< use getString(...) to get the string
+
     typedef struct _Object
     {
         uint32_t mType;
@@ -96,9 +98,9 @@ public:
         MFMath::Quat mRot;
         MFMath::Vec3 mPos2; // precomputed final world transform position
         MFMath::Vec3 mScale;
-        std::string mName;
-        std::string mModelName;
-        std::string mParentName;
+        PoolString mName;
+        PoolString mModelName;
+        PoolString mParentName;
 
         // Light properties
         LightType mLightType;
@@ -109,7 +111,7 @@ public:
         float mLightUnk1;
         float mLightNear;
         float mLightFar;
-        char mLightSectors[5000];
+        PoolString mLightSectors;    // raw contents of the sector list chunk, kept in the string pool
 
         struct {
             // Physical object properties
@@ -124,25 +126,33 @@ public:
         } mSpecialProps;
     } Object;
 
-    virtual bool load(std::ifstream &srcFile);
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
     
-    inline size_t getNumObjects()                               { return mObjects.size(); }
-    inline Object* getObject(std::string name)                  { return &mObjects.at(name); }
-    inline std::unordered_map<std::string, Object> getObjects() { return mObjects; }
-    inline float getFov()                                       { return mFov; }
-    inline void setFov(float value)                             { mFov = value; }
-    inline float getViewDistance()                              { return mViewDistance; }
-    inline void setViewDistance(float value)                    { mViewDistance = value; }
-    inline MFMath::Vec2  getClippingPlanes()                    { return mClippingPlanes; }
-    inline void  setClippingPlanes(MFMath::Vec2 value)          { mClippingPlanes = value; }
+    inline size_t getNumObjects() const                                       { return mObjects.size(); }
+    inline const std::vector<Object> &getObjects() const                      { return mObjects; }
+    const Object *getObject(const std::string &name) const;                   ///< nullptr if there is no such object
+    inline std::string getString(const PoolString &str) const                 { return mStrings.getString(str); }
+    inline float getFov() const                                               { return mFov; }
+    inline void setFov(float value)                                           { mFov = value; }
+    inline float getViewDistance() const                                      { return mViewDistance; }
+    inline void setViewDistance(float value)                                  { mViewDistance = value; }
+    inline MFMath::Vec2  getClippingPlanes() const                            { return mClippingPlanes; }
+    inline void  setClippingPlanes(MFMath::Vec2 value)                        { mClippingPlanes = value; }
     static std::string lightTypeToStr(LightType t);
 
 private:
-    void readHeader(std::ifstream &srcFile, Header* header, uint32_t offset);
-    void readObject(std::ifstream &srcFile, Header* header, Object* object, uint32_t offset);
-    void readLight (std::ifstream &srcFile, Header* header, Object* object);
-    
-    std::unordered_map<std::string, Object> mObjects;
+    void readHeader(BinaryReader &srcFile, Header* header, uint32_t offset);
+    void readObject(BinaryReader &srcFile, Header* header, Object* object, uint32_t offset);
+    void readLight (BinaryReader &srcFile, Header* header, Object* object);
+    PoolString readString(BinaryReader &srcFile, Header* header, const char *suffix = "");
+    void indexObjects();
+    int findObject(const PoolString &name) const;
+
+    std::vector<Object> mObjects;           // in the file order, the first one of each name
+    std::vector<Object> mSpecialObjects;    // merged into mObjects after loading
+    std::vector<uint32_t> mObjectsByName;   // indices to mObjects sorted by the name offset (names are interned)
+    StringPool mStrings;
     float mFov;
     float mViewDistance;
     MFMath::Vec2  mClippingPlanes;
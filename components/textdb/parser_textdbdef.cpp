@@ -3,7 +3,7 @@
 namespace MFFormat
 {
 
-bool DataFormatTextdbDEF::load(std::ifstream &srcFile)
+bool DataFormatTextdbDEF::load(BinaryReader &srcFile)
 {
     Header header = {};
     read(srcFile, &header);
@@ -21,7 +21,7 @@ bool DataFormatTextdbDEF::load(std::ifstream &srcFile)
         srcFile.seekg(textBlock.mTextOffset);
 
         std::string text;
-        std::getline(srcFile, text, '\0' );
+        srcFile.readString(text);
 
         mTextEntries.insert(std::make_pair(textBlock.mTextId, text));
     }
@@ -24,9 +24,10 @@ public:
     } TextBlock;
     #pragma pack(pop)
 
-    virtual bool load(std::ifstream &srcFile) override;
-    inline std::map<uint32_t, std::string> getTextEntries()     { return mTextEntries;        }
-    inline size_t getNumTextEntries()                           { return mTextEntries.size(); }
+    using DataFormat::load;
+    virtual bool load(BinaryReader &srcFile) override;
+    inline const std::map<uint32_t, std::string> &getTextEntries() const  { return mTextEntries;        }
+    inline size_t getNumTextEntries() const                               { return mTextEntries.size(); }
 
 protected:
     std::vector<TextBlock> mTextBlocks;
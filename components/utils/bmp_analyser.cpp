@@ -1,9 +1,11 @@
 #include <utils/bmp_analyser.hpp>
+#include <cstdint>
+#include <cstring>
 
 namespace MFFormat
 {
 
-bool BMPInfo::load(std::ifstream &f)
+bool BMPInfo::load(std::istream &f)
 {
     char buffer[64];
     f.read(buffer,54);                      // headers after which there is a colortable
@@ -11,4 +13,26 @@ bool BMPInfo::load(std::ifstream &f)
     return true;
 }
 
+bool BMPInfo::load(const char *data, size_t size)
+{
+    if (size < 54 || data[0] != 'B' || data[1] != 'M')
+        return false;
+
+    uint32_t pixelOffset, headerSize;
+    uint16_t bitsPerPixel;
+
+    memcpy(&pixelOffset,data + 10,4);
+    memcpy(&headerSize,data + 14,4);
+    memcpy(&bitsPerPixel,data + 28,2);
+
+    size_t colorOffset = bitsPerPixel <= 8 ? 14 + (size_t) headerSize : pixelOffset;
+
+    if (colorOffset + 3 > size)
+        return false;
+
+    memcpy(&mTransparentColor,data + colorOffset,3);    // both palette entries and 24 bit pixels are BGR
+    mTransparentColor.unused = 0;
+    return true;
+}
+
 }
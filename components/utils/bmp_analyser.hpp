@@ -1,7 +1,8 @@
 #ifndef BMP_ANALYSER_H
 #define BMP_ANALYSER_H
 
-#include <fstream>
+#include <istream>
+#include <cstddef>
 
 namespace MFFormat
 {
@@ -17,7 +18,13 @@ public:
         unsigned char unused;
     } BMPColor;
 
-    bool load(std::ifstream &f);
+    bool load(std::istream &f);
+
+    /**
+      Reads the transparent color from a whole BMP file in memory: the first palette entry, or the first
+      pixel for images without a palette.
+    */
+    bool load(const char *data, size_t size);
 
     BMPColor mTransparentColor;
 };
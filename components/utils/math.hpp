@@ -77,7 +77,7 @@ namespace MFMath
         constexpr explicit          vec(const vec<U,2> & v)             : vec(static_cast<T>(v.x), static_cast<T>(v.y)) {}
         constexpr const T &         operator[] (int i) const            { return (&x)[i]; }
         T &                         operator[] (int i)                  { return (&x)[i]; }
-        std::string                 str()                               { return "[" + std::to_string(x) + ", " + std::to_string(y) + "]"; }
+        std::string                 str() const                         { return "[" + std::to_string(x) + ", " + std::to_string(y) + "]"; }
     };
     template<class T> struct vec<T,3>
     {
@@ -93,7 +93,7 @@ namespace MFMath
         T &                         operator[] (int i)                  { return (&x)[i]; }
         constexpr const vec<T,2> &  xy() const                          { return *reinterpret_cast<const vec<T,2> *>(this); }
         vec<T,2> &                  xy()                                { return *reinterpret_cast<vec<T,2> *>(this); }
-        std::string                 str()                               { return "[" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + "]"; }
+        std::string                 str() const                         { return "[" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + "]"; }
         vec<T,4>                    toQuat()                            {
                                                                             vec<T,4> q;
 
@@ -129,7 +129,7 @@ namespace MFMath
         constexpr const vec<T,3> &  xyz() const                         { return *reinterpret_cast<const vec<T,3> *>(this); }
         vec<T,2> &                  xy()                                { return *reinterpret_cast<vec<T,2> *>(this); }                
         vec<T,3> &                  xyz()                               { return *reinterpret_cast<vec<T,3> *>(this); }
-        std::string                 str()                               { return "[" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ", " + std::to_string(w) + "]"; }
+        std::string                 str() const                         { return "[" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ", " + std::to_string(w) + "]"; }
         void                        fromMafia()                         { vec<T,4> tmp = vec<T,4>(x,y,z,w); x = tmp.y; y = tmp.z; z = tmp.w; w = -1 * tmp.x; }
         vec<T,3>                    toEuler()                           {
                                                                             vec<T,3> r;
@@ -1,6 +1,16 @@
 #include <utils/openmf.hpp>
+#include <utils/os_defines.hpp>
 #include <fstream>
 
+#ifdef OMF_SYSTEM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace MFUtil
 {
 
@@ -64,6 +74,126 @@ void ScopedBuffer::copy_from(size_t offset, const void *sptr, size_t ssize)
     memcpy(mData + offset, sptr, ssize);
 }
 
+MappedFile::MappedFile() : mData(nullptr), mSize(0), mMappingHandle(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(std::string fileName)
+{
+    close();
+
+#ifdef OMF_SYSTEM_WINDOWS
+    HANDLE file = CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file,&fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+    CloseHandle(file);             // the mapping keeps the file open
+
+    if (!mapping)
+        return false;
+
+    void *data = MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mMappingHandle = mapping;
+    mData = static_cast<const char *>(data);
+    mSize = (size_t) fileSize.QuadPart;
+#else
+    int file = ::open(fileName.c_str(),O_RDONLY);
+
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+
+    if (fstat(file,&fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void *data = mmap(nullptr,fileStat.st_size,PROT_READ,MAP_PRIVATE,file,0);
+    ::close(file);                 // the mapping keeps the file open
+
+    if (data == MAP_FAILED)
+        return false;
+
+    mData = static_cast<const char *>(data);
+    mSize = (size_t) fileStat.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!mData)
+        return;
+
+#ifdef OMF_SYSTEM_WINDOWS
+    UnmapViewOfFile(mData);
+    CloseHandle(mMappingHandle);
+    mMappingHandle = nullptr;
+#else
+    munmap(const_cast<char *>(mData),mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(const char *data, size_t size)
+{
+    char *begin = const_cast<char *>(data);    // the buffer is only ever read from
+    setg(begin,begin,begin + size);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    char *base = eback();
+
+    switch (dir)
+    {
+        case std::ios_base::beg: base = eback(); break;
+        case std::ios_base::cur: base = gptr();  break;
+        case std::ios_base::end: base = egptr(); break;
+        default: break;
+    }
+
+    char *newPos = base + off;
+
+    if (newPos < eback() || newPos > egptr())
+        return pos_type(off_type(-1));
+
+    setg(eback(),newPos,egptr());
+    return pos_type(newPos - eback());
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos),std::ios_base::beg,which);
+}
+
 void dumpValue(std::string name, std::string value, int offset, bool useQuotes)
 {
     printf("%*s\"%s\": %s,\n", offset * 4, " ", name.c_str(), useQuotes ? ("\"" + value + "\"").c_str() : value.c_str());
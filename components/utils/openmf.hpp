@@ -12,6 +12,7 @@
 #include <cstddef>     // for size_t
 #include <string.h>
 #include <stdexcept>
+#include <streambuf>
 
 namespace MFUtil
 {
@@ -55,6 +56,40 @@ private:
     size_t mSize;
 };
 
+/// Read-only std::streambuf over a memory block (no copy is made), e.g. to read files served from DTA archives as streams.
+
+class MemoryStreamBuffer: public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const char *data, size_t size);
+
+protected:
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+};
+
+/// Read-only memory mapping of a whole file, the mapping is released when the object is destroyed.
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    bool open(std::string fileName);
+    void close();
+    bool isOpen() const                   { return mData != nullptr; }
+    const char *data() const              { return mData;            }
+    size_t size() const                   { return mSize;            }
+
+private:
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    const char *mData;
+    size_t mSize;
+    void *mMappingHandle;                 // only used on Windows
+};
+
 std::string strToLower(std::string str);
 std::string strToUpper(std::string str);
 std::string doubleToStr(double value, unsigned int precision=2);
@@ -98,7 +133,7 @@ std::string vecToString(const std::vector<T> &vec, std::string delim)
 }
 
 template<typename T>
-std::string arrayToString(T *array, size_t len, std::string delim)
+std::string arrayToString(const T *array, size_t len, std::string delim)
 {
     std::stringstream sstream;
 
@@ -1,5 +1,8 @@
 #include <utils/osg.hpp>
 #include <osg/Material>
+#include <osg/Geode>
+#include <osgDB/Registry>
+#include <osgDB/FileNameUtils>
 
 namespace MFUtil
 {
@@ -104,42 +107,101 @@ bool SkyboxNode::computeWorldToLocalMatrix(osg :: Matrix & matrix, osg :: NodeVi
     return true; 
 } 
 
-osg::ref_ptr<osg::Image> addAlphaFromImage(osg::Image *img, osg::Image *alphaImg)
+osg::ref_ptr<osg::Image> readImage(std::string fileName, const char *data, size_t size)
+{
+    osg::ref_ptr<osg::Image> result;
+
+    osgDB::ReaderWriter *readerWriter = osgDB::Registry::instance()->getReaderWriterForExtension(
+        osgDB::getLowerCaseFileExtension(fileName));
+
+    if (!readerWriter)
+        return result;
+
+    MemoryStreamBuffer buffer(data,size);
+    std::istream stream(&buffer);
+
+    osgDB::ReaderWriter::ReadResult readResult = readerWriter->readImage(stream);
+
+    if (readResult.validImage())
+        result = readResult.getImage();
+
+    return result;
+}
+
+/// Number of 8 bit channels of an image expandToRGBA(...) can read directly, 0 if it can't.
+
+static unsigned int byteChannels(const osg::Image *img)
+{
+    if (img->getDataType() != GL_UNSIGNED_BYTE)
+        return 0;
+
+    switch (img->getPixelFormat())
+    {
+        case GL_RGBA: return 4;
+        case GL_RGB: return 3;
+        case GL_LUMINANCE_ALPHA: return 2;
+        case GL_LUMINANCE: return 1;
+        default: return 0;
+    }
+}
+
+osg::ref_ptr<osg::Image> convertToRGBA(osg::Image *img)
 {
     osg::ref_ptr<osg::Image> dstImg = new osg::Image;
+    dstImg->allocateImage(img->s(),img->t(),1,GL_RGBA,GL_UNSIGNED_BYTE);
 
-    dstImg->allocateImage(img->s(),img->t(),1,GL_RGBA,GL_FLOAT);
+    const unsigned int channels = byteChannels(img);
 
     for (int y = 0; y < dstImg->t(); ++y)
-        for (int x = 0; x < dstImg->s(); ++x)
+    {
+        if (channels > 0)
         {
-            osg::Vec4f alphaPixel = alphaImg->getColor(x,y);
-            osg::Vec4f srcPixel = img->getColor(x,y);
+            expandToRGBA(img->data(0,y),channels,dstImg->data(0,y),dstImg->s());
+            continue;
+        }
 
-            dstImg->setColor(osg::Vec4f(srcPixel.x(),srcPixel.y(),srcPixel.z(),alphaPixel.x()),x,y);
+        for (int x = 0; x < dstImg->s(); ++x)     // other formats, slow
+        {
+            osg::Vec4f c = img->getColor(x,y) * 255.0f + osg::Vec4f(0.5,0.5,0.5,0.5);
+            unsigned char *p = dstImg->data(x,y);
+
+            for (int i = 0; i < 4; ++i)
+                p[i] = (unsigned char) std::max(0.0f,std::min(255.0f,c[i]));
         }
+    }
 
     return dstImg;
 }
 
-osg::ref_ptr<osg::Image> applyColorKey(osg::Image *img, osg::Vec3f color, float err)
+osg::ref_ptr<osg::Image> addAlphaFromImage(osg::Image *img, osg::Image *alphaImg)
 {
-    osg::ref_ptr<osg::Image> dstImg = new osg::Image;
+    osg::ref_ptr<osg::Image> dstImg = convertToRGBA(img);
 
-    dstImg->allocateImage(img->s(),img->t(),1,GL_RGBA,GL_FLOAT);
+    const unsigned int alphaChannels = byteChannels(alphaImg);
+    const int width = std::min(dstImg->s(),alphaImg->s());
+    const int height = std::min(dstImg->t(),alphaImg->t());   // beyond the alpha image the pixels stay as they are
 
-    for (int y = 0; y < dstImg->t(); ++y)
-        for (int x = 0; x < dstImg->s(); ++x)
+    for (int y = 0; y < height; ++y)
+    {
+        if (alphaChannels > 0)
         {
-            osg::Vec4f p = img->getColor(x,y);
+            setAlphaRGBA(dstImg->data(0,y),width,alphaImg->data(0,y),alphaChannels);
+            continue;
+        }
 
-            float alpha =
-                (std::abs(p.x() - color.x()) <= err && 
-                 std::abs(p.y() - color.y()) <= err &&
-                 std::abs(p.z() - color.z()) <= err) ? 0.0 : 1.0;
+        for (int x = 0; x < width; ++x)
+            dstImg->data(x,y)[3] = (unsigned char) std::max(0.0f,std::min(255.0f,alphaImg->getColor(x,y).x() * 255.0f + 0.5f));
+    }
 
-            dstImg->setColor(osg::Vec4f(p.x(),p.y(),p.z(),alpha),x,y);
-        }
+    return dstImg;
+}
+
+osg::ref_ptr<osg::Image> applyColorKey(osg::Image *img, osg::Vec3ub color, unsigned char tolerance)
+{
+    osg::ref_ptr<osg::Image> dstImg = convertToRGBA(img);
+
+    for (int y = 0; y < dstImg->t(); ++y)
+        applyColorKeyRGBA(dstImg->data(0,y),dstImg->s(),color.ptr(),tolerance);
 
     return dstImg;
 }
@@ -228,4 +290,30 @@ void AssignUserDataVisitor::apply(osg::Node &n)
     MFUtil::traverse(this,n);
 }
 
+void CountStateSetsVisitor::apply(osg::Node &n)
+{
+    auto count = [this](const osg::StateSet *stateSet)
+    {
+        if (stateSet)
+        {
+            mStateSets.insert(stateSet);
+            mUses++;
+        }
+    };
+
+    count(n.getStateSet());
+
+    osg::Geode *geode = n.asGeode();
+
+    if (geode)      // the drawables are counted here, so that they're not counted twice where OSG traverses them
+    {
+        for (unsigned int i = 0; i < geode->getNumDrawables(); ++i)
+            count(geode->getDrawable(i)->getStateSet());
+
+        return;
+    }
+
+    MFUtil::traverse(this,n);
+}
+
 }
@@ -2,12 +2,15 @@
 #define OSG_UTILS_H
 
 #include <fstream>
+#include <set>
 #include <osg/Transform>
 #include <osg/MatrixTransform>
 #include <osgUtil/IntersectionVisitor>
 #include <osgGA/FirstPersonManipulator>
 #include <math.h>
 #include <utils/openmf.hpp>
+#include <utils/pixels.hpp>
+#include <osg/Vec3ub>
 
 namespace MFUtil
 {
@@ -40,8 +43,21 @@ protected:
     std::string mClassName;
 };
 
+/** Decode an image file held in memory, the format is deduced from the file name extension. */
+
+osg::ref_ptr<osg::Image> readImage(std::string fileName, const char *data, size_t size);
+
+/** Copy an image to 8 bit RGBA, which the functions below produce. */
+
+osg::ref_ptr<osg::Image> convertToRGBA(osg::Image *img);
+
+/** Take the alpha of an image from the first channel of another image. */
+
 osg::ref_ptr<osg::Image> addAlphaFromImage(osg::Image *img, osg::Image *alphaImg);
-osg::ref_ptr<osg::Image> applyColorKey(osg::Image *img, osg::Vec3f color, float err=0.01);
+
+/** Make the pixels of given color transparent, tolerance is per channel. */
+
+osg::ref_ptr<osg::Image> applyColorKey(osg::Image *img, osg::Vec3ub color, unsigned char tolerance=3);
 
 /**
   This class is here because SkyboxNode caused segfaults when debug selecting. FIXME: fix
@@ -122,6 +138,24 @@ protected:
     osg::ref_ptr<UserData> mData;
 };
 
+/**
+  Counts the state sets of given node and all children (drawables included), to see how well they're shared.
+*/
+
+class CountStateSetsVisitor: public osg::NodeVisitor
+{
+public:
+    CountStateSetsVisitor(): osg::NodeVisitor() { mUses = 0; };
+    virtual void apply(osg::Node &n) override;
+
+    size_t getUniqueCount() const  { return mStateSets.size(); };
+    size_t getUseCount() const     { return mUses;             };    ///< nodes with a state set
+
+protected:
+    std::set<const osg::StateSet *> mStateSets;
+    size_t mUses;
+};
+
 }
 
 #endif
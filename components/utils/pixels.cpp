@@ -0,0 +1,135 @@
+#include <utils/pixels.hpp>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace MFUtil
+{
+
+void expandToRGBA(const uint8_t *src, unsigned int channels, uint8_t *dst, size_t count)
+{
+    switch (channels)
+    {
+        case 4:
+            memcpy(dst,src,count * 4);
+            break;
+
+        case 3:
+            for (size_t i = 0; i < count; ++i, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 255;
+            }
+
+            break;
+
+        case 2:
+            for (size_t i = 0; i < count; ++i, src += 2, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = src[1];
+            }
+
+            break;
+
+        default:
+            for (size_t i = 0; i < count; ++i, src += channels, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = 255;
+            }
+
+            break;
+    }
+}
+
+void applyColorKeyRGBA(uint8_t *pixels, size_t count, const uint8_t key[3], uint8_t tolerance)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // 4 pixels at once: |p - key| per byte as the saturated differences in both directions, a pixel
+    // is keyed when all its color bytes are within the tolerance
+
+    const __m128i keyVec = _mm_set1_epi32(key[0] | (key[1] << 8) | (key[2] << 16));
+    const __m128i toleranceVec = _mm_set1_epi8((char) tolerance);
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i * 4));
+        __m128i difference = _mm_or_si128(_mm_subs_epu8(p,keyVec),_mm_subs_epu8(keyVec,p));
+        __m128i outside = _mm_andnot_si128(alphaMask,_mm_subs_epu8(difference,toleranceVec));   // nonzero byte = out of tolerance
+        __m128i keyed = _mm_cmpeq_epi32(outside,zero);
+
+        p = _mm_or_si128(_mm_andnot_si128(alphaMask,p),_mm_andnot_si128(keyed,alphaMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + i * 4),p);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        uint8_t *p = pixels + i * 4;
+        bool keyed = true;
+
+        for (int c = 0; c < 3; ++c)
+            keyed = keyed && (p[c] > key[c] ? p[c] - key[c] : key[c] - p[c]) <= tolerance;
+
+        p[3] = keyed ? 0 : 255;
+    }
+}
+
+void setAlphaRGBA(uint8_t *pixels, size_t count, const uint8_t *alpha, unsigned int alphaChannels)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+
+    if (alphaChannels == 4)
+    {
+        const __m128i firstMask = _mm_set1_epi32(0x000000ff);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i * 4));
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(alpha + i * 4));
+
+            p = _mm_or_si128(_mm_and_si128(p,colorMask),_mm_slli_epi32(_mm_and_si128(a,firstMask),24));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + i * 4),p);
+        }
+    }
+    else if (alphaChannels == 1)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(alpha + i));
+            __m128i a16[2] = {_mm_unpacklo_epi8(zero,a),_mm_unpackhi_epi8(zero,a)};   // alpha in the high bytes
+
+            for (int h = 0; h < 2; ++h)
+            {
+                __m128i a32[2] = {_mm_unpacklo_epi16(zero,a16[h]),_mm_unpackhi_epi16(zero,a16[h])};
+
+                for (int q = 0; q < 2; ++q)
+                {
+                    uint8_t *dst = pixels + (i + h * 8 + q * 4) * 4;
+                    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),_mm_or_si128(_mm_and_si128(p,colorMask),a32[q]));
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+        pixels[i * 4 + 3] = alpha[i * alphaChannels];
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef PIXELS_H
+#define PIXELS_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+  Kernels working on rows of 8 bit per channel pixels, used to prepare textures. RGBA pixels are
+  4 bytes in the order R, G, B, A.
+*/
+
+namespace MFUtil
+{
+
+/// Converts count pixels of 1 (luminance), 2 (luminance, alpha), 3 (RGB) or 4 (RGBA) channels to RGBA.
+void expandToRGBA(const uint8_t *src, unsigned int channels, uint8_t *dst, size_t count);
+
+/// Makes RGBA pixels whose color differs from the key by at most tolerance in each channel transparent, the others opaque.
+void applyColorKeyRGBA(uint8_t *pixels, size_t count, const uint8_t key[3], uint8_t tolerance=0);
+
+/// Sets the alpha of RGBA pixels to the first channel of the alpha pixels, which have given number of channels.
+void setAlphaRGBA(uint8_t *pixels, size_t count, const uint8_t *alpha, unsigned int alphaChannels);
+
+}
+
+#endif
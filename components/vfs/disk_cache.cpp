@@ -0,0 +1,198 @@
+#include <vfs/disk_cache.hpp>
+#include <utils/logger.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#define DISKCACHE_MAGIC 0x43464d4f       // "OMFC"
+
+namespace MFFile
+{
+
+namespace fs = std::filesystem;
+
+DiskCache::DiskCache()
+{
+    mMaxSize = 0;
+    mSize = 0;
+    mHits = 0;
+    mMisses = 0;
+}
+
+bool DiskCache::open(std::string directory, uint64_t maxSize)
+{
+    std::error_code error;
+    fs::create_directories(directory,error);
+
+    if (!fs::is_directory(directory,error))
+    {
+        MFLogger::Logger::warn("Could not create cache directory " + directory + ".",DISKCACHE_MODULE_STR);
+        return false;
+    }
+
+    mDirectory = directory;
+    mMaxSize = maxSize;
+    mSize = 0;
+    mEntries.clear();
+
+    for (auto& file : fs::directory_iterator(directory,error))
+    {
+        if (!file.is_regular_file(error) || file.path().extension() == ".tmp")
+            continue;
+
+        Entry entry;
+        entry.mSize = file.file_size(error);
+        entry.mLastUse = file.last_write_time(error);
+
+        mEntries[file.path().filename().string()] = entry;
+        mSize += entry.mSize;
+    }
+
+    MFLogger::Logger::info("Using cache " + directory + " (" + std::to_string(mEntries.size()) + " entries, " + std::to_string(mSize / 1024) + " kB).",DISKCACHE_MODULE_STR);
+
+    evict();
+    return true;
+}
+
+std::string DiskCache::getFileName(const std::string &key) const
+{
+    uint64_t hash = 0xcbf29ce484222325;    // FNV-1a
+
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3;
+    }
+
+    char name[32];
+    snprintf(name,sizeof(name),"%016llx.bin",(unsigned long long) hash);
+    return name;
+}
+
+bool DiskCache::load(const std::string &key, std::vector<char> &data)
+{
+    if (!isOpen())
+        return false;
+
+    std::string fileName = getFileName(key);
+    auto it = mEntries.find(fileName);
+
+    if (it == mEntries.end())
+    {
+        mMisses++;
+        return false;
+    }
+
+    fs::path path = fs::path(mDirectory) / fileName;
+    std::ifstream f(path,std::ios::binary);
+
+    uint32_t magic = 0;
+    uint32_t keyLength = 0;
+    uint64_t size = 0;
+
+    f.read(reinterpret_cast<char *>(&magic),sizeof(magic));
+    f.read(reinterpret_cast<char *>(&keyLength),sizeof(keyLength));
+
+    std::string storedKey(f.good() && magic == DISKCACHE_MAGIC ? keyLength : 0,'\0');
+    f.read(&storedKey[0],storedKey.size());
+    f.read(reinterpret_cast<char *>(&size),sizeof(size));
+
+    if (!f.good() || magic != DISKCACHE_MAGIC || storedKey != key || it->second.mSize < size)
+    {
+        mMisses++;
+        return false;
+    }
+
+    data.resize(size);
+    f.read(data.data(),size);
+
+    if (!f.good())
+    {
+        mMisses++;
+        return false;
+    }
+
+    std::error_code error;
+    it->second.mLastUse = fs::file_time_type::clock::now();
+    fs::last_write_time(path,it->second.mLastUse,error);     // persist the LRU order
+
+    mHits++;
+    return true;
+}
+
+bool DiskCache::store(const std::string &key, const char *data, size_t size)
+{
+    if (!isOpen() || size > mMaxSize)
+        return false;
+
+    std::string fileName = getFileName(key);
+    fs::path path = fs::path(mDirectory) / fileName;
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+
+    std::ofstream f(tmpPath,std::ios::binary);
+
+    uint32_t magic = DISKCACHE_MAGIC;
+    uint32_t keyLength = key.length();
+    uint64_t dataSize = size;
+
+    f.write(reinterpret_cast<char *>(&magic),sizeof(magic));
+    f.write(reinterpret_cast<char *>(&keyLength),sizeof(keyLength));
+    f.write(key.data(),key.length());
+    f.write(reinterpret_cast<char *>(&dataSize),sizeof(dataSize));
+    f.write(data,size);
+    f.close();
+
+    std::error_code error;
+
+    if (!f.good())
+    {
+        fs::remove(tmpPath,error);
+        return false;
+    }
+
+    fs::rename(tmpPath,path,error);     // readers never see a half written entry
+
+    if (error)
+        return false;
+
+    auto it = mEntries.find(fileName);
+
+    if (it != mEntries.end())
+        mSize -= it->second.mSize;
+
+    Entry entry;
+    entry.mSize = sizeof(magic) + sizeof(keyLength) + key.length() + sizeof(dataSize) + size;
+    entry.mLastUse = fs::file_time_type::clock::now();
+
+    mEntries[fileName] = entry;
+    mSize += entry.mSize;
+
+    evict();
+    return true;
+}
+
+void DiskCache::evict()
+{
+    if (mSize <= mMaxSize)
+        return;
+
+    std::vector<std::pair<fs::file_time_type,std::string>> order;
+    order.reserve(mEntries.size());
+
+    for (const auto& entry : mEntries)
+        order.push_back(std::make_pair(entry.second.mLastUse,entry.first));
+
+    std::sort(order.begin(),order.end());
+
+    std::error_code error;
+
+    for (size_t i = 0; i < order.size() && mSize > mMaxSize; ++i)
+    {
+        fs::remove(fs::path(mDirectory) / order[i].second,error);
+        mSize -= mEntries[order[i].second].mSize;
+        mEntries.erase(order[i].second);
+    }
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef VFS_DISK_CACHE_H
+#define VFS_DISK_CACHE_H
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define DISKCACHE_MODULE_STR "disk cache"
+
+namespace MFFile
+{
+
+/**
+  Size-bounded on-disk cache of decoded files (e.g. decompressed DTA entries), so that warm starts
+  don't have to decode them again. Each entry is a file in the cache directory named by the hash of
+  its key, the key is stored inside too to rule out collisions. When the size limit is exceeded,
+  the least recently used entries (by file modification time, updated on every hit) are removed.
+*/
+
+class DiskCache
+{
+public:
+    DiskCache();
+    bool open(std::string directory, uint64_t maxSize);
+    bool isOpen() const                  { return mDirectory.length() > 0; }
+
+    bool load(const std::string &key, std::vector<char> &data);
+    bool store(const std::string &key, const char *data, size_t size);
+
+    uint64_t getSize() const             { return mSize;                   }
+    unsigned int getHits() const         { return mHits;                   }
+    unsigned int getMisses() const       { return mMisses;                 }
+
+protected:
+    typedef struct
+    {
+        uint64_t mSize;
+        std::filesystem::file_time_type mLastUse;
+    } Entry;
+
+    std::string getFileName(const std::string &key) const;
+    void evict();
+
+    std::string mDirectory;
+    uint64_t mMaxSize;
+    uint64_t mSize;
+    unsigned int mHits;
+    unsigned int mMisses;
+    std::unordered_map<std::string,Entry> mEntries;    ///< file name => entry
+};
+
+}
+
+#endif // VFS_DISK_CACHE_H
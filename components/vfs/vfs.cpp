@@ -1,9 +1,13 @@
 #include <vfs/vfs.hpp>
 #include <utils/openmf.hpp>
+#include <dta/key_extractor.hpp>
+#include <algorithm>
+#include <filesystem>
 
 #ifdef OMF_SYSTEM_LINUX
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/inotify.h>
 #include <pwd.h>
 #endif
 
@@ -12,27 +16,55 @@ namespace MFFile
     
 std::string convertPathToCanonical(std::string path)
 {
-    return MFUtil::strToLower(path);
+    path = MFUtil::strToLower(path);
+    std::replace(path.begin(),path.end(),'\\','/');    // DTA archives store paths with backslashes
+    return path;
+}
+
+static std::string makeAbsolutePath(const std::string &path)
+{
+    std::error_code error;
+    std::string result = std::filesystem::absolute(path,error).lexically_normal().generic_string();
+
+    if (result.length() > 1 && result.back() == '/')
+        result.pop_back();
+
+    return result;
 }
 
 FileSystem::FileSystem()
 {
+    mIndexDirty = true;
+    mIndexHits = 0;
+    mIndexMisses = 0;
+    mWatchFd = -1;
+    mNumArchivedFiles = 0;
+
     mSearchPaths.push_back("resources");
     mSearchPaths.push_back("mafia");
     
     char const *envMafiaDir = getenv(MAFIA_INSTALL_DIR); // TODO: Use Config for this.
     if (envMafiaDir)
-        mSearchPaths.push_back(envMafiaDir);
+        addPath(envMafiaDir);
 
     #if defined(OMF_SYSTEM_LINUX)
     struct passwd *pw = getpwuid(getuid());
     const char *dir = pw->pw_dir;
     std::string dirpath = std::string(dir) + "/";
+    mUserDir = dirpath + ".openmf";
     addPath(dirpath + ".openmf");
     addPath(dirpath + ".openmf/mafia");
     #endif
 }
 
+FileSystem::~FileSystem()
+{
+    #if defined(OMF_SYSTEM_LINUX)
+    if (mWatchFd >= 0)
+        close(mWatchFd);
+    #endif
+}
+
 void FileSystem::prependPath(std::string path)
 {
 	addPath(path, 0);
@@ -45,37 +77,225 @@ void FileSystem::addPath(std::string path)
 
 void FileSystem::addPath(std::string path, size_t index)
 {
-    if (path[path.length() - 1] == '/')
+    if (path.empty())
+        return;
+
+    if (path.back() == '/')
         path.erase(path.length() - 1,1);            
 
-	mSearchPaths.insert(mSearchPaths.begin() + index, path);
+    mSearchPaths.insert(mSearchPaths.begin() + index, path);
+    mIndexDirty = true;      // the index is rebuilt lazily on the next lookup
+}
+
+void FileSystem::excludeFromIndex(std::string directory)
+{
+    directory = makeAbsolutePath(directory);
+
+    if (std::find(mExcludedDirectories.begin(),mExcludedDirectories.end(),directory) != mExcludedDirectories.end())
+        return;
+
+    mExcludedDirectories.push_back(directory);
+
+    for (const auto& path : mSearchPaths)      // reindex the search paths that contain it
+        if (directory.compare(0,makeAbsolutePath(path).length() + 1,makeAbsolutePath(path) + "/") == 0)
+        {
+            mSearchPathIndices.erase(path);
+            mIndexDirty = true;
+        }
+}
+
+void FileSystem::indexSearchPath(const std::string &path)
+{
+    namespace fs = std::filesystem;
+
+    PathIndex &index = mSearchPathIndices[path];
+    index.clear();
+
+    // other search paths nested in this one are indexed on their own
+
+    std::vector<std::string> skipped = mExcludedDirectories;
+
+    for (const auto& otherPath : mSearchPaths)
+        if (otherPath != path)
+            skipped.push_back(makeAbsolutePath(otherPath));
+
+    std::error_code error;
+    fs::recursive_directory_iterator it(path,fs::directory_options::skip_permission_denied,error);
+
+    if (error)
+        return;              // non-existent search paths are fine
+
+    watchDirectory(path,path);
+
+    for (; it != fs::recursive_directory_iterator(); it.increment(error))
+    {
+        if (error)
+            break;
+
+        if (it->is_directory(error))
+        {
+            if (std::find(skipped.begin(),skipped.end(),makeAbsolutePath(it->path().string())) != skipped.end())
+                it.disable_recursion_pending();
+            else
+                watchDirectory(it->path().string(),path);
+
+            continue;
+        }
+
+        std::string relativePath = it->path().lexically_relative(path).generic_string();
+        index.emplace(convertPathToCanonical(relativePath),path + "/" + relativePath);
+    }
+}
+
+void FileSystem::rebuildIndex()
+{
+    mFileIndex.clear();
+
+    for (const auto& path : mSearchPaths)
+    {
+        if (mSearchPathIndices.find(path) == mSearchPathIndices.end())
+            indexSearchPath(path);
+
+        // emplace won't overwrite => earlier search paths take precedence
+        for (const auto& entry : mSearchPathIndices[path])
+            mFileIndex.emplace(entry.first,entry.second);
+    }
+
+    mIndexDirty = false;
+
+    MFLogger::Logger::info("Indexed " + std::to_string(mFileIndex.size()) + " files in " + std::to_string(mSearchPaths.size()) + " search paths.",VFS_MODULE_STR);
+}
+
+std::string FileSystem::findOnDisk(const std::string &canonicalName)
+{
+    if (mIndexDirty)
+        rebuildIndex();
+
+    auto it = mFileIndex.find(canonicalName);
+
+    if (it == mFileIndex.end() && processChanges())   // the file may have just been created
+        it = mFileIndex.find(canonicalName);
+
+    return it != mFileIndex.end() ? it->second : "";
 }
 
 std::string FileSystem::getFileLocation(const std::string& fileName)
 {
-    for (const auto& path : mSearchPaths)     // TODO: what's the fastest way to check a file existence?
+    std::string location = findOnDisk(convertPathToCanonical(fileName));
+    countLookUp(location.length() > 0);
+    return location;
+}
+
+bool FileSystem::setWatchChanges(bool enable)
+{
+    #if defined(OMF_SYSTEM_LINUX)
+    if (enable == (mWatchFd >= 0))
+        return true;
+
+    if (!enable)
     {
-        std::string realPath = path + "/";
-        realPath.append(fileName);
+        close(mWatchFd);
+        mWatchFd = -1;
+        mWatches.clear();
+        return true;
+    }
 
-        std::ifstream f;
-        f.open(realPath);
+    mWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (mWatchFd < 0)
+    {
+        MFLogger::Logger::warn("Could not initialize inotify, file changes won't be watched.",VFS_MODULE_STR);
+        return false;
+    }
+
+    mSearchPathIndices.clear();    // rescan to set up the watches
+    mIndexDirty = true;
+    return true;
+    #else
+    return !enable;
+    #endif
+}
+
+void FileSystem::watchDirectory(const std::string &directory, const std::string &searchPath)
+{
+    #if defined(OMF_SYSTEM_LINUX)
+    if (mWatchFd < 0)
+        return;
 
-        if (f.good())
+    int watch = inotify_add_watch(mWatchFd,directory.c_str(),IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF);
+
+    if (watch >= 0)
+        mWatches[watch] = searchPath;
+    #endif
+}
+
+bool FileSystem::processChanges()
+{
+    #if defined(OMF_SYSTEM_LINUX)
+    if (mWatchFd < 0)
+        return false;
+
+    alignas(inotify_event) char buffer[4096];
+    std::vector<std::string> changedPaths;
+    bool overflow = false;
+
+    while (true)
+    {
+        ssize_t length = ::read(mWatchFd,buffer,sizeof(buffer));
+
+        if (length <= 0)
+            break;
+
+        for (char *p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event *>(p)->len)
         {
-            f.close();
-            return realPath;
+            if (reinterpret_cast<inotify_event *>(p)->mask & IN_Q_OVERFLOW)
+                overflow = true;
+
+            auto it = mWatches.find(reinterpret_cast<inotify_event *>(p)->wd);
+
+            if (it != mWatches.end() && std::find(changedPaths.begin(),changedPaths.end(),it->second) == changedPaths.end())
+                changedPaths.push_back(it->second);
         }
     }
 
-    return "";
+    if (overflow)     // events were dropped, nothing tells which paths changed
+    {
+        MFLogger::Logger::info("Too many file changes, reindexing all search paths.",VFS_MODULE_STR);
+        mSearchPathIndices.clear();
+        rebuildIndex();
+        return true;
+    }
+
+    if (changedPaths.empty())
+        return false;
+
+    for (const auto& path : changedPaths)
+    {
+        MFLogger::Logger::info("Search path " + path + " changed, reindexing.",VFS_MODULE_STR);
+        indexSearchPath(path);
+    }
+
+    rebuildIndex();
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+void FileSystem::countLookUp(bool hit)
+{
+    if (hit)
+        mIndexHits++;
+    else
+        mIndexMisses++;
 }
 
 bool FileSystem::open(std::ifstream &file, std::string fileName, std::ios_base::openmode /*mode*/)
 {
     fileName = convertPathToCanonical(fileName);
 
-    std::string fileLocation = getFileLocation(fileName);    
+    std::string fileLocation = findOnDisk(fileName);
+    countLookUp(fileLocation.length() > 0);
 
     if (fileLocation.length() == 0)
     {
@@ -87,4 +307,280 @@ bool FileSystem::open(std::ifstream &file, std::string fileName, std::ios_base::
     return file.good();
 }
 
+bool FileSystem::findInArchives(const std::string &canonicalName, ArchiveEntry &entry)
+{
+    for (unsigned int i = 0; i < mArchives.size(); ++i)     // archives mounted earlier take precedence
+    {
+        int index = mArchives[i]->mDTA.getFileIndex(canonicalName);
+
+        if (index >= 0)
+        {
+            entry = ArchiveEntry {i,(unsigned int) index};
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FileSystem::exists(std::string fileName)
+{
+    fileName = convertPathToCanonical(fileName);
+    ArchiveEntry entry;
+    bool result = findOnDisk(fileName).length() > 0 || findInArchives(fileName,entry);
+    countLookUp(result);
+    return result;
+}
+
+uint64_t FileSystem::getTimeStamp(std::string fileName)
+{
+    fileName = convertPathToCanonical(fileName);
+
+    std::string fileLocation = findOnDisk(fileName);
+    ArchiveEntry entry;
+
+    if (fileLocation.length() > 0)
+    {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(fileLocation,error);
+        return error ? 0 : (uint64_t) time.time_since_epoch().count();
+    }
+
+    if (findInArchives(fileName,entry))
+        return mArchives[entry.mArchive]->mDTA.getFileTimeStamp(entry.mFileIndex);
+
+    return 0;
+}
+
+std::vector<bool> FileSystem::exists(const std::vector<std::string> &fileNames)
+{
+    std::vector<bool> result(fileNames.size(),false);
+    std::vector<std::string> missing;            // names not found on disk, resolved in the archives afterwards
+    std::vector<size_t> missingPositions;
+
+    for (size_t i = 0; i < fileNames.size(); ++i)
+    {
+        std::string fileName = convertPathToCanonical(fileNames[i]);
+
+        if (findOnDisk(fileName).length() > 0)
+        {
+            result[i] = true;
+            continue;
+        }
+
+        missing.push_back(fileName);
+        missingPositions.push_back(i);
+    }
+
+    for (const auto& archive : mArchives)       // in mount order, each pass only looks up the names still missing
+    {
+        if (missing.empty())
+            break;
+
+        std::vector<int> indices = archive->mDTA.getFileIndices(missing);
+        std::vector<std::string> stillMissing;
+        std::vector<size_t> stillMissingPositions;
+
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            if (indices[i] >= 0)
+            {
+                result[missingPositions[i]] = true;
+                continue;
+            }
+
+            stillMissing.push_back(missing[i]);
+            stillMissingPositions.push_back(missingPositions[i]);
+        }
+
+        missing.swap(stillMissing);
+        missingPositions.swap(stillMissingPositions);
+    }
+
+    for (size_t i = 0; i < result.size(); ++i)
+        countLookUp(result[i]);
+
+    return result;
+}
+
+bool FileSystem::read(std::string fileName, std::vector<char> &data)
+{
+    const char *fileData;
+    size_t fileSize;
+
+    if (!read(fileName,fileData,fileSize,data))
+        return false;
+
+    if (fileData != data.data())      // served from the mapping
+        data.assign(fileData,fileData + fileSize);
+
+    return true;
+}
+
+bool FileSystem::read(std::string fileName, const char *&data, size_t &size, std::vector<char> &storage)
+{
+    fileName = convertPathToCanonical(fileName);
+
+    std::string fileLocation = findOnDisk(fileName);
+    ArchiveEntry entry;
+    bool inArchive = fileLocation.length() == 0 && findInArchives(fileName,entry);
+
+    countLookUp(fileLocation.length() > 0 || inArchive);
+
+    if (fileLocation.length() > 0)
+    {
+        std::ifstream f;
+        f.open(fileLocation, std::ios::binary | std::ios::ate);
+
+        if (!f.good())
+            return false;
+
+        std::streamsize fileSize = f.tellg();
+        f.seekg(0,std::ios::beg);
+
+        storage.resize(fileSize);
+        f.read(storage.data(),fileSize);
+
+        data = storage.data();
+        size = storage.size();
+        return f.good();
+    }
+
+    if (!inArchive)
+    {
+        MFLogger::Logger::warn("Could not read file: " + fileName + ".",VFS_MODULE_STR);
+        return false;
+    }
+
+    Archive *archive = mArchives[entry.mArchive].get();
+
+    if (!archive->mMapping.isOpen())
+    {
+        storage.resize(archive->mDTA.getFileSize(entry.mFileIndex));
+        data = storage.data();
+        size = storage.size();
+
+        if (!archive->mDTA.getFile(archive->mStream,entry.mFileIndex,storage.data()))
+        {
+            MFLogger::Logger::warn("Corrupt archive data: " + fileName + ".",VFS_MODULE_STR);
+            return false;
+        }
+
+        return true;
+    }
+
+    size = archive->mDTA.getFileSize(entry.mFileIndex);
+    data = archive->mDTA.getFileView(archive->mMapping,entry.mFileIndex);
+
+    if (data)
+        return true;
+
+    // the archive path and the file's time stamp make sure a changed archive doesn't hit old entries
+    std::string cacheKey = archive->mPath + "|" + archive->mDTA.getFileName(entry.mFileIndex) + "|" +
+        std::to_string(archive->mDTA.getFileTimeStamp(entry.mFileIndex)) + "|" + std::to_string(size);
+
+    if (mDiskCache.load(cacheKey,storage) && storage.size() == size)
+    {
+        data = storage.data();
+        return true;
+    }
+
+    storage.resize(size);
+    data = storage.data();
+
+    if (!archive->mDTA.getFile(archive->mMapping,entry.mFileIndex,storage.data()))
+    {
+        MFLogger::Logger::warn("Corrupt archive data: " + fileName + ".",VFS_MODULE_STR);
+        return false;
+    }
+
+    mDiskCache.store(cacheKey,storage.data(),size);
+    return true;
+}
+
+bool FileSystem::enableDiskCache(std::string directory, uint64_t maxSize)
+{
+    if (directory.length() == 0)
+        directory = mUserDir.length() > 0 ? mUserDir + "/cache" : "cache";
+
+    excludeFromIndex(directory);
+    return mDiskCache.open(directory,maxSize);
+}
+
+bool FileSystem::mountArchive(std::string archiveName, uint32_t key1, uint32_t key2)
+{
+    std::string archiveLocation = findOnDisk(convertPathToCanonical(archiveName));
+
+    if (archiveLocation.length() == 0)
+        archiveLocation = archiveName;
+
+    std::unique_ptr<Archive> archive(new Archive);
+    archive->mPath = archiveLocation;
+    archive->mStream.open(archiveLocation,std::ios::binary);
+
+    if (!archive->mStream.good())
+    {
+        MFLogger::Logger::warn("Could not open archive: " + archiveName + ".",VFS_MODULE_STR);
+        return false;
+    }
+
+    archive->mDTA.setDecryptKeys(key1,key2);
+
+    if (!archive->mDTA.load(archive->mStream))
+    {
+        MFLogger::Logger::warn("Could not parse archive: " + archiveName + ".",VFS_MODULE_STR);
+        return false;
+    }
+
+    unsigned int numFiles = archive->mDTA.getNumFiles();
+    mNumArchivedFiles += numFiles;
+
+    std::error_code error;
+    std::string absolutePath = std::filesystem::absolute(archiveLocation,error).string();
+
+    if (!error)
+        archive->mPath = absolutePath;       // for cache keys
+
+    if (archive->mMapping.open(archiveLocation))
+        archive->mStream.close();           // all reads go through the mapping
+    else
+        MFLogger::Logger::warn("Could not map archive " + archiveName + ", reading it as a stream.",VFS_MODULE_STR);
+
+    MFLogger::Logger::info("Mounted archive " + archiveLocation + " (" + std::to_string(numFiles) + " files).",VFS_MODULE_STR);
+
+    mArchives.push_back(std::move(archive));
+    return true;
+}
+
+unsigned int FileSystem::mountArchives(std::string gameExecutable)
+{
+    std::ifstream exeFile;
+
+    if (!open(exeFile,gameExecutable))
+        return 0;
+
+    MFFormat::DataFormatDTAKeyExtrator keyExtractor;
+
+    if (!keyExtractor.load(exeFile))
+    {
+        MFLogger::Logger::warn("Could not extract DTA keys from " + gameExecutable + ".",VFS_MODULE_STR);
+        return 0;
+    }
+
+    exeFile.close();
+
+    unsigned int mounted = 0;
+
+    for (auto dtaFile : keyExtractor.getFiles())
+    {
+        if (findOnDisk(convertPathToCanonical(dtaFile.mFileName)).length() == 0)
+            continue;
+
+        if (mountArchive(dtaFile.mFileName,dtaFile.mFileKey1,dtaFile.mFileKey2))
+            mounted++;
+    }
+
+    return mounted;
+}
+
 }
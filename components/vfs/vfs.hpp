@@ -2,11 +2,14 @@
 #define VFS_H
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <utils/os_defines.hpp>
 #include <dta/parser_dta.hpp>
+#include <vfs/disk_cache.hpp>
 
 #include <utils/logger.hpp>
 
@@ -21,12 +24,15 @@ std::string convertPathToCanonical(std::string path);
 /**
     Meyers Singleton class that encapsulating working with files. Hides platform-dependant
     FS details and whether a file is inside DTA or on actual HDD.
+
+    Files on disk (in search paths) always take precedence over files inside mounted DTA
+    archives, so that extracted or modded files override the original data.
 */
 
 class FileSystem
 {
 public:
-    ~FileSystem() {}
+    ~FileSystem();
 
     static FileSystem *getInstance()
     {
@@ -35,19 +41,111 @@ public:
     }
 
     bool open(std::ifstream &file, std::string fileName, std::ios_base::openmode mode = std::ios::binary);
-    std::string getFileLocation(const std::string& fileName);
+    std::string getFileLocation(const std::string& fileName);     ///< Returns the real path of a file on disk, empty string if not found.
+
+    /**
+      Reads the whole file into given buffer, either from disk or from a mounted DTA archive
+      (decrypted and decompressed in memory, no temporary files are created).
+    */
+    bool read(std::string fileName, std::vector<char> &data);
+
+    /**
+      Like read(...) above, but files stored uncompressed and unencrypted in a memory mapped archive
+      aren't copied: data then points into the mapping (valid while the archive stays mounted),
+      otherwise it points into storage.
+    */
+    bool read(std::string fileName, const char *&data, size_t &size, std::vector<char> &storage);
+    bool exists(std::string fileName);
+    uint64_t getTimeStamp(std::string fileName);   ///< Modification time of a file on disk or the time stored in the archive, 0 if not found.
+    std::vector<bool> exists(const std::vector<std::string> &fileNames);   ///< Resolves a whole batch of names at once.
+
+    /**
+      Mounts given DTA archive (a path relative to the search paths, or an absolute one) so that
+      its files can be accessed with read(...).
+    */
+    bool mountArchive(std::string archiveName, uint32_t key1, uint32_t key2);
+
+    /**
+      Extracts the DTA keys from given game executable and mounts all the archives it knows about
+      that can be found in the search paths. Returns the number of mounted archives.
+    */
+    unsigned int mountArchives(std::string gameExecutable = "game.exe");
+    size_t getNumArchives()                                  { return mArchives.size();     }
+    size_t getNumArchivedFiles()                             { return mNumArchivedFiles;    }
+
+    /**
+      Makes files decoded from the archives be stored in given directory (~/.openmf/cache on Linux
+      and "cache" elsewhere by default) so that they don't have to be decoded again next time.
+    */
+    bool enableDiskCache(std::string directory = "", uint64_t maxSize = 512 * 1024 * 1024);
+    DiskCache *getDiskCache()                                { return &mDiskCache;          }
+
+    /**
+      Lookups go through an in-memory index of all files in the search paths (built on the first
+      lookup after the paths change), so they don't touch the disk. For development setups where
+      the data change while running, the index can be kept up to date with inotify (Linux only).
+    */
+    bool setWatchChanges(bool enable);
+
+    /**
+      Keeps given directory (and everything in it) out of the index, for directories inside the search
+      paths that the game writes to itself, like the disk cache or the baked data.
+    */
+    void excludeFromIndex(std::string directory);
+    unsigned int getIndexHits()                              { return mIndexHits;           }
+    unsigned int getIndexMisses()                            { return mIndexMisses;         }
 
     void                     addPath(std::string path);
     void                     prependPath(std::string path);
     size_t                   getNumPaths()                   { return mSearchPaths.size(); }
     std::vector<std::string> getPaths()          const       { return mSearchPaths;        }
+    std::string              getUserDir()        const       { return mUserDir;            }
 
 private:
     FileSystem();                             // hide the constructor
     FileSystem(FileSystem const&);            // hide the copy constructor
     FileSystem& operator=(FileSystem const&); // hide the assign operator
     void addPath(std::string path, size_t index);
+
+    typedef std::unordered_map<std::string,std::string> PathIndex;   ///< canonical file name => real path
+
+    void indexSearchPath(const std::string &path);
+    void rebuildIndex();
+    std::string findOnDisk(const std::string &canonicalName);
+    void countLookUp(bool hit);
+    void watchDirectory(const std::string &directory, const std::string &searchPath);
+    bool processChanges();
+
+    typedef struct
+    {
+        std::string mPath;
+        std::ifstream mStream;                // only used if the archive couldn't be mapped
+        MFUtil::MappedFile mMapping;
+        MFFormat::DataFormatDTA mDTA;
+    } Archive;
+
+    typedef struct
+    {
+        unsigned int mArchive;                // index to mArchives
+        unsigned int mFileIndex;              // file index within the archive
+    } ArchiveEntry;
+
+    bool findInArchives(const std::string &canonicalName, ArchiveEntry &entry);
+
     std::vector<std::string> mSearchPaths;
+    std::unordered_map<std::string,PathIndex> mSearchPathIndices;  ///< search path => files in it
+    PathIndex mFileIndex;                                           ///< merged index, respects the search path order
+    bool mIndexDirty;
+    unsigned int mIndexHits;
+    unsigned int mIndexMisses;
+
+    int mWatchFd;                                                   ///< inotify descriptor, -1 if not watching
+    std::unordered_map<int,std::string> mWatches;                   ///< watch descriptor => search path
+    std::vector<std::string> mExcludedDirectories;                  ///< absolute paths
+    std::vector<std::unique_ptr<Archive>> mArchives;
+    unsigned int mNumArchivedFiles;
+    DiskCache mDiskCache;
+    std::string mUserDir;                                           ///< ~/.openmf on Linux, empty elsewhere
 };
 
 }
@@ -6,6 +6,13 @@
 
 #include <utils/math.hpp>
 #include <engine/engine.hpp>
+#include <dta/parser_dta.hpp>
+#include <5ds/parser_5ds.hpp>
+#include <5ds/animation.hpp>
+#include <4ds/morph.hpp>
+#include <4ds/skin.hpp>
+#include <utils/pixels.hpp>
+#include <dds/parser_dds.hpp>
 
 bool testMath()
 {
@@ -22,6 +29,245 @@ bool testMath()
     return getNumErrors() == 0;
 }
 
+bool testDTA()
+{
+    printSubHeader("DTA");
+
+    const unsigned char block[] =
+    {
+        0x00,0x00,'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f',   // 16 literals
+        0xe0,0x00,                                                                   // 3 references follow
+        0x01,0x0f,                                                                   // offset 16, 18 bytes
+        0x00,0x00,0x04,'x',                                                          // 20 times 'x'
+        0x00,0x10                                                                    // offset 1, 3 bytes
+    };
+
+    const std::string expected = "0123456789abcdef0123456789abcdef01" + std::string(23,'x');
+
+    MFFormat::DataFormatDTA dta;
+    std::vector<unsigned char> reference = dta.decompressLZSS(block,sizeof(block));
+    ass(std::string(reference.begin(),reference.end()) == expected);
+
+    std::vector<unsigned char> dst(expected.size());
+    int written = MFFormat::DataFormatDTA::decompressLZSS(block,sizeof(block),dst.data(),dst.size());
+    ass(written == (int) expected.size() && std::string(dst.begin(),dst.end()) == expected);
+
+    message("Corrupt blocks.");
+    ass(MFFormat::DataFormatDTA::decompressLZSS(block,sizeof(block),dst.data(),dst.size() - 1) < 0);   // doesn't fit
+    ass(MFFormat::DataFormatDTA::decompressLZSS(block,sizeof(block) - 1,dst.data(),dst.size()) < 0);   // truncated
+
+    const unsigned char badOffset[] = {0x80,0x00,0x01,0x0f};                                      // refers before the start
+    ass(MFFormat::DataFormatDTA::decompressLZSS(badOffset,sizeof(badOffset),dst.data(),dst.size()) < 0);
+
+    message("Decryption.");
+    dta.setDecryptKeys(0x12345678,0x9abcdef0);
+    uint32_t keys[2] = {0x12345678 ^ 0x39475694, 0x9abcdef0 ^ 0x34985762};
+    const unsigned char *keyBytes = reinterpret_cast<unsigned char *>(keys);
+    bool decryptOK = true;
+
+    for (unsigned int length = 0; length < 100; length += 7)
+        for (unsigned int shift = 0; shift < 10; ++shift)
+        {
+            std::vector<char> data(length);
+
+            for (unsigned int i = 0; i < length; ++i)
+                data[i] = (char) (i * 31);
+
+            dta.decrypt(data.data(),length,shift);
+
+            for (unsigned int i = 0; i < length; ++i)
+                decryptOK = decryptOK && data[i] == (char) ((i * 31) ^ keyBytes[(i + shift) % 8]);
+        }
+
+    ass(decryptOK);
+
+    return getNumErrors() == 0;
+}
+
+bool testBinaryReader()
+{
+    printSubHeader("Binary reader");
+
+    const char data[] = "\x01\x00\x00\x00name\0tail";
+    MFFormat::BinaryReader reader(data,sizeof(data) - 1);
+
+    uint32_t value = 0;
+    std::string str;
+    ass(reader.read((char *) &value,sizeof(value)) && value == 1);
+    ass(reader.readString(str) && str == "name" && reader.tellg() == 9);
+
+    message("Reading past the end.");
+    uint64_t value2 = 1;
+    ass(!reader.read((char *) &value2,sizeof(value2)) && value2 == 1); // destination untouched
+    ass(!reader.good() && reader.tellg() == -1);
+    ass(!reader.read((char *) &value,1));                              // stays failed
+
+    MFFormat::BinaryReader reader2(data,sizeof(data) - 1);
+    reader2.seekg(10);
+    ass(!reader2.readString(str));                                     // unterminated
+
+    message("String pool.");
+    MFFormat::StringPool pool;
+    auto s1 = pool.intern("model.i3d",5,".4ds");
+    auto s2 = pool.intern("model.4ds",9);
+    MFFormat::StringPool::String found;
+    ass(pool.getString(s1) == "model.4ds" && s1.mOffset == s2.mOffset);    // stored once
+    ass(pool.find("model.4ds",9,found) && found.mOffset == s1.mOffset);
+    ass(!pool.find("model",5,found));
+    ass(pool.getString(MFFormat::StringPool::String {0,0}).empty());
+
+    message("Truncated file.");
+    std::vector<char> truncated5DS(22,0);                              // header + description, no objects
+    truncated5DS[0] = '5'; truncated5DS[1] = 'D'; truncated5DS[2] = 'S';
+    truncated5DS[18] = 100;                                            // animated objects
+    truncated5DS[20] = 10;                                             // frames
+
+    MFFormat::DataFormat5DS animation;
+    ass(!animation.load(truncated5DS.data(),truncated5DS.size()));
+    ass(animation.getTotalFrameCount() == 10);
+
+    return getNumErrors() == 0;
+}
+
+bool testAnimation()
+{
+    printSubHeader("Animation");
+
+    message("Sample a clip.");
+    std::vector<char> data(22,0);
+    data[0] = '5'; data[1] = 'D'; data[2] = 'S';
+    data[18] = 1;                                                      // animated objects
+    data[20] = 50;                                                     // frames
+
+    auto append = [&data](const void *value, size_t size)
+    {
+        data.insert(data.end(),(const char *) value,(const char *) value + size);
+    };
+
+    uint32_t pointers[2] = {12,16};                                    // name, data (from the description)
+    uint32_t type = MFFormat::DataFormat5DS::SEQUENCE_MOVEMENT;
+    uint16_t keys[4] = {3,0,25,50};                                    // key count, frames
+    float movements[9] = {0,0,0, 1,2,3, 0,0,0};
+
+    append(pointers,sizeof(pointers));
+    append("obj",4);
+    append(&type,sizeof(type));
+    append(keys,sizeof(keys));
+    append(movements,sizeof(movements));
+
+    MFFormat::DataFormat5DS animation;
+    ass(animation.load(data.data(),data.size()));
+    ass(animation.getNumSequences() == 1 && animation.getString(animation.getSequence(0).mName) == "obj");
+
+    MFFormat::AnimationClip clip;
+    clip.build(animation);
+    ass(std::abs(clip.getDuration() - 2.0) < 0.001);
+
+    MFFormat::AnimationBatch batch;
+    auto id = batch.play(&clip,false);
+    batch.advance(0.5);                                                // frame 12.5, halfway to the second key
+    auto position = batch.getPosition(batch.getFirstSlot(id));
+    ass(std::abs(position.x - 0.5) < 0.001 && std::abs(position.y - 1.5) < 0.001 && std::abs(position.z - 1.0) < 0.001);   // y and z swapped
+
+    batch.stop(id);
+    ass(!batch.isPlaying(id) && batch.getNumSlots() == 0);
+
+    message("Morph a mesh.");
+    float frames[2][6] = {{1,1,1, 0,0,1},{3,3,3, 0,0,1}};              // 2 frames of 2 vertices
+    float normals[2][6] = {{1,0,0, 0,1,0},{0,1,0, 0,1,0}};
+    uint16_t links[2] = {2,0};
+    float positions[9] = {0,0,0, 5,5,5, 0,0,0};
+    float outNormals[9] = {};
+
+    MFFormat::MorphBatch morphs;
+    auto morphId = morphs.play(MFFormat::MorphBatch::Target {2,2,frames[0],normals[0],links},positions,outNormals);
+    morphs.setTime(morphId,0.5f / MFFormat::MorphBatch::FRAMES_PER_SECOND);   // halfway between the frames
+    ass(morphs.apply(morphs.getIndex(morphId)) && !morphs.apply(morphs.getIndex(morphId)));
+    ass(std::abs(positions[6] - 2) < 0.001 && std::abs(positions[8] - 2) < 0.001 && positions[2] == 1 && positions[3] == 5);    // unlinked vertex untouched
+    ass(std::abs(outNormals[6] - outNormals[7]) < 0.001 && std::abs(outNormals[6] - 0.7071) < 0.001);
+
+    message("Skin a mesh.");
+    float bindPositions[6] = {1,0,0, 1,0,0};
+    float bindNormals[6] = {0,1,0, 0,1,0};
+    MFFormat::SkinBatch::Influence influences[2] = {{{0,0},1},{{0,1},0.5f}};   // second vertex half on joint 1 (identity)
+    float skinned[6] = {};
+    float skinnedNormals[6] = {};
+
+    float skinned2[6] = {};
+    float skinnedNormals2[6] = {};
+
+    MFFormat::SkinBatch skins;
+    skins.setNumThreads(2);
+    auto skinId = skins.add(MFFormat::SkinBatch::Skin {2,1,bindPositions,bindNormals,influences},skinned,skinnedNormals);
+    auto skinId2 = skins.add(MFFormat::SkinBatch::Skin {2,1,bindPositions,bindNormals,influences},skinned2,skinnedNormals2);
+    skins.getPalette(skins.getIndex(skinId))[12] = 2;                   // joint 0 moves by 2 along X
+
+    for (int i = 0; i < 2; ++i)                                         // the threads are reused
+        skins.skin(std::vector<uint32_t>{(uint32_t) skins.getIndex(skinId),(uint32_t) skins.getIndex(skinId2)});
+
+    ass(skinned[0] == 3 && skinned[3] == 2 && skinned[1] == 0 && skinnedNormals[4] == 1);
+    ass(skinned2[0] == 1 && skinned2[3] == 1);
+
+    return getNumErrors() == 0;
+}
+
+bool testTextures()
+{
+    printSubHeader("Textures");
+
+    message("Color key pixels.");
+    const size_t pixelCount = 19;          // the SIMD loops (up to 16 pixels at once) and the scalar tail
+    uint8_t rgb[pixelCount * 3];
+    uint8_t rgba[pixelCount * 4];
+    uint8_t key[3] = {10,20,30};
+
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        bool keyed = i == 0 || i == 3 || i == 15 || i == 16 || i == 18;
+        rgb[i * 3] = keyed ? (i == 3 ? 12 : 10) : 10;                 // within the tolerance
+        rgb[i * 3 + 1] = 20;
+        rgb[i * 3 + 2] = keyed ? 30 : 40 + i;
+    }
+
+    MFUtil::expandToRGBA(rgb,3,rgba,pixelCount);
+    MFUtil::applyColorKeyRGBA(rgba,pixelCount,key,2);
+
+    ass(rgba[0 * 4 + 3] == 0 && rgba[3 * 4 + 3] == 0 && rgba[1 * 4 + 3] == 255 && rgba[3 * 4] == 12);
+    ass(rgba[14 * 4 + 3] == 255 && rgba[15 * 4 + 3] == 0 && rgba[16 * 4 + 3] == 0 && rgba[17 * 4 + 3] == 255 && rgba[18 * 4 + 3] == 0);
+
+    message("Merge alpha.");
+    uint8_t alpha[pixelCount * 4];
+
+    for (size_t i = 0; i < pixelCount * 4; ++i)
+        alpha[i] = i + 1;
+
+    MFUtil::setAlphaRGBA(rgba,pixelCount,alpha,1);
+    ass(rgba[3] == 1 && rgba[15 * 4 + 3] == 16 && rgba[16 * 4 + 3] == 17 && rgba[18 * 4 + 3] == 19 && rgba[16 * 4 + 2] == 30);
+
+    MFUtil::setAlphaRGBA(rgba,pixelCount,alpha,4);                  // the first channel of each alpha pixel
+    ass(rgba[3] == 1 && rgba[15 * 4 + 3] == 61 && rgba[16 * 4 + 3] == 65 && rgba[18 * 4 + 3] == 73 && rgba[17 * 4 + 2] == 57);
+
+    message("Compress a texture.");
+    std::vector<uint8_t> image(6 * 5 * 4);
+
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = i % 4 == 3 ? ((i / 4) % 2) * 255 : (i / 4) * 8 + (i % 4) * 20;    // keyed alpha
+
+    MFFormat::DataFormatDDS dds;
+    std::vector<uint8_t> decompressed;
+    ass(dds.compress(image.data(),6,5) && dds.getFormat() == MFFormat::DataFormatDDS::FORMAT_BC3 && dds.getNumLevels() == 3);
+    ass(dds.decompress(0,decompressed) && decompressed.size() == image.size());
+
+    int maxError = 0;
+
+    for (size_t i = 0; i < image.size(); ++i)
+        maxError = std::max(maxError,std::abs(image[i] - decompressed[i]) * (i % 4 == 3 ? 100 : 1));   // alpha has to be exact
+
+    ass(maxError < 64);
+
+    return getNumErrors() == 0;
+}
+
 bool testEngine()
 {
     printSubHeader("Engine");
@@ -72,6 +318,10 @@ int main()
     printHeader("OPENMF TEST SUITE");   
 
     testMath();
+    testDTA();
+    testBinaryReader();
+    testAnimation();
+    testTextures();
     testEngine();
 
     printHeader("TEST RESULTS");